@@ -0,0 +1,316 @@
+#include "background_qos.hpp"
+#include "subprocess.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include <cerrno>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace BackgroundQos {
+
+namespace {
+
+// What one pass managed to change
+struct Applied {
+    size_t threads = 0;
+    size_t children = 0;
+    bool cpuIdle = false;      // SCHED_IDLE (or the platform's equivalent)
+    bool cpuNiced = false;     // Only nice 19
+    bool cpuRefused = false;   // Left as it was
+    bool ioRefused = false;
+};
+
+std::atomic<bool> g_desired{false};
+std::atomic<bool> g_active{false};
+std::atomic<bool> g_toggle{false};  // Set by SIGUSR1
+
+std::mutex g_mutex;
+std::condition_variable g_wake;
+bool g_stopping = false;
+std::thread g_controller;
+
+#ifdef __linux__
+
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioClassNone = 0;
+constexpr int kIoprioClassIdle = 3;
+
+int g_originalNice = 0;
+
+bool setIoPriority(long tid, bool background) {
+    int value = (background ? kIoprioClassIdle : kIoprioClassNone) << kIoprioClassShift;
+    return syscall(SYS_ioprio_set, kIoprioWhoProcess, static_cast<int>(tid), value) == 0;
+}
+
+// Scheduling policy and nice value are per thread on Linux
+void setCpuPriority(long tid, bool background, Applied& applied) {
+    pid_t id = static_cast<pid_t>(tid);
+    sched_param param{};
+    if (background) {
+        if (sched_getscheduler(id) == SCHED_IDLE || sched_setscheduler(id, SCHED_IDLE, &param) == 0) {
+            applied.cpuIdle = true;
+        } else if (setpriority(PRIO_PROCESS, id, 19) == 0) {
+            applied.cpuNiced = true;
+        } else {
+            applied.cpuRefused = true;
+        }
+        return;
+    }
+    // Both steps back need CAP_SYS_NICE or a permissive RLIMIT_NICE
+    if (sched_getscheduler(id) == SCHED_IDLE && sched_setscheduler(id, SCHED_OTHER, &param) != 0) {
+        applied.cpuRefused = true;
+    }
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, id);
+    if (errno == 0 && nice > g_originalNice && setpriority(PRIO_PROCESS, id, g_originalNice) != 0) {
+        applied.cpuRefused = true;
+    }
+}
+
+// Every thread of a process (7z is multithreaded too)
+size_t applyToProcess(const std::string& pid, bool background, Applied& applied) {
+    std::error_code ec;
+    size_t threads = 0;
+    for (fs::directory_iterator it("/proc/" + pid + "/task", ec), end; !ec && it != end;
+         it.increment(ec)) {
+        long tid = std::strtol(it->path().filename().c_str(), nullptr, 10);
+        if (tid <= 0) continue;
+        if (!setIoPriority(tid, background)) applied.ioRefused = true;
+        setCpuPriority(tid, background, applied);
+        threads++;
+    }
+    return threads;
+}
+
+// Threads started since the last pass inherit the setting from whoever
+// started them, but anything that raced a switch is caught here
+Applied apply(bool background, bool) {
+    Applied applied;
+    applied.threads = applyToProcess("self", background, applied);
+    for (long child : Subprocess::running()) {
+        if (applyToProcess(std::to_string(child), background, applied) > 0) applied.children++;
+    }
+    return applied;
+}
+
+#elif defined(_WIN32)
+
+// The background processing mode can only be set by a process on itself,
+// and fails if asked for the mode it's already in, hence `changed`
+Applied apply(bool background, bool changed) {
+    Applied applied;
+    if (changed) {
+        DWORD mode = background ? PROCESS_MODE_BACKGROUND_BEGIN : PROCESS_MODE_BACKGROUND_END;
+        if (SetPriorityClass(GetCurrentProcess(), mode)) {
+            applied.cpuIdle = background;
+        } else {
+            applied.cpuRefused = applied.ioRefused = true;
+        }
+    }
+    DWORD wanted = background ? IDLE_PRIORITY_CLASS : NORMAL_PRIORITY_CLASS;
+    for (long child : Subprocess::running()) {
+        HANDLE process = OpenProcess(PROCESS_SET_INFORMATION | PROCESS_QUERY_LIMITED_INFORMATION,
+                                     FALSE, static_cast<DWORD>(child));
+        if (!process) continue;
+        if (GetPriorityClass(process) == wanted || SetPriorityClass(process, wanted)) {
+            applied.children++;
+        }
+        CloseHandle(process);
+    }
+    return applied;
+}
+
+#else
+
+// PRIO_DARWIN_BG: low CPU priority plus throttled disk and network I/O
+Applied apply(bool background, bool) {
+    Applied applied;
+#ifdef PRIO_DARWIN_BG
+    int value = background ? PRIO_DARWIN_BG : 0;
+    if (setpriority(PRIO_DARWIN_PROCESS, 0, value) == 0) {
+        applied.cpuIdle = background;
+    } else {
+        applied.cpuRefused = applied.ioRefused = true;
+    }
+    for (long child : Subprocess::running()) {
+        if (setpriority(PRIO_DARWIN_PROCESS, static_cast<pid_t>(child), value) == 0) {
+            applied.children++;
+        }
+    }
+#else
+    applied.cpuRefused = applied.ioRefused = background;
+#endif
+    return applied;
+}
+
+#endif
+
+std::string describe(bool background, const Applied& applied) {
+    std::string detail;
+    if (background) {
+        if (applied.cpuIdle) detail = "idle CPU priority";
+        else if (applied.cpuNiced) detail = "low CPU priority (nice 19)";
+        else detail = "CPU priority unchanged";
+        detail += applied.ioRefused ? ", I/O priority unchanged" : ", idle I/O priority";
+    } else {
+        detail = applied.ioRefused ? "I/O priority unchanged" : "normal I/O priority";
+        detail += applied.cpuRefused ? ", CPU priority stays low (raising it needs CAP_SYS_NICE)"
+                                     : ", normal CPU priority";
+    }
+    if (applied.children > 0) {
+        detail += " (also " + std::to_string(applied.children) + " running 7z process" +
+                  (applied.children == 1 ? ")" : "es)");
+    }
+    return detail;
+}
+
+bool parseMode(const std::string& text, bool& background) {
+    std::string word;
+    for (char c : text) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            if (!word.empty()) break;
+            continue;
+        }
+        word.push_back(static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c));
+    }
+    if (word == "background" || word == "on" || word == "1") {
+        background = true;
+    } else if (word == "normal" || word == "off" || word == "0") {
+        background = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void writeControlFile(const fs::path& file, bool background, fs::file_time_type& seen) {
+    {
+        std::ofstream out(file, std::ios::trunc);
+        out << (background ? "background" : "normal") << '\n';
+    }
+    std::error_code ec;
+    seen = fs::last_write_time(file, ec);
+}
+
+// Mode in the control file if it was changed since `seen`
+bool readControlFile(const fs::path& file, fs::file_time_type& seen, bool& background) {
+    std::error_code ec;
+    fs::file_time_type modified = fs::last_write_time(file, ec);
+    if (ec || modified == seen) return false;
+    seen = modified;
+    std::ifstream in(file);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return parseMode(text, background);
+}
+
+#ifndef _WIN32
+extern "C" void onToggleSignal(int) {
+    g_toggle = true;
+}
+#endif
+
+void controllerLoop(fs::path controlFile, ChangeHandler onChange) {
+    fs::file_time_type seen;
+    bool applied = g_active;
+    writeControlFile(controlFile, applied, seen);
+
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while (!g_stopping) {
+        g_wake.wait_for(lock, std::chrono::milliseconds(500));
+        if (g_stopping) break;
+        lock.unlock();
+
+        bool fromFile = false;
+        if (readControlFile(controlFile, seen, fromFile)) g_desired = fromFile;
+        if (g_toggle.exchange(false)) g_desired = !g_desired;
+
+        bool wanted = g_desired;
+        if (wanted != applied) {
+            Applied result = apply(wanted, true);
+            applied = wanted;
+            g_active = wanted;
+            writeControlFile(controlFile, wanted, seen);
+            if (onChange) onChange(wanted, describe(wanted, result));
+        } else if (applied) {
+            apply(true, false);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace
+
+void start(bool background, const fs::path& controlFile, ChangeHandler onChange) {
+#ifdef __linux__
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, 0);
+    if (errno == 0) g_originalNice = nice;
+#endif
+    g_desired = background;
+    if (background) {
+        Applied result = apply(true, true);
+        g_active = true;
+        if (onChange) onChange(true, describe(true, result));
+    }
+
+#ifndef _WIN32
+    struct sigaction action {};
+    action.sa_handler = onToggleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, nullptr);
+#endif
+
+    static bool stopAtExit = (std::atexit(stop), true);
+    (void)stopAtExit;
+
+    std::error_code ec;
+    fs::create_directories(controlFile.parent_path(), ec);
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stopping = false;
+    }
+    g_controller = std::thread(controllerLoop, controlFile, std::move(onChange));
+}
+
+void stop() {
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_stopping = true;
+    }
+    g_wake.notify_all();
+    if (g_controller.joinable()) g_controller.join();
+}
+
+void setBackground(bool background) {
+    g_desired = background;
+    g_wake.notify_all();
+}
+
+bool active() {
+    return g_active;
+}
+
+} // namespace BackgroundQos
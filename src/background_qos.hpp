@@ -0,0 +1,39 @@
+#pragma once
+
+// Background mode (--background): run the install on spare capacity only,
+// so the machine stays usable while it works.
+//
+// The whole process (every thread, including ones started later) and the
+// 7z processes it runs get idle CPU and I/O priority:
+//   Linux    SCHED_IDLE (nice 19 if that's refused) and the idle I/O class
+//   macOS    PRIO_DARWIN_BG, which throttles both CPU and I/O
+//   Windows  PROCESS_MODE_BACKGROUND for us, IDLE_PRIORITY_CLASS for 7z
+//
+// It can be switched during a run by writing "background" or "normal" to
+// a control file, or (POSIX) with SIGUSR1, which toggles it. Going back to
+// normal CPU scheduling on Linux needs CAP_SYS_NICE or a RLIMIT_NICE that
+// allows it; without that only I/O priority is restored.
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace BackgroundQos {
+
+// Called from the controller thread whenever the mode changes, with a
+// short description of what was applied (or couldn't be)
+using ChangeHandler = std::function<void(bool background, const std::string& detail)>;
+
+// Start the controller: applies the initial mode and then watches
+// controlFile and SIGUSR1 for changes until stop()
+void start(bool background, const fs::path& controlFile, ChangeHandler onChange);
+void stop();
+
+// Switch now (from any thread)
+void setBackground(bool background);
+
+bool active();
+
+} // namespace BackgroundQos
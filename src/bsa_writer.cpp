@@ -0,0 +1,420 @@
+#include "bsa_writer.hpp"
+#include "case_fold.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#ifdef NEXUSBRIDGE_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace BsaWriter {
+
+namespace {
+
+// Archive flags
+constexpr uint32_t kIncludeDirectoryNames = 0x1;
+constexpr uint32_t kIncludeFileNames = 0x2;
+constexpr uint32_t kCompressedArchive = 0x4;
+
+// Per-file size bit that inverts the archive's default compression
+constexpr uint32_t kCompressionToggle = 0x40000000;
+
+// Content type flags (header fileFlags)
+constexpr uint16_t kMeshes = 0x1;
+constexpr uint16_t kTextures = 0x2;
+constexpr uint16_t kMenus = 0x4;
+constexpr uint16_t kSounds = 0x8;
+constexpr uint16_t kVoices = 0x10;
+constexpr uint16_t kShaders = 0x20;
+constexpr uint16_t kTrees = 0x40;
+constexpr uint16_t kFonts = 0x80;
+constexpr uint16_t kMisc = 0x100;
+
+constexpr uint32_t kHeaderSize = 36;
+constexpr uint32_t kFolderRecordSize = 24;  // version 105
+constexpr uint32_t kFileRecordSize = 16;
+
+std::string toArchiveForm(const std::string& path) {
+    std::string result = path;
+    for (char& c : result) {
+        if (c == '/') c = '\\';
+    }
+    CaseFold::foldInPlace(&result[0], result.size());
+    return result;
+}
+
+uint32_t hashString(const std::string& s) {
+    uint32_t hash = 0;
+    for (unsigned char c : s) {
+        hash = hash * 0x1003F + c;
+    }
+    return hash;
+}
+
+// Bethesda's TES4-style path hash. stem/extension must already be lowercase
+// with backslash separators; extension includes the dot.
+uint64_t hashPath(const std::string& stem, const std::string& extension) {
+    uint64_t hash = 0;
+    size_t len = stem.length();
+    if (len > 0) {
+        hash = static_cast<uint64_t>(
+            static_cast<uint8_t>(stem[len - 1]) +
+            (len > 2 ? static_cast<uint8_t>(stem[len - 2]) : 0) * 0x100u +
+            len * 0x10000u +
+            static_cast<uint8_t>(stem[0]) * 0x1000000u);
+        if (len > 3) {
+            hash += static_cast<uint64_t>(hashString(stem.substr(1, len - 3))) << 32;
+        }
+    }
+    if (!extension.empty()) {
+        hash += static_cast<uint64_t>(hashString(extension)) << 32;
+        uint8_t i = 0;
+        if (extension == ".nif") i = 1;
+        else if (extension == ".kf") i = 2;
+        else if (extension == ".dds") i = 3;
+        else if (extension == ".wav") i = 4;
+        if (i != 0) {
+            uint8_t a = static_cast<uint8_t>(((i & 0xfc) << 5) + ((hash & 0xff000000) >> 24));
+            uint8_t b = static_cast<uint8_t>(((i & 0xfe) << 6) + (hash & 0x000000ff));
+            uint8_t c = static_cast<uint8_t>((i << 7) + ((hash & 0x0000ff00) >> 8));
+            hash -= hash & 0xFF00FFFF;
+            hash += static_cast<uint32_t>((a << 24) + b + (c << 8));
+        }
+    }
+    return hash;
+}
+
+uint64_t hashFolder(const std::string& folder) {
+    return hashPath(folder, "");
+}
+
+uint64_t hashFile(const std::string& name) {
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos || dot == 0) return hashPath(name, "");
+    return hashPath(name.substr(0, dot), name.substr(dot));
+}
+
+uint16_t contentFlag(const std::string& folder) {
+    std::string top = folder.substr(0, folder.find('\\'));
+    if (top == "meshes") return kMeshes;
+    if (top == "textures") return kTextures;
+    if (top == "interface") return kMenus;
+    if (top == "sound") {
+        return folder.rfind("sound\\voice", 0) == 0 ? kVoices : kSounds;
+    }
+    if (top == "shaders") return kShaders;
+    if (top == "trees") return kTrees;
+    if (top == "fonts") return kFonts;
+    return kMisc;
+}
+
+bool isSoundFile(const std::string& name) {
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = name.substr(dot);
+    return ext == ".wav" || ext == ".xwm" || ext == ".fuz";
+}
+
+template <typename T>
+void put(std::ostream& out, T value) {
+    // BSA is little-endian; all supported platforms are too
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool get(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+struct FileRecord {
+    std::string name;  // lowercase file name
+    uint64_t hash = 0;
+    const Entry* entry = nullptr;
+    uint32_t storedSize = 0;
+    uint32_t offset = 0;
+    bool toggleCompression = false;
+};
+
+struct FolderRecord {
+    std::string name;  // lowercase, backslash separated
+    uint64_t hash = 0;
+    std::vector<FileRecord> files;
+    uint32_t recordOffset = 0;  // where this folder's name + file records start
+};
+
+bool fail(std::string* errorOut, const std::string& message) {
+    if (errorOut) *errorOut = message;
+    return false;
+}
+
+#ifdef NEXUSBRIDGE_HAVE_LZ4
+bool compressLz4(const std::vector<char>& input, std::vector<char>& output) {
+    LZ4F_preferences_t prefs;
+    std::memset(&prefs, 0, sizeof(prefs));
+    size_t bound = LZ4F_compressFrameBound(input.size(), &prefs);
+    output.resize(bound);
+    size_t written = LZ4F_compressFrame(output.data(), bound, input.data(), input.size(), &prefs);
+    if (LZ4F_isError(written)) return false;
+    output.resize(written);
+    return true;
+}
+#endif
+
+} // namespace
+
+bool lz4Available() {
+#ifdef NEXUSBRIDGE_HAVE_LZ4
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool writeArchive(const fs::path& outPath, std::vector<Entry> entries,
+                  Compression compression, std::string* errorOut) {
+    if (entries.empty()) return fail(errorOut, "no files to pack");
+    if (compression == Compression::LZ4 && !lz4Available()) {
+        return fail(errorOut, "LZ4 support not compiled in");
+    }
+    const bool compressed = compression == Compression::LZ4;
+
+    // Group files by folder; folders and files are both ordered by hash
+    std::map<std::string, FolderRecord> byName;
+    uint16_t fileFlags = 0;
+    for (const auto& entry : entries) {
+        std::string path = toArchiveForm(entry.archivePath);
+        size_t slash = path.find_last_of('\\');
+        if (slash == std::string::npos) {
+            return fail(errorOut, "file must be inside a folder: " + entry.archivePath);
+        }
+        FolderRecord& folder = byName[path.substr(0, slash)];
+        FileRecord file;
+        file.name = path.substr(slash + 1);
+        file.hash = hashFile(file.name);
+        file.entry = &entry;
+        file.toggleCompression = compressed && isSoundFile(file.name);
+        folder.files.push_back(file);
+    }
+
+    std::vector<FolderRecord> folders;
+    folders.reserve(byName.size());
+    uint32_t totalFolderNameLength = 0;
+    uint32_t totalFileNameLength = 0;
+    uint32_t fileCount = 0;
+    for (auto& [name, folder] : byName) {
+        folder.name = name;
+        folder.hash = hashFolder(name);
+        std::sort(folder.files.begin(), folder.files.end(),
+                  [](const FileRecord& a, const FileRecord& b) { return a.hash < b.hash; });
+        totalFolderNameLength += static_cast<uint32_t>(name.size() + 1);
+        for (const auto& file : folder.files) {
+            totalFileNameLength += static_cast<uint32_t>(file.name.size() + 1);
+        }
+        fileCount += static_cast<uint32_t>(folder.files.size());
+        fileFlags |= contentFlag(name);
+        folders.push_back(std::move(folder));
+    }
+    std::sort(folders.begin(), folders.end(),
+              [](const FolderRecord& a, const FolderRecord& b) { return a.hash < b.hash; });
+
+    // Layout: header, folder records, per-folder name + file records, file names, data
+    uint32_t offset = kHeaderSize + kFolderRecordSize * static_cast<uint32_t>(folders.size());
+    for (auto& folder : folders) {
+        folder.recordOffset = offset;
+        offset += 1 + static_cast<uint32_t>(folder.name.size() + 1) +
+                  kFileRecordSize * static_cast<uint32_t>(folder.files.size());
+    }
+    const uint32_t fileNamesOffset = offset;
+    const uint64_t dataOffset = static_cast<uint64_t>(fileNamesOffset) + totalFileNameLength;
+
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) return fail(errorOut, "cannot create " + outPath.string());
+
+    auto abort = [&](const std::string& message) {
+        out.close();
+        std::error_code ec;
+        fs::remove(outPath, ec);
+        return fail(errorOut, message);
+    };
+
+    // Header
+    out.write("BSA\0", 4);
+    put<uint32_t>(out, 105);
+    put<uint32_t>(out, kHeaderSize);
+    put<uint32_t>(out, kIncludeDirectoryNames | kIncludeFileNames |
+                           (compressed ? kCompressedArchive : 0));
+    put<uint32_t>(out, static_cast<uint32_t>(folders.size()));
+    put<uint32_t>(out, fileCount);
+    put<uint32_t>(out, totalFolderNameLength);
+    put<uint32_t>(out, totalFileNameLength);
+    put<uint16_t>(out, fileFlags);
+    put<uint16_t>(out, 0);
+
+    // Folder records (offset field is biased by totalFileNameLength)
+    for (const auto& folder : folders) {
+        put<uint64_t>(out, folder.hash);
+        put<uint32_t>(out, static_cast<uint32_t>(folder.files.size()));
+        put<uint32_t>(out, 0);
+        put<uint64_t>(out, static_cast<uint64_t>(folder.recordOffset) + totalFileNameLength);
+    }
+
+    // File data goes first so sizes/offsets are known, then records are filled in
+    out.seekp(static_cast<std::streamoff>(dataOffset));
+    uint64_t position = dataOffset;
+    std::vector<char> buffer;
+    std::vector<char> packed;
+    for (auto& folder : folders) {
+        for (auto& file : folder.files) {
+            std::ifstream in(file.entry->sourcePath, std::ios::binary | std::ios::ate);
+            if (!in) return abort("cannot read " + file.entry->sourcePath.string());
+            std::streamsize size = in.tellg();
+            in.seekg(0);
+            buffer.resize(static_cast<size_t>(size));
+            if (size > 0 && !in.read(buffer.data(), size)) {
+                return abort("cannot read " + file.entry->sourcePath.string());
+            }
+
+            bool storeCompressed = compressed && !file.toggleCompression;
+            uint64_t stored = 0;
+            if (storeCompressed) {
+#ifdef NEXUSBRIDGE_HAVE_LZ4
+                if (!compressLz4(buffer, packed)) {
+                    return abort("LZ4 compression failed for " + file.entry->archivePath);
+                }
+#endif
+                put<uint32_t>(out, static_cast<uint32_t>(buffer.size()));
+                out.write(packed.data(), static_cast<std::streamsize>(packed.size()));
+                stored = 4 + packed.size();
+            } else {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                stored = buffer.size();
+            }
+
+            if (position + stored > kMaxArchiveBytes) {
+                return abort("archive would exceed size limit");
+            }
+            file.offset = static_cast<uint32_t>(position);
+            file.storedSize = static_cast<uint32_t>(stored);
+            position += stored;
+        }
+    }
+
+    // Per-folder name blocks and file records
+    out.seekp(static_cast<std::streamoff>(kHeaderSize + kFolderRecordSize * folders.size()));
+    for (const auto& folder : folders) {
+        put<uint8_t>(out, static_cast<uint8_t>(folder.name.size() + 1));
+        out.write(folder.name.c_str(), static_cast<std::streamsize>(folder.name.size() + 1));
+        for (const auto& file : folder.files) {
+            put<uint64_t>(out, file.hash);
+            put<uint32_t>(out, file.storedSize | (file.toggleCompression ? kCompressionToggle : 0));
+            put<uint32_t>(out, file.offset);
+        }
+    }
+
+    // File name block, same order as the records
+    for (const auto& folder : folders) {
+        for (const auto& file : folder.files) {
+            out.write(file.name.c_str(), static_cast<std::streamsize>(file.name.size() + 1));
+        }
+    }
+
+    out.close();
+    if (!out) return abort("write failed for " + outPath.string());
+    return true;
+}
+
+std::vector<std::string> listFiles(const fs::path& bsaPath) {
+    std::vector<std::string> result;
+    std::ifstream in(bsaPath, std::ios::binary);
+    if (!in) return result;
+
+    char magic[4];
+    uint32_t version = 0, headerSize = 0, archiveFlags = 0, folderCount = 0, fileCount = 0;
+    uint32_t folderNamesLength = 0, fileNamesLength = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, "BSA\0", 4) != 0) return result;
+    if (!get(in, version) || !get(in, headerSize) || !get(in, archiveFlags) ||
+        !get(in, folderCount) || !get(in, fileCount) || !get(in, folderNamesLength) ||
+        !get(in, fileNamesLength)) {
+        return result;
+    }
+    if (version < 103 || version > 105) return result;
+    if (!(archiveFlags & kIncludeDirectoryNames) || !(archiveFlags & kIncludeFileNames)) {
+        return result;
+    }
+
+    std::vector<uint32_t> counts(folderCount);
+    in.seekg(headerSize);
+    for (uint32_t i = 0; i < folderCount; ++i) {
+        uint64_t hash = 0;
+        uint32_t count = 0;
+        get(in, hash);
+        get(in, count);
+        // v103/104 records are 16 bytes, v105 records are 24
+        in.seekg(version == 105 ? 12 : 4, std::ios::cur);
+        counts[i] = count;
+    }
+
+    std::vector<std::string> fileFolders;
+    fileFolders.reserve(fileCount);
+    for (uint32_t i = 0; i < folderCount && in; ++i) {
+        uint8_t length = 0;
+        get(in, length);
+        std::string name(length, '\0');
+        in.read(&name[0], length);
+        if (!name.empty() && name.back() == '\0') name.pop_back();
+        std::replace(name.begin(), name.end(), '\\', '/');
+        for (uint32_t f = 0; f < counts[i]; ++f) {
+            fileFolders.push_back(name);
+        }
+        in.seekg(static_cast<std::streamoff>(kFileRecordSize) * counts[i], std::ios::cur);
+    }
+
+    std::string names(fileNamesLength, '\0');
+    if (!in.read(&names[0], fileNamesLength)) return result;
+
+    result.reserve(fileFolders.size());
+    size_t pos = 0;
+    for (const auto& folder : fileFolders) {
+        size_t end = names.find('\0', pos);
+        if (end == std::string::npos) break;
+        std::string path = folder + "/" + names.substr(pos, end - pos);
+        CaseFold::foldInPlace(&path[0], path.size());
+        result.push_back(path);
+        pos = end + 1;
+    }
+    return result;
+}
+
+bool writeDummyPlugin(const fs::path& outPath) {
+    static const char author[] = "NexusBridge";
+
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    // HEDR (version, record count, next object id) + CNAM (author)
+    const uint32_t dataSize = (6 + 12) + (6 + sizeof(author));
+
+    out.write("TES4", 4);
+    put<uint32_t>(out, dataSize);
+    put<uint32_t>(out, 0x200);  // Light plugin (ESL flag) - uses no full load order slot
+    put<uint32_t>(out, 0);      // FormID
+    put<uint32_t>(out, 0);      // Version control info
+    put<uint16_t>(out, 44);     // Form version (Skyrim SE)
+    put<uint16_t>(out, 0);
+
+    out.write("HEDR", 4);
+    put<uint16_t>(out, 12);
+    put<float>(out, 1.7f);
+    put<int32_t>(out, 0);
+    put<uint32_t>(out, 0x800);
+
+    out.write("CNAM", 4);
+    put<uint16_t>(out, static_cast<uint16_t>(sizeof(author)));
+    out.write(author, sizeof(author));
+
+    return static_cast<bool>(out);
+}
+
+} // namespace BsaWriter
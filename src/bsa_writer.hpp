@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace BsaWriter {
+
+// A loose file to store in the archive
+struct Entry {
+    std::string archivePath;  // Path inside the archive, e.g. "textures/foo/bar.dds"
+    fs::path sourcePath;      // File on disk
+    uint64_t size = 0;
+};
+
+enum class Compression { None, LZ4 };
+
+// Max archive size the game can address reliably (offsets are 32-bit)
+constexpr uint64_t kMaxArchiveBytes = 2000ULL * 1024 * 1024;
+
+// True if this build can write LZ4-compressed (Skyrim SE) archives
+bool lz4Available();
+
+// Write a Skyrim Special Edition (version 105) BSA.
+// Sound files are always stored uncompressed. Returns false and fills
+// errorOut on failure; a partially written file is removed.
+bool writeArchive(const fs::path& outPath, std::vector<Entry> entries,
+                  Compression compression, std::string* errorOut = nullptr);
+
+// List the files stored in an existing BSA (versions 103-105), as
+// lowercase forward-slash paths. Returns empty on error.
+std::vector<std::string> listFiles(const fs::path& bsaPath);
+
+// Write a minimal light (ESL-flagged) plugin whose only purpose is to make
+// the game load the BSA with the same base name
+bool writeDummyPlugin(const fs::path& outPath);
+
+} // namespace BsaWriter
@@ -0,0 +1,186 @@
+#pragma once
+
+// ASCII case folding for file, folder and plugin names.
+// Windows (and therefore every mod author) treats names case-insensitively,
+// so lookups here fold A-Z to a-z; other bytes, including UTF-8, are left
+// alone, which matches what std::tolower does in the "C" locale.
+
+#include "content_hash.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CASEFOLD_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CASEFOLD_NEON 1
+#endif
+
+namespace CaseFold {
+
+constexpr char foldChar(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return static_cast<char>(u + (static_cast<unsigned char>(u - 'A') < 26 ? 32 : 0));
+}
+
+namespace detail {
+
+#if defined(CASEFOLD_SSE2)
+// Shift 'A'..'Z' onto -128..-103 so one signed compare finds them
+inline __m128i fold16(__m128i v) {
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(v, bias), limit);
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#elif defined(CASEFOLD_NEON)
+inline uint8x16_t fold16(uint8x16_t v) {
+    uint8x16_t upper = vcleq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8(25));
+    return vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20)));
+}
+#endif
+
+} // namespace detail
+
+// Lowercase ASCII letters in place, 16 bytes at a time where possible
+inline void foldInPlace(char* data, size_t len) {
+    size_t i = 0;
+#if defined(CASEFOLD_SSE2)
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), detail::fold16(v));
+    }
+#elif defined(CASEFOLD_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8_t* p = reinterpret_cast<uint8_t*>(data + i);
+        vst1q_u8(p, detail::fold16(vld1q_u8(p)));
+    }
+#endif
+    for (; i < len; ++i) data[i] = foldChar(data[i]);
+}
+
+inline std::string fold(std::string_view text) {
+    std::string result(text);
+    foldInPlace(&result[0], result.size());
+    return result;
+}
+
+// Case-insensitive equality without building folded copies
+inline bool equals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    size_t i = 0;
+#if defined(CASEFOLD_SSE2)
+    for (; i + 16 <= a.size(); i += 16) {
+        __m128i x = detail::fold16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i)));
+        __m128i y = detail::fold16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) return false;
+    }
+#elif defined(CASEFOLD_NEON)
+    for (; i + 16 <= a.size(); i += 16) {
+        uint8x16_t x = detail::fold16(vld1q_u8(reinterpret_cast<const uint8_t*>(a.data() + i)));
+        uint8x16_t y = detail::fold16(vld1q_u8(reinterpret_cast<const uint8_t*>(b.data() + i)));
+        if (vminvq_u8(vceqq_u8(x, y)) != 0xFF) return false;
+    }
+#endif
+    for (; i < a.size(); ++i) {
+        if (foldChar(a[i]) != foldChar(b[i])) return false;
+    }
+    return true;
+}
+
+inline bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() &&
+           equals(text.substr(text.size() - suffix.size()), suffix);
+}
+
+// Folded copy of a short name on the stack, for one-off lookups against
+// static tables (names longer than the buffer spill to the heap)
+class Folded {
+public:
+    explicit Folded(std::string_view text) {
+        if (text.size() <= sizeof(inline_)) {
+            std::memcpy(inline_, text.data(), text.size());
+            foldInPlace(inline_, text.size());
+            view_ = std::string_view(inline_, text.size());
+        } else {
+            heap_ = fold(text);
+            view_ = heap_;
+        }
+    }
+    Folded(const Folded&) = delete;
+    Folded& operator=(const Folded&) = delete;
+
+    std::string_view view() const { return view_; }
+
+private:
+    char inline_[256];
+    std::string heap_;
+    std::string_view view_;
+};
+
+// Map/set key: the folded name plus its 64-bit hash, computed once.
+// Equality checks the hash before touching the characters, so bucket
+// collisions and near-miss paths with long shared prefixes are cheap.
+//
+// Key::borrow makes a lookup-only key that points at the caller's text
+// instead of folding a copy: the hash is taken over a folded copy on the
+// stack and equality folds both sides as it compares, so find() and
+// count() in per-file loops don't allocate. (std::unordered_map only
+// gets heterogeneous lookup in C++20.) The text must outlive the key,
+// and a borrowed key must not be stored.
+class Key {
+public:
+    Key() : hash_(hashOf(std::string_view())) {}
+    Key(std::string_view text) : text_(fold(text)), hash_(hashOf(text_)) {}
+    Key(const std::string& text) : Key(std::string_view(text)) {}
+    Key(const char* text) : Key(std::string_view(text)) {}
+
+    static Key borrow(std::string_view text) {
+        Key key;
+        key.borrowed_ = text;
+        key.isBorrowed_ = true;
+        key.hash_ = hashOf(Folded(text).view());
+        return key;
+    }
+
+    const std::string& text() const { return text_; }
+    uint64_t hash() const { return hash_; }
+    bool empty() const { return isBorrowed_ ? borrowed_.empty() : text_.empty(); }
+
+    bool operator==(const Key& other) const {
+        if (hash_ != other.hash_) return false;
+        if (!isBorrowed_ && !other.isBorrowed_) return text_ == other.text_;
+        return equals(chars(), other.chars());
+    }
+    bool operator!=(const Key& other) const { return !(*this == other); }
+    bool operator<(const Key& other) const { return text_ < other.text_; }
+
+private:
+    static uint64_t hashOf(std::string_view folded) {
+        return ContentHash::xxh64(folded.data(), folded.size());
+    }
+
+    std::string_view chars() const { return isBorrowed_ ? borrowed_ : std::string_view(text_); }
+
+    std::string text_;
+    std::string_view borrowed_;
+    uint64_t hash_;
+    bool isBorrowed_ = false;
+};
+
+struct KeyHash {
+    size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash()); }
+};
+
+using KeySet = std::unordered_set<Key, KeyHash>;
+
+template <class Value>
+using KeyMap = std::unordered_map<Key, Value, KeyHash>;
+
+} // namespace CaseFold
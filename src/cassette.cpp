@@ -0,0 +1,280 @@
+#include "cassette.hpp"
+#include "../include/nlohmann/json.hpp"
+#include "case_fold.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace Cassette {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Recorded {
+    std::vector<json> entries;
+    size_t next = 0;
+};
+
+std::mutex g_mutex;
+Mode g_mode = Mode::Off;
+fs::path g_dir;
+double g_speed = 1.0;
+std::ofstream g_log;
+size_t g_payloads = 0;
+std::map<std::string, Recorded> g_recorded;  // key() -> entries in recorded order
+
+std::string key(std::string_view kind, std::string_view method, std::string_view url,
+                std::string_view requestBody) {
+    std::string k;
+    k.reserve(kind.size() + method.size() + url.size() + requestBody.size() + 3);
+    k.append(kind).append(" ").append(method).append(" ");
+    k.append(redactUrl(url)).append("\n").append(requestBody);
+    return k;
+}
+
+// Credentials that can appear in response bodies (users/validate.json)
+std::string redactBody(const std::string& body) {
+    if (body.empty() || body.front() != '{') return body;
+    json parsed = json::parse(body, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object()) return body;
+    bool changed = false;
+    for (const char* field : {"key", "email"}) {
+        if (parsed.contains(field)) {
+            parsed[field] = "REDACTED";
+            changed = true;
+        }
+    }
+    return changed ? parsed.dump(-1, ' ', false, json::error_handler_t::replace) : body;
+}
+
+json describe(const Exchange& exchange) {
+    return json{{"curl", exchange.curlCode},
+                {"http", exchange.httpCode},
+                {"retryAfter", exchange.retryAfter},
+                {"ms", exchange.elapsed.count()}};
+}
+
+void append(const json& entry) {
+    g_log << entry.dump(-1, ' ', false, json::error_handler_t::replace) << '\n';
+    g_log.flush();
+}
+
+// Next entry for k (the last one again once they run out: replay can make
+// more requests than the recording did, e.g. when it retries differently)
+bool take(const std::string& k, json& entry) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_recorded.find(k);
+    if (it == g_recorded.end() || it->second.entries.empty()) return false;
+    Recorded& recorded = it->second;
+    entry = recorded.entries[std::min(recorded.next, recorded.entries.size() - 1)];
+    recorded.next++;
+    return true;
+}
+
+Exchange exchangeOf(const json& entry) {
+    Exchange exchange;
+    exchange.curlCode = entry.value("curl", 0);
+    exchange.httpCode = entry.value("http", 0L);
+    exchange.retryAfter = entry.value("retryAfter", 0LL);
+    exchange.elapsed = std::chrono::milliseconds(entry.value("ms", 0LL));
+    return exchange;
+}
+
+// Wait out the rest of the recorded duration, scaled
+void pace(std::chrono::milliseconds recorded, Clock::time_point started) {
+    auto target = std::chrono::duration_cast<Clock::duration>(recorded * g_speed);
+    auto spent = Clock::now() - started;
+    if (target > spent) std::this_thread::sleep_for(target - spent);
+}
+
+// Highest number used by payloads/<n>-<name> files already in dir, so a
+// further recording into the same cassette carries on after them
+size_t lastPayloadNumber(const fs::path& dir) {
+    size_t last = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        size_t dash = name.find('-');
+        if (dash == 0 || dash == std::string::npos || dash > 18 ||
+            name.find_first_not_of("0123456789") != dash) {
+            continue;
+        }
+        last = std::max<size_t>(last, std::stoull(name.substr(0, dash)));
+    }
+    return last;
+}
+
+bool load(std::string* error) {
+    std::ifstream in(g_dir / "requests.jsonl");
+    if (!in) {
+        if (error) *error = "no requests.jsonl in " + g_dir.string();
+        return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty()) continue;
+        json entry = json::parse(line, nullptr, false);
+        if (entry.is_discarded() || !entry.is_object()) {
+            if (error) *error = "requests.jsonl line " + std::to_string(lineNumber) + " is not JSON";
+            return false;
+        }
+        std::string k = key(entry.value("kind", ""), entry.value("method", ""),
+                            entry.value("url", ""), entry.value("request", ""));
+        g_recorded[k].entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+} // namespace
+
+bool open(const fs::path& dir, Mode mode, double speed, std::string* error) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_dir = dir;
+    g_speed = std::max(0.0, speed);
+    g_recorded.clear();
+    g_payloads = 0;
+
+    if (mode == Mode::Record) {
+        std::error_code ec;
+        fs::create_directories(dir / "payloads", ec);
+        g_payloads = lastPayloadNumber(dir / "payloads");
+        g_log.open(dir / "requests.jsonl", std::ios::app);
+        if (ec || !g_log) {
+            if (error) *error = "can't write to " + dir.string();
+            return false;
+        }
+    } else if (mode == Mode::Replay && !load(error)) {
+        return false;
+    }
+    g_mode = mode;
+    return true;
+}
+
+Mode mode() {
+    return g_mode;
+}
+
+std::string redactUrl(std::string_view url) {
+    size_t query = url.find('?');
+    if (query == std::string_view::npos) return std::string(url);
+
+    std::string out(url.substr(0, query + 1));
+    std::string_view params = url.substr(query + 1);
+    while (!params.empty()) {
+        size_t end = params.find('&');
+        std::string_view param = params.substr(0, end);
+        size_t eq = param.find('=');
+        std::string_view name = param.substr(0, eq);
+        bool secret = false;
+        for (const char* s : {"key", "apikey", "api_key", "token", "access_token", "user_id"}) {
+            secret = secret || CaseFold::equals(name, s);
+        }
+        if (secret && eq != std::string_view::npos) {
+            out.append(name).append("=REDACTED");
+        } else {
+            out.append(param);
+        }
+        if (end == std::string_view::npos) break;
+        out.push_back('&');
+        params.remove_prefix(end + 1);
+    }
+    return out;
+}
+
+void recordRequest(std::string_view method, std::string_view url, std::string_view requestBody,
+                   const Exchange& exchange) {
+    json entry = describe(exchange);
+    entry["kind"] = "request";
+    entry["method"] = method;
+    entry["url"] = redactUrl(url);
+    entry["request"] = requestBody;
+    entry["body"] = redactBody(exchange.body);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_mode == Mode::Record) append(entry);
+}
+
+bool replayRequest(std::string_view method, std::string_view url, std::string_view requestBody,
+                   Exchange& out) {
+    Clock::time_point started = Clock::now();
+    json entry;
+    if (!take(key("request", method, url, requestBody), entry)) return false;
+    out = exchangeOf(entry);
+    out.body = entry.value("body", "");
+    pace(out.elapsed, started);
+    return true;
+}
+
+void recordDownload(std::string_view url, const fs::path& file, const Exchange& exchange) {
+    json entry = describe(exchange);
+    entry["kind"] = "download";
+    entry["url"] = redactUrl(url);
+
+    std::error_code ec;
+    if (fs::is_regular_file(file, ec)) {
+        // Name it after the archive, not the .part file it was written to
+        fs::path name = file.filename();
+        if (name.extension() == ".part") name = name.stem();
+        // Never onto an existing payload: it may be hard-linked to an
+        // archive in downloads/ from an earlier recording, and writing
+        // over it would change that archive too
+        std::string payload;
+        for (int tries = 0; tries < 100; ++tries) {
+            {
+                std::lock_guard<std::mutex> lock(g_mutex);
+                payload = "payloads/" + std::to_string(++g_payloads) + "-" + name.string();
+            }
+            ec.clear();
+            if (fs::exists(g_dir / payload, ec)) {
+                ec = std::make_error_code(std::errc::file_exists);
+                continue;
+            }
+            fs::create_hard_link(file, g_dir / payload, ec);
+            if (ec) {
+                ec.clear();
+                fs::copy_file(file, g_dir / payload, fs::copy_options::none, ec);
+            }
+            if (ec != std::errc::file_exists) break;
+        }
+        if (!ec) {
+            entry["payload"] = payload;
+            entry["size"] = fs::file_size(file, ec);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_mode == Mode::Record) append(entry);
+}
+
+bool replayDownload(std::string_view url, const fs::path& dest, Exchange& out) {
+    Clock::time_point started = Clock::now();
+    json entry;
+    if (!take(key("download", "", url, ""), entry)) return false;
+    out = exchangeOf(entry);
+
+    std::string payload = entry.value("payload", "");
+    bool succeeded = out.curlCode == 0 && out.httpCode >= 200 && out.httpCode < 300;
+    if (payload.empty() && succeeded) {
+        // Transferred but not kept (it failed verification, or couldn't be
+        // stored): there is no archive to hand out
+        return false;
+    }
+    if (!payload.empty()) {
+        // A fresh file, so nothing hard-linked to dest is written through
+        std::error_code ec;
+        fs::remove(dest, ec);
+        fs::copy_file(g_dir / payload, dest, fs::copy_options::none, ec);
+        if (ec) return false;
+    }
+    pace(out.elapsed, started);
+    return true;
+}
+
+} // namespace Cassette
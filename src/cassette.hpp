@@ -0,0 +1,63 @@
+#pragma once
+
+// Record and replay of network traffic, so installs of real collections
+// can be profiled and re-run without network access or API quota.
+//
+// Recording appends every API request's outcome to <dir>/requests.jsonl
+// and hard-links (or copies) each downloaded archive into <dir>/payloads/,
+// numbered on from what an earlier recording there left. Payloads are
+// never overwritten, and archives that fail verification aren't kept.
+// The API key is sent in a header and never written; credential-like URL
+// parameters and response fields are redacted. Replay answers the same
+// requests from the cassette in the order they were recorded, after the
+// recorded time multiplied by a speed factor (0 = no waiting).
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace Cassette {
+
+enum class Mode { Off, Record, Replay };
+
+// Outcome of one request, as recorded
+struct Exchange {
+    int curlCode = 0;           // CURLcode
+    long httpCode = 0;          // 0 when no response arrived
+    long long retryAfter = 0;   // Seconds, from the Retry-After header
+    std::string body;           // Response body (API requests only)
+    std::chrono::milliseconds elapsed{0};
+};
+
+// Start recording to or replaying from dir. speed scales replayed waits.
+bool open(const fs::path& dir, Mode mode, double speed = 1.0, std::string* error = nullptr);
+
+Mode mode();
+inline bool recording() { return mode() == Mode::Record; }
+inline bool replaying() { return mode() == Mode::Replay; }
+
+// API requests; method is "GET" or "POST", requestBody empty for GET
+void recordRequest(std::string_view method, std::string_view url, std::string_view requestBody,
+                   const Exchange& exchange);
+
+// Fills out with the next recorded outcome for this request, after its
+// scaled duration. False if the cassette has none.
+bool replayRequest(std::string_view method, std::string_view url, std::string_view requestBody,
+                   Exchange& out);
+
+// Archive downloads. file is what the download produced (nothing is
+// stored for a failed one beyond its outcome).
+void recordDownload(std::string_view url, const fs::path& file, const Exchange& exchange);
+
+// Writes the recorded archive to dest and fills out. False if the
+// cassette has no download for url, or has its outcome but no archive
+// for a transfer that succeeded (one that wasn't verified when recorded).
+bool replayDownload(std::string_view url, const fs::path& dest, Exchange& out);
+
+// url with the values of credential-like query parameters replaced
+std::string redactUrl(std::string_view url);
+
+} // namespace Cassette
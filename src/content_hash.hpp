@@ -0,0 +1,295 @@
+#pragma once
+
+// XXH64 content fingerprints (fast non-cryptographic hash).
+// Used to find identical files; never as a security check.
+// MD5 is here only because Nexus identifies archives by it.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ContentHash {
+
+namespace detail {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= round(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace detail
+
+// Streaming XXH64 so large files can be hashed in fixed-size chunks
+class Xxh64 {
+public:
+    explicit Xxh64(uint64_t seed = 0) : seed_(seed) {
+        v_[0] = seed + detail::kPrime1 + detail::kPrime2;
+        v_[1] = seed + detail::kPrime2;
+        v_[2] = seed;
+        v_[3] = seed - detail::kPrime1;
+    }
+
+    void update(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        total_ += len;
+
+        if (bufferLen_ + len < 32) {
+            std::memcpy(buffer_ + bufferLen_, p, len);
+            bufferLen_ += len;
+            return;
+        }
+        if (bufferLen_ > 0) {
+            size_t fill = 32 - bufferLen_;
+            std::memcpy(buffer_ + bufferLen_, p, fill);
+            consume(buffer_);
+            p += fill;
+            len -= fill;
+            bufferLen_ = 0;
+        }
+        while (len >= 32) {
+            consume(p);
+            p += 32;
+            len -= 32;
+        }
+        std::memcpy(buffer_, p, len);
+        bufferLen_ = len;
+    }
+
+    uint64_t digest() const {
+        using namespace detail;
+        uint64_t h;
+        if (total_ >= 32) {
+            h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18);
+            for (uint64_t v : v_) h = mergeRound(h, v);
+        } else {
+            h = seed_ + kPrime5;
+        }
+        h += total_;
+
+        const unsigned char* p = buffer_;
+        size_t len = bufferLen_;
+        while (len >= 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+            p += 8;
+            len -= 8;
+        }
+        if (len >= 4) {
+            h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+            len -= 4;
+        }
+        while (len > 0) {
+            h ^= (*p) * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+            ++p;
+            --len;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    void consume(const unsigned char* p) {
+        for (int i = 0; i < 4; ++i) {
+            v_[i] = detail::round(v_[i], detail::read64(p + i * 8));
+        }
+    }
+
+    uint64_t seed_;
+    uint64_t v_[4];
+    unsigned char buffer_[32] = {};
+    size_t bufferLen_ = 0;
+    uint64_t total_ = 0;
+};
+
+inline uint64_t xxh64(const void* data, size_t len, uint64_t seed = 0) {
+    Xxh64 state(seed);
+    state.update(data, len);
+    return state.digest();
+}
+
+// Hash a whole file, or only its first and last `edgeBytes` when edgeBytes > 0
+// (cheap pre-filter before a full hash). Returns false if the file can't be read.
+inline bool hashFile(const std::filesystem::path& path, uint64_t& out, size_t edgeBytes = 0) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    uint64_t size = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+
+    Xxh64 state;
+    state.update(&size, sizeof(size));
+    std::vector<char> buffer(256 * 1024);
+
+    if (edgeBytes > 0 && size > edgeBytes * 2) {
+        buffer.resize(edgeBytes);
+        if (!in.read(buffer.data(), static_cast<std::streamsize>(edgeBytes))) return false;
+        state.update(buffer.data(), edgeBytes);
+        in.seekg(static_cast<std::streamoff>(size - edgeBytes));
+        if (!in.read(buffer.data(), static_cast<std::streamsize>(edgeBytes))) return false;
+        state.update(buffer.data(), edgeBytes);
+    } else {
+        while (in) {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            std::streamsize got = in.gcount();
+            if (got <= 0) break;
+            state.update(buffer.data(), static_cast<size_t>(got));
+        }
+        if (in.bad()) return false;
+    }
+
+    out = state.digest();
+    return true;
+}
+
+// Streaming MD5 (RFC 1321), for checking archives against the MD5s Nexus
+// and collections list
+class Md5 {
+public:
+    void update(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        total_ += len;
+        if (bufferLen_ > 0) {
+            size_t fill = std::min(len, sizeof(buffer_) - bufferLen_);
+            std::memcpy(buffer_ + bufferLen_, p, fill);
+            bufferLen_ += fill;
+            p += fill;
+            len -= fill;
+            if (bufferLen_ < sizeof(buffer_)) return;
+            consume(buffer_);
+            bufferLen_ = 0;
+        }
+        while (len >= 64) {
+            consume(p);
+            p += 64;
+            len -= 64;
+        }
+        std::memcpy(buffer_, p, len);
+        bufferLen_ = len;
+    }
+
+    // Lower-case hex digest. Finishes the hash; don't update afterwards.
+    std::string hexDigest() {
+        uint64_t bits = total_ * 8;
+        static const unsigned char kPad[64] = {0x80};
+        update(kPad, bufferLen_ < 56 ? 56 - bufferLen_ : 120 - bufferLen_);
+        unsigned char length[8];
+        for (int i = 0; i < 8; ++i) length[i] = static_cast<unsigned char>(bits >> (8 * i));
+        update(length, sizeof(length));
+
+        static const char kHex[] = "0123456789abcdef";
+        std::string hex;
+        for (uint32_t word : state_) {
+            for (int i = 0; i < 4; ++i) {
+                unsigned char byte = static_cast<unsigned char>(word >> (8 * i));
+                hex += kHex[byte >> 4];
+                hex += kHex[byte & 15];
+            }
+        }
+        return hex;
+    }
+
+private:
+    static uint32_t rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+    void consume(const unsigned char* p) {
+        static const uint32_t kSines[64] = {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+            0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+            0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+            0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+            0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+            0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+            0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+        static const int kShifts[16] = {7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21};
+
+        uint32_t m[16];
+        for (int i = 0; i < 16; ++i) {
+            m[i] = static_cast<uint32_t>(p[i * 4]) | static_cast<uint32_t>(p[i * 4 + 1]) << 8 |
+                   static_cast<uint32_t>(p[i * 4 + 2]) << 16 | static_cast<uint32_t>(p[i * 4 + 3]) << 24;
+        }
+
+        uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t f;
+            int g;
+            switch (i / 16) {
+            case 0: f = (b & c) | (~b & d); g = i; break;
+            case 1: f = (d & b) | (~d & c); g = (5 * i + 1) % 16; break;
+            case 2: f = b ^ c ^ d; g = (3 * i + 5) % 16; break;
+            default: f = c ^ (b | ~d); g = (7 * i) % 16; break;
+            }
+            uint32_t rotated = rotl32(a + f + kSines[i] + m[g], kShifts[(i / 16) * 4 + i % 4]);
+            a = d;
+            d = c;
+            c = b;
+            b += rotated;
+        }
+        state_[0] += a;
+        state_[1] += b;
+        state_[2] += c;
+        state_[3] += d;
+    }
+
+    uint32_t state_[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    unsigned char buffer_[64] = {};
+    size_t bufferLen_ = 0;
+    uint64_t total_ = 0;
+};
+
+// MD5 of a whole file as lower-case hex. Returns false if it can't be read.
+inline bool md5File(const std::filesystem::path& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    Md5 state;
+    std::vector<char> buffer(1024 * 1024);
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        state.update(buffer.data(), static_cast<size_t>(got));
+    }
+    if (in.bad()) return false;
+    out = state.hexDigest();
+    return true;
+}
+
+} // namespace ContentHash
@@ -0,0 +1,782 @@
+#include "copy_engine.hpp"
+#include "case_fold.hpp"
+#include "dir_walker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef NEXUSBRIDGE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+namespace CopyEngine {
+
+namespace {
+
+std::atomic<bool> g_ioUringEnabled{true};
+std::atomic<bool> g_cacheFriendly{false};
+std::atomic<size_t> g_batchFiles{64};
+thread_local std::function<bool(size_t)> t_progressHook;
+thread_local bool t_sequential = false;
+thread_local uint64_t t_bytesPlaced = 0;
+
+// False if the hook asked to stop
+bool reportProgress(size_t filesDone) {
+    return !t_progressHook || t_progressHook(filesDone);
+}
+
+size_t failCancelled(size_t count, std::vector<std::string>* errorsOut) {
+    if (errorsOut && count > 0) errorsOut->push_back("copy cancelled");
+    return count;
+}
+
+// Give the destination a fresh inode. Overwriting an existing file in
+// place would write through to every other name hardlinked to it (mods
+// deduplicated with --dedup), changing those mods too.
+void unlinkDest(const fs::path& dest) {
+#ifdef _WIN32
+    std::error_code ec;
+    if (!fs::is_directory(dest, ec)) fs::remove(dest, ec);
+#else
+    ::unlink(dest.c_str());
+#endif
+}
+
+// Files this big are copied in chunks when a progress hook is set, with
+// the hook called between chunks: one fs::copy_file of several GB to a
+// slow disk or share says nothing until it's done, and a watchdog would
+// take the install for stalled
+constexpr uint64_t kChunkedCopyBytes = 64 * 1024 * 1024;
+constexpr size_t kCopyChunkBytes = 16 * 1024 * 1024;
+
+// Copy source to a new dest file chunk by chunk. Returns false with error
+// set on failure or when the hook cancels (dest is removed then).
+bool copyChunked(const fs::path& source, const fs::path& dest, std::string& error) {
+    auto fail = [&](const std::string& why) {
+        error = source.string() + " -> " + dest.string() + ": " + why;
+        std::error_code ec;
+        fs::remove(dest, ec);
+        return false;
+    };
+#ifdef __linux__
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return fail(std::strerror(errno));
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        int err = errno;
+        close(in);
+        return fail(std::strerror(err));
+    }
+    int out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 07777);
+    if (out < 0) {
+        int err = errno;
+        close(in);
+        return fail(std::strerror(err));
+    }
+
+    // copy_file_range keeps the data in the kernel; some filesystem pairs
+    // refuse it, and those fall back to read/write
+    std::vector<char> buffer;
+    std::string why;
+    while (true) {
+        ssize_t done = -1;
+        if (buffer.empty()) {
+            done = copy_file_range(in, nullptr, out, nullptr, kCopyChunkBytes, 0);
+            if (done < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+                             errno == EOPNOTSUPP)) {
+                buffer.resize(kCopyChunkBytes);
+                continue;
+            }
+        } else {
+            done = read(in, buffer.data(), buffer.size());
+            for (ssize_t put = 0; done > 0 && put < done;) {
+                ssize_t wrote = write(out, buffer.data() + put, done - put);
+                if (wrote < 0 && errno == EINTR) continue;
+                if (wrote <= 0) {
+                    done = -1;
+                    break;
+                }
+                put += wrote;
+            }
+        }
+        if (done < 0 && errno == EINTR) continue;
+        if (done < 0) {
+            why = std::strerror(errno);
+            break;
+        }
+        if (done == 0) break;
+        if (!reportProgress(0)) {
+            why = "copy cancelled";
+            break;
+        }
+    }
+    close(in);
+    if (close(out) != 0 && why.empty()) why = std::strerror(errno);
+    return why.empty() ? true : fail(why);
+#else
+    std::ifstream in(source, std::ios::binary);
+    std::ofstream out(dest, std::ios::binary | std::ios::trunc);
+    if (!in || !out) return fail("can't open");
+    std::vector<char> buffer(kCopyChunkBytes);
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = in.gcount();
+        if (got <= 0) break;
+        if (!out.write(buffer.data(), got)) return fail("write failed");
+        if (!reportProgress(0)) return fail("copy cancelled");
+    }
+    if (in.bad() || !out.flush()) return fail("read or write failed");
+    out.close();
+    std::error_code ec;
+    fs::permissions(dest, fs::status(source, ec).permissions(), ec);
+    return true;
+#endif
+}
+
+bool copyWithFilesystem(const fs::path& source, const fs::path& dest, std::string& error) {
+    std::error_code ec;
+    unlinkDest(dest);
+    uintmax_t size = fs::file_size(source, ec);
+    if (ec) size = 0;
+    if (t_progressHook && size >= kChunkedCopyBytes) {
+        if (!copyChunked(source, dest, error)) return false;
+        t_bytesPlaced += size;
+        return true;
+    }
+    ec.clear();
+    fs::copy_file(source, dest, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        error = source.string() + " -> " + dest.string() + ": " + ec.message();
+        return false;
+    }
+    t_bytesPlaced += size;
+    return true;
+}
+
+size_t copySequential(const std::vector<std::pair<fs::path, fs::path>>& jobs,
+                      std::vector<std::string>* errorsOut) {
+    size_t failed = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        std::string error;
+        if (!copyWithFilesystem(jobs[i].first, jobs[i].second, error)) {
+            failed++;
+            if (errorsOut) errorsOut->push_back(error);
+        }
+        if (!reportProgress(1)) return failed + failCancelled(jobs.size() - i - 1, errorsOut);
+    }
+    return failed;
+}
+
+#ifdef NEXUSBRIDGE_HAVE_IO_URING
+
+// Files per round trip. Every stage submits at most two operations per
+// file, so the ring needs twice as many entries.
+constexpr size_t kBatchFiles = 64;
+constexpr unsigned kRingEntries = kBatchFiles * 2;
+
+// Larger files are bandwidth-bound; fs::copy_file (copy_file_range)
+// handles them without a userspace buffer
+constexpr uint64_t kMaxInlineBytes = 128 * 1024;
+
+// Below this, setting up the batch costs more than it saves
+constexpr size_t kMinBatchJobs = 8;
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency)
+class Ring {
+public:
+    Ring() = default;
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring() {
+        if (sqes_) munmap(sqes_, sqesSize_);
+        if (cqPtr_ && cqPtr_ != sqPtr_) munmap(cqPtr_, cqSize_);
+        if (sqPtr_) munmap(sqPtr_, sqSize_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) return false;
+
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+
+        sqPtr_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd_, IORING_OFF_SQ_RING);
+        if (sqPtr_ == MAP_FAILED) {
+            sqPtr_ = nullptr;
+            return false;
+        }
+        if (singleMmap) {
+            cqPtr_ = sqPtr_;
+        } else {
+            cqPtr_ = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd_, IORING_OFF_CQ_RING);
+            if (cqPtr_ == MAP_FAILED) {
+                cqPtr_ = nullptr;
+                return false;
+            }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sqPtr_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries_ = params.sq_entries;
+
+        char* cq = static_cast<char*>(cqPtr_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // True if the kernel implements every opcode the copy path uses
+    bool supportsCopyOps() {
+        constexpr unsigned kProbeOps = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, kProbeOps) < 0) {
+            return false;
+        }
+        for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE,
+                       IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Next free submission slot, zeroed. A full ring is submitted first to
+    // make room; nullptr only if that fails.
+    io_uring_sqe* sqe() {
+        unsigned tail = *sqTail_;
+        unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (tail - head >= sqEntries_) {
+            if (!submitQueued()) return nullptr;
+            head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+            if (tail - head >= sqEntries_) return nullptr;
+        }
+        unsigned index = tail & sqMask_;
+        io_uring_sqe* entry = &sqes_[index];
+        std::memset(entry, 0, sizeof(*entry));
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        queued_++;
+        pending_++;
+        return entry;
+    }
+
+    // Submissions whose completion hasn't been reaped yet
+    unsigned pending() const { return pending_; }
+
+    // Submit everything queued and wait for `count` completions, passing
+    // each (user_data, result) to handler. Returns false on a ring error.
+    template <class F> bool submitAndReap(unsigned count, F&& handler) {
+        unsigned reaped = 0;
+        while (reaped < count) {
+            unsigned wait = 0;
+            {
+                unsigned head = *cqHead_;
+                unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+                if (head == tail) wait = 1;
+            }
+            if (queued_ > 0 || wait) {
+                long ret = syscall(__NR_io_uring_enter, fd_, queued_, wait,
+                                   wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (ret < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                    return false;
+                }
+                queued_ -= static_cast<unsigned>(ret);
+            }
+
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            while (head != tail) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                handler(cqe.user_data, cqe.res);
+                head++;
+                reaped++;
+                pending_--;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    bool submitQueued() {
+        while (queued_ > 0) {
+            long ret = syscall(__NR_io_uring_enter, fd_, queued_, 0, 0, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            queued_ -= static_cast<unsigned>(ret);
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+    void* sqPtr_ = nullptr;
+    void* cqPtr_ = nullptr;
+    size_t sqSize_ = 0;
+    size_t cqSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned queued_ = 0;
+    unsigned pending_ = 0;
+};
+
+// Probed once: io_uring can be compiled in but blocked at runtime
+// (old kernel, seccomp in containers, kernel.io_uring_disabled)
+bool probeIoUring() {
+    static std::once_flag once;
+    static bool usable = false;
+    std::call_once(once, [] {
+        Ring ring;
+        usable = ring.init(8) && ring.supportsCopyOps();
+    });
+    return usable;
+}
+
+// One ring per worker thread, created on first use
+Ring* threadRing() {
+    thread_local std::unique_ptr<Ring> ring;
+    thread_local bool failed = false;
+    // A ring that couldn't be drained after an error is given up on
+    if (ring && ring->pending() > 0) ring.reset();
+    if (!ring && !failed) {
+        auto candidate = std::make_unique<Ring>();
+        if (candidate->init(kRingEntries)) {
+            ring = std::move(candidate);
+        } else {
+            failed = true;
+        }
+    }
+    return ring.get();
+}
+
+enum OpKind : uint64_t { kOpenSource, kStat, kOpenDest, kRead, kWrite, kCloseSource, kCloseDest };
+
+uint64_t tag(size_t file, OpKind kind) { return (static_cast<uint64_t>(file) << 3) | kind; }
+
+struct FileState {
+    std::string source;
+    std::string dest;
+    int sourceFd = -1;
+    int destFd = -1;
+    struct statx stat;
+    char* buffer = nullptr;
+    int64_t bytesRead = 0;
+    int64_t bytesWritten = 0;
+    bool fallback = false;  // Copy with fs::copy_file afterwards
+};
+
+// Finish a short read or write synchronously (rare: signals, odd filesystems)
+bool completeSync(FileState& file, uint64_t size) {
+    while (file.bytesRead < static_cast<int64_t>(size)) {
+        ssize_t got = pread(file.sourceFd, file.buffer + file.bytesRead,
+                            size - file.bytesRead, file.bytesRead);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        file.bytesRead += got;
+    }
+    while (file.bytesWritten < file.bytesRead) {
+        ssize_t put = pwrite(file.destFd, file.buffer + file.bytesWritten,
+                             file.bytesRead - file.bytesWritten, file.bytesWritten);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        file.bytesWritten += put;
+    }
+    return true;
+}
+
+// Copy up to kBatchFiles files in four round trips:
+//   open source + statx, open dest + read, write + close source, close dest
+bool copyBatchIoUring(Ring& ring, std::vector<FileState>& files, std::vector<char>& arena) {
+    bool ringOk = true;
+
+    // Stage 1: open sources and stat them
+    for (size_t i = 0; i < files.size(); ++i) {
+        io_uring_sqe* open = ring.sqe();
+        if (!open) return false;
+        open->opcode = IORING_OP_OPENAT;
+        open->fd = AT_FDCWD;
+        open->addr = reinterpret_cast<uint64_t>(files[i].source.c_str());
+        open->open_flags = O_RDONLY | O_CLOEXEC;
+        open->user_data = tag(i, kOpenSource);
+
+        io_uring_sqe* st = ring.sqe();
+        if (!st) return false;
+        st->opcode = IORING_OP_STATX;
+        st->fd = AT_FDCWD;
+        st->addr = reinterpret_cast<uint64_t>(files[i].source.c_str());
+        st->len = STATX_SIZE | STATX_MODE;
+        st->off = reinterpret_cast<uint64_t>(&files[i].stat);
+        st->statx_flags = AT_STATX_SYNC_AS_STAT;
+        st->user_data = tag(i, kStat);
+    }
+    ringOk = ring.submitAndReap(static_cast<unsigned>(files.size() * 2), [&](uint64_t data, int res) {
+        FileState& file = files[data >> 3];
+        if ((data & 7) == kOpenSource) {
+            if (res >= 0) file.sourceFd = res;
+            else file.fallback = true;
+        } else if (res < 0) {
+            file.fallback = true;
+        }
+    });
+    if (!ringOk) return false;
+
+    // Only regular files small enough for the arena stay on this path
+    size_t arenaBytes = 0;
+    for (auto& file : files) {
+        if (file.fallback) continue;
+        if (!S_ISREG(file.stat.stx_mode) || file.stat.stx_size > kMaxInlineBytes) {
+            file.fallback = true;
+            continue;
+        }
+        arenaBytes += file.stat.stx_size;
+    }
+    if (arena.size() < arenaBytes) arena.resize(arenaBytes);
+    size_t offset = 0;
+    for (auto& file : files) {
+        if (file.fallback) continue;
+        file.buffer = arena.data() + offset;
+        offset += file.stat.stx_size;
+    }
+
+    // Stage 2: open destinations and read sources
+    unsigned expected = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileState& file = files[i];
+        if (file.fallback) {
+            if (file.sourceFd >= 0) {
+                io_uring_sqe* closeSource = ring.sqe();
+                if (!closeSource) return false;
+                closeSource->opcode = IORING_OP_CLOSE;
+                closeSource->fd = file.sourceFd;
+                closeSource->user_data = tag(i, kCloseSource);
+                file.sourceFd = -1;
+                expected++;
+            }
+            continue;
+        }
+        io_uring_sqe* open = ring.sqe();
+        if (!open) return false;
+        open->opcode = IORING_OP_OPENAT;
+        open->fd = AT_FDCWD;
+        open->addr = reinterpret_cast<uint64_t>(file.dest.c_str());
+        open->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        open->len = file.stat.stx_mode & 07777;
+        open->user_data = tag(i, kOpenDest);
+        expected++;
+
+        if (file.stat.stx_size > 0) {
+            io_uring_sqe* read = ring.sqe();
+            if (!read) return false;
+            read->opcode = IORING_OP_READ;
+            read->fd = file.sourceFd;
+            read->addr = reinterpret_cast<uint64_t>(file.buffer);
+            read->len = static_cast<uint32_t>(file.stat.stx_size);
+            read->off = 0;
+            read->user_data = tag(i, kRead);
+            expected++;
+        }
+    }
+    ringOk = ring.submitAndReap(expected, [&](uint64_t data, int res) {
+        FileState& file = files[data >> 3];
+        switch (data & 7) {
+        case kOpenDest:
+            if (res >= 0) file.destFd = res;
+            else file.fallback = true;
+            break;
+        case kRead:
+            if (res >= 0) file.bytesRead = res;
+            else file.fallback = true;
+            break;
+        default:
+            break;
+        }
+    });
+    if (!ringOk) return false;
+
+    // Stage 3: write destinations and close sources
+    expected = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileState& file = files[i];
+        if (!file.fallback && file.bytesRead > 0) {
+            io_uring_sqe* write = ring.sqe();
+            if (!write) return false;
+            write->opcode = IORING_OP_WRITE;
+            write->fd = file.destFd;
+            write->addr = reinterpret_cast<uint64_t>(file.buffer);
+            write->len = static_cast<uint32_t>(file.bytesRead);
+            write->off = 0;
+            write->user_data = tag(i, kWrite);
+            expected++;
+        }
+    }
+    ringOk = ring.submitAndReap(expected, [&](uint64_t data, int res) {
+        FileState& file = files[data >> 3];
+        if (res >= 0) file.bytesWritten = res;
+        else file.fallback = true;
+    });
+    if (!ringOk) return false;
+
+    // Stage 4: close everything that is still open
+    expected = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileState& file = files[i];
+        if (!file.fallback && file.destFd >= 0 &&
+            (file.bytesRead != static_cast<int64_t>(file.stat.stx_size) ||
+             file.bytesWritten != file.bytesRead)) {
+            if (!completeSync(file, file.stat.stx_size)) file.fallback = true;
+        }
+        if (file.sourceFd >= 0) {
+            io_uring_sqe* closeSource = ring.sqe();
+            if (!closeSource) return false;
+            closeSource->opcode = IORING_OP_CLOSE;
+            closeSource->fd = file.sourceFd;
+            closeSource->user_data = tag(i, kCloseSource);
+            file.sourceFd = -1;
+            expected++;
+        }
+        if (file.destFd >= 0) {
+            io_uring_sqe* closeDest = ring.sqe();
+            if (!closeDest) return false;
+            closeDest->opcode = IORING_OP_CLOSE;
+            closeDest->fd = file.destFd;
+            closeDest->user_data = tag(i, kCloseDest);
+            file.destFd = -1;
+            expected++;
+        }
+    }
+    return ring.submitAndReap(expected, [&](uint64_t data, int res) {
+        if ((data & 7) == kCloseDest && res < 0) files[data >> 3].fallback = true;
+    });
+}
+
+size_t copyIoUring(Ring& ring, const std::vector<std::pair<fs::path, fs::path>>& jobs,
+                   std::vector<std::string>* errorsOut) {
+    size_t failed = 0;
+    std::vector<FileState> files;
+    std::vector<char> arena;
+
+    const size_t batchFiles = std::min(kBatchFiles, g_batchFiles.load());
+    for (size_t start = 0; start < jobs.size(); start += batchFiles) {
+        size_t end = std::min(jobs.size(), start + batchFiles);
+        files.assign(end - start, FileState());
+        for (size_t i = start; i < end; ++i) {
+            files[i - start].source = jobs[i].first.string();
+            files[i - start].dest = jobs[i].second.string();
+            unlinkDest(jobs[i].second);
+        }
+
+        if (!copyBatchIoUring(ring, files, arena)) {
+            // The ring itself failed. Requests already submitted still point
+            // at files and arena, so wait for them before anything is freed
+            // (keeping any descriptor they opened); if even that fails, the
+            // buffers are leaked rather than left for the kernel to write into.
+            bool drained = ring.submitAndReap(ring.pending(), [&](uint64_t data, int res) {
+                FileState& file = files[data >> 3];
+                if ((data & 7) == kOpenSource && res >= 0) file.sourceFd = res;
+                if ((data & 7) == kOpenDest && res >= 0) file.destFd = res;
+            });
+            if (!drained) {
+                new std::vector<FileState>(std::move(files));
+                new std::vector<char>(std::move(arena));
+                std::vector<std::pair<fs::path, fs::path>> rest(jobs.begin() + start, jobs.end());
+                return failed + copySequential(rest, errorsOut);
+            }
+            // Descriptors may be left open, so close what we know about and
+            // redo this batch the slow way
+            for (auto& file : files) {
+                if (file.sourceFd >= 0) close(file.sourceFd);
+                if (file.destFd >= 0) close(file.destFd);
+            }
+            std::vector<std::pair<fs::path, fs::path>> rest(jobs.begin() + start, jobs.end());
+            return failed + copySequential(rest, errorsOut);
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            if (!files[i - start].fallback) {
+                t_bytesPlaced += static_cast<uint64_t>(files[i - start].bytesWritten);
+                continue;
+            }
+            std::string error;
+            if (!copyWithFilesystem(jobs[i].first, jobs[i].second, error)) {
+                failed++;
+                if (errorsOut) errorsOut->push_back(error);
+            }
+        }
+        if (!reportProgress(end - start)) return failed + failCancelled(jobs.size() - end, errorsOut);
+    }
+    return failed;
+}
+
+#endif // NEXUSBRIDGE_HAVE_IO_URING
+
+} // namespace
+
+void CopyBatch::add(const fs::path& source, const fs::path& dest) {
+    std::string key = dest.lexically_normal().string();
+    if (caseInsensitiveDest_) CaseFold::foldInPlace(&key[0], key.size());
+    auto it = byDest_.find(key);
+    if (it != byDest_.end()) {
+        jobs_[it->second].first = source;
+        return;
+    }
+    byDest_.emplace(std::move(key), jobs_.size());
+    jobs_.emplace_back(source, dest);
+}
+
+void CopyBatch::addTree(const fs::path& source, const fs::path& dest) {
+    std::error_code ec;
+    if (fs::is_regular_file(source, ec)) {
+        add(source, dest);
+        return;
+    }
+    fs::create_directories(dest, ec);
+    DirWalker::Options options;
+    options.includeDirectories = true;
+    DirWalker::Listing listing = DirWalker::walk(source, options);
+    jobs_.reserve(jobs_.size() + listing.size());
+    for (const auto& entry : listing) {
+        fs::path target = dest / DirWalker::toPath(entry.relative);
+        if (entry.isDirectory()) {
+            fs::create_directories(target, ec);
+        } else {
+            add(listing.path(entry), target);
+        }
+    }
+}
+
+size_t CopyBatch::run(std::vector<std::string>* errorsOut) {
+    std::vector<std::pair<fs::path, fs::path>> jobs;
+    jobs.swap(jobs_);
+    byDest_.clear();
+    if (jobs.empty()) return 0;
+
+    size_t failed = 0;
+    bool copied = false;
+#ifdef NEXUSBRIDGE_HAVE_IO_URING
+    if (jobs.size() >= kMinBatchJobs && !t_sequential && ioUringAvailable()) {
+        if (Ring* ring = threadRing()) {
+            failed = copyIoUring(*ring, jobs, errorsOut);
+            copied = true;
+        }
+    }
+#endif
+    if (!copied) failed = copySequential(jobs, errorsOut);
+
+    if (g_cacheFriendly) {
+        for (const auto& [source, dest] : jobs) {
+            dropCachedPages(source);
+            dropCachedPages(dest, true);
+        }
+    }
+    return failed;
+}
+
+bool ioUringAvailable() {
+#ifdef NEXUSBRIDGE_HAVE_IO_URING
+    return g_ioUringEnabled && probeIoUring();
+#else
+    return false;
+#endif
+}
+
+void setIoUringEnabled(bool enabled) {
+    g_ioUringEnabled = enabled;
+}
+
+const char* backendName() {
+    return ioUringAvailable() ? "io_uring" : "copy_file";
+}
+
+void setThreadProgressHook(std::function<bool(size_t filesDone)> hook) {
+    t_progressHook = std::move(hook);
+}
+
+void setThreadSequential(bool sequential) {
+    t_sequential = sequential;
+}
+
+uint64_t threadBytesPlaced() {
+    return t_bytesPlaced;
+}
+
+void notePlaced(uint64_t bytes) {
+    t_bytesPlaced += bytes;
+}
+
+void setMaxBatchFiles(size_t files) {
+    g_batchFiles = std::max<size_t>(1, files);
+}
+
+void setCacheFriendly(bool enabled) {
+    g_cacheFriendly = enabled;
+}
+
+bool cacheFriendly() {
+    return g_cacheFriendly;
+}
+
+void dropCachedPages(const fs::path& file, bool written) {
+#ifdef __linux__
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+    if (fd < 0 && errno == EPERM) fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (written) {
+        sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                      SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#else
+    (void)file;
+    (void)written;
+#endif
+}
+
+} // namespace CopyEngine
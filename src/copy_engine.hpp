@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace CopyEngine {
+
+// Collects file copies and performs them together. On Linux, small files
+// go through io_uring in batches (open/statx/read/write/close for many
+// files per syscall); everything else uses fs::copy_file.
+//
+// Destinations are replaced: an existing file is unlinked first, so other
+// names hardlinked to it (--dedup) keep their content. If the same
+// destination is queued twice the later source wins, as it would with
+// sequential copies. Directories must exist by the time run() is called
+// (addTree creates them).
+class CopyBatch {
+public:
+    void add(const fs::path& source, const fs::path& dest);
+
+    // Queue every file under source, recreating its folders under dest
+    // (like fs::copy with recursive | overwrite_existing)
+    void addTree(const fs::path& source, const fs::path& dest);
+
+    // Treat destinations that differ only in case as the same file (for
+    // case-folding destination folders, where they are)
+    void setCaseInsensitiveDest(bool enabled) { caseInsensitiveDest_ = enabled; }
+
+    size_t size() const { return jobs_.size(); }
+    bool empty() const { return jobs_.empty(); }
+
+    // Copy everything queued and clear the batch. Returns the number of
+    // files that could not be copied; their errors go to errorsOut.
+    size_t run(std::vector<std::string>* errorsOut = nullptr);
+
+private:
+    std::vector<std::pair<fs::path, fs::path>> jobs_;
+    std::unordered_map<std::string, size_t> byDest_;
+    bool caseInsensitiveDest_ = false;
+};
+
+// True if io_uring is compiled in, enabled, and usable on this kernel
+bool ioUringAvailable();
+
+// Turn the io_uring backend off (e.g. --no-io-uring)
+void setIoUringEnabled(bool enabled);
+
+// "io_uring" or "copy_file", for logging
+const char* backendName();
+
+// Per-thread progress hook, called as files finish (with how many just
+// did), and with 0 between chunks of a large file (64 MB and up, which
+// are copied in pieces while a hook is set). Returning false cancels the
+// rest of the run; those files count as failed. Lets a watchdog see
+// copies moving and stop abandoned installs.
+void setThreadProgressHook(std::function<bool(size_t filesDone)> hook);
+
+// Files copied together in one io_uring batch, each holding two open
+// descriptors until the batch is done (default and maximum 64)
+void setMaxBatchFiles(size_t files);
+
+// Use plain fs::copy_file on this thread regardless of io_uring
+void setThreadSequential(bool sequential);
+
+// Bytes this thread has placed so far: everything its batches copied,
+// plus what callers that move files into place instead report with
+// notePlaced. Take the difference around a piece of work for its total.
+uint64_t threadBytesPlaced();
+void notePlaced(uint64_t bytes);
+
+// Keep copies out of the page cache (--background): after each batch,
+// written files are flushed and both sides are dropped from the cache, so
+// an install doesn't evict what the rest of the machine is using. Sources
+// still waiting to be written back (fresh 7z output) are left alone; they
+// go when their staging folder is deleted.
+void setCacheFriendly(bool enabled);
+bool cacheFriendly();
+
+// Drop file's pages from the page cache; with written, flush it to disk
+// first (dirty pages can't be dropped). Linux only; a no-op elsewhere.
+void dropCachedPages(const fs::path& file, bool written = false);
+
+} // namespace CopyEngine
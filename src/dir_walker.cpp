@@ -0,0 +1,361 @@
+#include "dir_walker.hpp"
+#include "case_fold.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef FS_CASEFOLD_FL
+#define FS_CASEFOLD_FL 0x40000000  // Older kernel headers
+#endif
+#endif
+
+namespace DirWalker {
+
+fs::path toPath(std::string_view utf8) {
+#ifdef _WIN32
+    return fs::u8path(utf8.begin(), utf8.end());
+#else
+    return fs::path(std::string(utf8));
+#endif
+}
+
+Entry Listing::operator[](size_t i) const {
+    const Record& record = records_[i];
+    std::string_view all(names_);
+    return Entry{all.substr(record.offset, record.length),
+                 all.substr(record.offset + record.nameOffset, record.length - record.nameOffset),
+                 record.type, record.depth, record.size};
+}
+
+size_t Listing::count(Type type) const {
+    return static_cast<size_t>(std::count_if(records_.begin(), records_.end(),
+                                             [type](const Record& r) { return r.type == type; }));
+}
+
+class Walker {
+public:
+    Walker(const Options& options, Listing& out) : options_(options), out_(out) {
+        out_.names_.reserve(64 * 1024);
+        out_.records_.reserve(1024);
+    }
+
+    bool wants(Type type) const {
+        switch (type) {
+        case Type::File: return options_.includeFiles;
+        case Type::Directory: return options_.includeDirectories;
+        default: return options_.includeOther;
+        }
+    }
+
+    void add(const std::string& relative, size_t nameOffset, Type type, uint32_t depth,
+             uint64_t size = 0) {
+        Listing::Record record;
+        record.offset = static_cast<uint32_t>(out_.names_.size());
+        record.length = static_cast<uint32_t>(relative.size());
+        record.nameOffset = static_cast<uint32_t>(nameOffset);
+        record.depth = depth;
+        record.size = size;
+        record.type = type;
+        out_.names_.append(relative);
+        out_.records_.push_back(record);
+    }
+
+    bool pruned(const std::string& relative, size_t nameOffset, uint32_t depth) const {
+        if (!options_.prune) return false;
+        std::string_view view(relative);
+        return options_.prune(Entry{view, view.substr(nameOffset), Type::Directory, depth, 0});
+    }
+
+    // Append another listing's records (its paths already carry the prefix)
+    void merge(const Listing& other) {
+        uint32_t base = static_cast<uint32_t>(out_.names_.size());
+        out_.names_.append(other.names_);
+        for (Listing::Record record : other.records_) {
+            record.offset += base;
+            out_.records_.push_back(record);
+        }
+    }
+
+#ifdef __linux__
+    // Lists one directory, then descends into its subdirectories.
+    // prefix is the directory's relative path with a trailing '/' (or empty).
+    // When collectSubdirs is set, subdirectories are returned instead of walked.
+    void walkDir(int dirFd, std::string& prefix, uint32_t depth,
+                 std::vector<std::string>* collectSubdirs = nullptr) {
+        struct LinuxDirent64 {
+            uint64_t d_ino;
+            int64_t d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[1];
+        };
+
+        std::vector<std::string> subdirs;
+        char buffer[16 * 1024];
+        while (true) {
+            long read = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+            if (read <= 0) break;
+            for (long pos = 0; pos < read;) {
+                auto* dirent = reinterpret_cast<LinuxDirent64*>(buffer + pos);
+                pos += dirent->d_reclen;
+                const char* name = dirent->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+
+                Type type = Type::Other;
+                uint64_t size = 0;
+                bool haveSize = false;
+                bool descend = true;
+                switch (dirent->d_type) {
+                case DT_REG: type = Type::File; break;
+                case DT_DIR: type = Type::Directory; break;
+                case DT_LNK:
+                case DT_UNKNOWN: {
+                    // Symlinks count as what they point to, but linked
+                    // folders aren't descended into (same as the
+                    // std::filesystem default)
+                    struct stat st;
+                    bool link = dirent->d_type == DT_LNK;
+                    bool known = fstatat(dirFd, name, &st, link ? 0 : AT_SYMLINK_NOFOLLOW) == 0;
+                    if (known && S_ISLNK(st.st_mode)) {
+                        link = true;
+                        known = fstatat(dirFd, name, &st, 0) == 0;
+                    }
+                    if (known) {
+                        size = static_cast<uint64_t>(st.st_size);
+                        haveSize = true;
+                        if (S_ISREG(st.st_mode)) {
+                            type = Type::File;
+                        } else if (S_ISDIR(st.st_mode)) {
+                            type = Type::Directory;
+                            descend = !link;
+                        }
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+
+                if (type == Type::Directory && descend) subdirs.emplace_back(name);
+                if (wants(type)) {
+                    if (type == Type::File && options_.sizes && !haveSize) {
+                        struct stat st;
+                        if (fstatat(dirFd, name, &st, 0) == 0) size = static_cast<uint64_t>(st.st_size);
+                    }
+                    if (type != Type::File) size = 0;
+                    size_t nameOffset = prefix.size();
+                    prefix.append(name);
+                    add(prefix, nameOffset, type, depth, size);
+                    prefix.resize(nameOffset);
+                }
+            }
+        }
+
+        if (!options_.recursive && !collectSubdirs) return;
+
+        for (const auto& name : subdirs) {
+            size_t nameOffset = prefix.size();
+            prefix.append(name);
+            if (!pruned(prefix, nameOffset, depth)) {
+                if (collectSubdirs) {
+                    collectSubdirs->push_back(prefix);
+                } else {
+                    int childFd = openat(dirFd, name.c_str(),
+                                         O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+                    if (childFd >= 0) {
+                        prefix.push_back('/');
+                        walkDir(childFd, prefix, depth + 1);
+                        close(childFd);
+                    }
+                }
+            }
+            prefix.resize(nameOffset);
+        }
+    }
+#else
+    // Paths are kept as UTF-8 (never the narrow code page), so names on
+    // Windows survive whatever characters they use
+    void walkGeneric(const fs::path& root) {
+        std::error_code ec;
+        std::string rootString = root.generic_u8string();
+        size_t skip = rootString.size() + (rootString.empty() || rootString.back() == '/' ? 0 : 1);
+        auto options = fs::directory_options::skip_permission_denied;
+        for (auto it = fs::recursive_directory_iterator(root, options, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            std::error_code typeEc;
+            Type type = Type::Other;
+            if (it->is_directory(typeEc)) type = Type::Directory;
+            else if (it->is_regular_file(typeEc)) type = Type::File;
+
+            // Linked folders aren't followed by the iterator either
+            std::string relative = it->path().generic_u8string().substr(skip);
+            size_t slash = relative.rfind('/');
+            size_t nameOffset = slash == std::string::npos ? 0 : slash + 1;
+            uint32_t depth = static_cast<uint32_t>(it.depth());
+
+            if (wants(type)) {
+                uint64_t size = 0;
+                if (type == Type::File && options_.sizes) size = it->file_size(typeEc);
+                add(relative, nameOffset, type, depth, typeEc ? 0 : size);
+            }
+            if (type == Type::Directory &&
+                (!options_.recursive || pruned(relative, nameOffset, depth))) {
+                it.disable_recursion_pending();
+            }
+        }
+    }
+#endif
+
+private:
+    const Options& options_;
+    Listing& out_;
+};
+
+Listing walk(const fs::path& root, const Options& options) {
+    Listing listing;
+    listing.root_ = root;
+    Walker walker(options, listing);
+
+#ifdef __linux__
+    int rootFd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0) return listing;
+
+    std::string prefix;
+    if (!options.recursive || options.threads <= 1) {
+        walker.walkDir(rootFd, prefix, 0);
+        close(rootFd);
+        return listing;
+    }
+
+    // Parallel: list the root here, then hand its subtrees to workers.
+    // Results are merged in directory order, same as a sequential walk.
+    std::vector<std::string> subdirs;
+    walker.walkDir(rootFd, prefix, 0, &subdirs);
+
+    std::vector<Listing> parts(subdirs.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        while (true) {
+            size_t i = next.fetch_add(1);
+            if (i >= subdirs.size()) break;
+            int fd = openat(rootFd, subdirs[i].c_str(),
+                            O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+            if (fd < 0) continue;
+            Walker partWalker(options, parts[i]);
+            std::string partPrefix = subdirs[i] + "/";
+            partWalker.walkDir(fd, partPrefix, 1);
+            close(fd);
+        }
+    };
+    unsigned threadCount = std::min<unsigned>(options.threads, static_cast<unsigned>(subdirs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) threads.emplace_back(worker);
+    for (auto& t : threads) t.join();
+    close(rootFd);
+
+    for (const auto& part : parts) walker.merge(part);
+#else
+    walker.walkGeneric(root);
+#endif
+    return listing;
+}
+
+Listing files(const fs::path& root, unsigned threads) {
+    Options options;
+    options.threads = threads;
+    return walk(root, options);
+}
+
+Listing children(const fs::path& dir) {
+    Options options;
+    options.recursive = false;
+    options.includeDirectories = true;
+    options.includeOther = true;
+    return walk(dir, options);
+}
+
+size_t countFiles(const fs::path& root) {
+    return walk(root).size();
+}
+
+fs::path findChildFolder(const fs::path& dir, std::string_view name) {
+    std::error_code ec;
+    fs::path direct = dir / toPath(name);
+    if (fs::is_directory(direct, ec)) return direct;
+    if (isCaseFolded(dir)) return fs::path();  // The lookup above ignored case
+
+    Options options;
+    options.recursive = false;
+    options.includeFiles = false;
+    options.includeDirectories = true;
+    for (const Entry& entry : walk(dir, options)) {
+        if (CaseFold::equals(entry.name, name)) return dir / toPath(entry.name);
+    }
+    return fs::path();
+}
+
+static std::atomic<bool> g_caseFoldChecks{false};
+
+bool hasCaseFoldFlag(const fs::path& dir) {
+#ifdef __linux__
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    int flags = 0;
+    bool folded = ioctl(fd, FS_IOC_GETFLAGS, &flags) == 0 && (flags & FS_CASEFOLD_FL) != 0;
+    close(fd);
+    return folded;
+#else
+    (void)dir;
+    return false;
+#endif
+}
+
+void enableCaseFoldChecks(bool enabled) {
+    g_caseFoldChecks.store(enabled, std::memory_order_relaxed);
+}
+
+bool isCaseFolded(const fs::path& dir) {
+    return g_caseFoldChecks.load(std::memory_order_relaxed) && hasCaseFoldFlag(dir);
+}
+
+bool makeCaseFolded(const fs::path& dir, std::string* error) {
+#ifdef __linux__
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int flags = 0;
+    bool ok = fd >= 0 && ioctl(fd, FS_IOC_GETFLAGS, &flags) == 0;
+    if (ok && !(flags & FS_CASEFOLD_FL)) {
+        flags |= FS_CASEFOLD_FL;
+        ok = ioctl(fd, FS_IOC_SETFLAGS, &flags) == 0;
+    }
+    int err = errno;
+    if (fd >= 0) close(fd);
+    if (!ok && error) {
+        switch (err) {
+        case ENOTEMPTY: *error = "folder is not empty"; break;
+        case EOPNOTSUPP:
+        case ENOTTY:
+        case EINVAL: *error = "filesystem has no casefold support"; break;
+        default: *error = std::strerror(err); break;
+        }
+    }
+    return ok;
+#else
+    (void)dir;
+    if (error) *error = "casefold folders are Linux-only";
+    return false;
+#endif
+}
+
+} // namespace DirWalker
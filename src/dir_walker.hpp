@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace DirWalker {
+
+enum class Type : uint8_t { File, Directory, Other };
+
+struct Options;
+
+// Listing paths are UTF-8 on every platform. Turn one (or part of one)
+// back into a path; a plain fs::path(std::string) would go through the
+// ANSI code page on Windows and mangle names outside it.
+fs::path toPath(std::string_view utf8);
+
+// One entry of a Listing. Views point into the listing's storage and are
+// valid as long as the listing is. Symlinks count as what they point to;
+// linked folders are listed but never descended into.
+struct Entry {
+    std::string_view relative;  // Relative to the root, '/' separated, UTF-8
+    std::string_view name;      // Last path component
+    Type type;
+    uint32_t depth;             // 0 = direct child of the root
+    uint64_t size;              // Files only, when Options::sizes is set
+
+    bool isFile() const { return type == Type::File; }
+    bool isDirectory() const { return type == Type::Directory; }
+};
+
+// Walk result: all paths live in one buffer, entries are fixed-size
+// records, so a 100k-entry tree costs a handful of allocations
+class Listing {
+public:
+    class Iterator {
+    public:
+        Iterator(const Listing* listing, size_t index) : listing_(listing), index_(index) {}
+        Entry operator*() const { return (*listing_)[index_]; }
+        Iterator& operator++() { ++index_; return *this; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+    private:
+        const Listing* listing_;
+        size_t index_;
+    };
+
+    const fs::path& root() const { return root_; }
+    size_t size() const { return records_.size(); }
+    bool empty() const { return records_.empty(); }
+
+    Entry operator[](size_t i) const;
+    fs::path path(size_t i) const { return root_ / toPath((*this)[i].relative); }
+    fs::path path(const Entry& entry) const { return root_ / toPath(entry.relative); }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, records_.size()); }
+
+    // Number of entries of the given type
+    size_t count(Type type) const;
+
+private:
+    friend class Walker;
+    friend Listing walk(const fs::path& root, const Options& options);
+
+    struct Record {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t nameOffset;
+        uint32_t depth;
+        uint64_t size;
+        Type type;
+    };
+
+    fs::path root_;
+    std::string names_;
+    std::vector<Record> records_;
+};
+
+struct Options {
+    bool recursive = true;
+    bool includeFiles = true;
+    bool includeDirectories = false;
+    bool includeOther = false;
+    // Also fill in file sizes (one stat per file, relative to its folder)
+    bool sizes = false;
+    // Called for each directory before descending; return true to skip
+    // its contents (the directory itself is still listed)
+    std::function<bool(const Entry&)> prune;
+    // Subdirectories of the root are walked on this many threads
+    unsigned threads = 1;
+};
+
+// List a directory tree. Uses getdents64 and d_type on Linux so no
+// per-entry stat is needed; other platforms use std::filesystem.
+// Unreadable directories are skipped; a missing root gives an empty listing.
+Listing walk(const fs::path& root, const Options& options = {});
+
+// Shorthands for the common cases
+Listing files(const fs::path& root, unsigned threads = 1);
+Listing children(const fs::path& dir);  // Files, folders and others, one level
+size_t countFiles(const fs::path& root);
+
+// Find a direct child folder of dir by case-insensitive name (empty if none)
+fs::path findChildFolder(const fs::path& dir, std::string_view name);
+
+// Case-folding directories (the ext4/f2fs "casefold" attribute, Linux
+// only): the kernel already matches names case-insensitively, so a direct
+// path lookup is as good as listing and comparing. New subdirectories
+// inherit the attribute.
+bool hasCaseFoldFlag(const fs::path& dir);
+
+// isCaseFolded answers false until this is turned on, so trees without
+// casefold don't pay for the check. Enable it once a casefolded mods or
+// temp folder has been found.
+void enableCaseFoldChecks(bool enabled);
+bool isCaseFolded(const fs::path& dir);
+
+// Give an empty directory the casefold attribute. The filesystem must have
+// casefold support (mkfs.ext4 -O casefold, or tune2fs on an unmounted one).
+bool makeCaseFolded(const fs::path& dir, std::string* error = nullptr);
+
+} // namespace DirWalker
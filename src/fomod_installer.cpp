@@ -1,23 +1,21 @@
 #include "fomod_installer.hpp"
+#include "case_fold.hpp"
+#include "copy_engine.hpp"
+#include "dir_walker.hpp"
 #include "../include/pugixml/pugixml.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <cctype>
 
 namespace FomodInstaller {
 
+// Trace log of the process() call running on this thread (null = off)
+static thread_local std::ostream* t_trace = nullptr;
+
 // Case-insensitive string comparison
-static bool iequals(const std::string& a, const std::string& b) {
-    if (a.size() != b.size()) return false;
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (std::tolower(static_cast<unsigned char>(a[i])) !=
-            std::tolower(static_cast<unsigned char>(b[i]))) {
-            return false;
-        }
-    }
-    return true;
+static bool iequals(std::string_view a, std::string_view b) {
+    return CaseFold::equals(a, b);
 }
 
 // Normalize path separators and case for comparison
@@ -47,23 +45,19 @@ static fs::path resolveCaseInsensitive(const fs::path& base, const std::string&
             continue;
         }
 
-        // Try case-insensitive match
-        std::string segmentLower = segment;
-        std::transform(segmentLower.begin(), segmentLower.end(), segmentLower.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
+        // On a case-folding folder the lookup above already ignored case
+        if (DirWalker::isCaseFolded(currentPath)) {
+            return fs::path();
+        }
 
+        // Try case-insensitive match
         bool found = false;
-        if (fs::exists(currentPath) && fs::is_directory(currentPath)) {
-            for (const auto& entry : fs::directory_iterator(currentPath)) {
-                std::string entryName = entry.path().filename().string();
-                std::string entryLower = entryName;
-                std::transform(entryLower.begin(), entryLower.end(), entryLower.begin(),
-                               [](unsigned char c) { return std::tolower(c); });
-                if (entryLower == segmentLower) {
-                    currentPath = entry.path();
-                    found = true;
-                    break;
-                }
+        DirWalker::Listing listing = DirWalker::children(currentPath);
+        for (const auto& entry : listing) {
+            if (iequals(entry.name, segment)) {
+                currentPath = listing.path(entry);
+                found = true;
+                break;
             }
         }
 
@@ -152,23 +146,17 @@ fs::path findModuleConfig(const fs::path& modRoot) {
     // Search recursively for fomod/ModuleConfig.xml
     // This handles archives with nested folder structures
     try {
-        for (const auto& entry : fs::recursive_directory_iterator(modRoot)) {
-            if (entry.is_regular_file()) {
-                std::string filename = entry.path().filename().string();
-                std::string lower = filename;
-                std::transform(lower.begin(), lower.end(), lower.begin(),
-                               [](unsigned char c) { return std::tolower(c); });
-
-                if (lower == "moduleconfig.xml") {
-                    // Verify it's in a fomod folder
-                    std::string parentName = entry.path().parent_path().filename().string();
-                    std::string parentLower = parentName;
-                    std::transform(parentLower.begin(), parentLower.end(), parentLower.begin(),
-                                   [](unsigned char c) { return std::tolower(c); });
-                    if (parentLower == "fomod") {
-                        return entry.path();
-                    }
-                }
+        DirWalker::Listing listing = DirWalker::files(modRoot);
+        for (const auto& entry : listing) {
+            if (!iequals(entry.name, "moduleconfig.xml")) continue;
+
+            // Verify it's in a fomod folder
+            std::string_view parent = entry.relative.substr(0, entry.relative.size() - entry.name.size());
+            if (!parent.empty()) parent.remove_suffix(1);
+            size_t slash = parent.rfind('/');
+            std::string parentName(slash == std::string_view::npos ? parent : parent.substr(slash + 1));
+            if (iequals(parentName, "fomod")) {
+                return listing.path(entry);
             }
         }
     } catch (const std::exception& e) {
@@ -178,9 +166,9 @@ fs::path findModuleConfig(const fs::path& modRoot) {
     return fs::path();
 }
 
-// Install a single file
+// Install a single file (queued; copied when the batch runs)
 static void installFile(const pugi::xml_node& fileNode, const fs::path& srcRoot,
-                        const fs::path& dstRoot) {
+                        const fs::path& dstRoot, CopyEngine::CopyBatch& batch) {
     std::string src = normalizePath(fileNode.attribute("source").as_string());
     std::string dst = fileNode.attribute("destination").as_string();
     // When destination is empty, use just the filename (not the full source path)
@@ -210,7 +198,10 @@ static void installFile(const pugi::xml_node& fileNode, const fs::path& srcRoot,
 
         if (fs::exists(sourcePath) && !fs::is_directory(sourcePath)) {
             fs::create_directories(destPath.parent_path());
-            fs::copy_file(sourcePath, destPath, fs::copy_options::overwrite_existing);
+            batch.add(sourcePath, destPath);
+            if (t_trace) *t_trace << "      file " << src << " -> " << dst << "\n";
+        } else if (t_trace) {
+            *t_trace << "      file " << src << " -> " << dst << ": not in the archive\n";
         }
     } catch (const std::exception& e) {
         std::cerr << "  [WARN] Failed to copy file: " << src << " -> " << dst
@@ -220,59 +211,49 @@ static void installFile(const pugi::xml_node& fileNode, const fs::path& srcRoot,
 
 // Find existing folder with case-insensitive match in destination
 static fs::path findExistingFolder(const fs::path& destDir, const std::string& folderName) {
-    if (!fs::exists(destDir) || !fs::is_directory(destDir)) {
-        return fs::path();
-    }
-
-    std::string nameLower = folderName;
-    std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-
-    for (const auto& entry : fs::directory_iterator(destDir)) {
-        if (entry.is_directory()) {
-            std::string entryName = entry.path().filename().string();
-            std::string entryLower = entryName;
-            std::transform(entryLower.begin(), entryLower.end(), entryLower.begin(),
-                           [](unsigned char c) { return std::tolower(c); });
-            if (entryLower == nameLower) {
-                return entry.path();
-            }
-        }
-    }
-    return fs::path();
+    return DirWalker::findChildFolder(destDir, folderName);
 }
 
-// Recursively copy directory with case-insensitive merging
-static void copyDirMerge(const fs::path& src, const fs::path& dst) {
+// Recursively copy directory with case-insensitive merging. Folders are
+// created immediately so later merges see them; files go into the batch.
+static void copyDirMerge(const fs::path& src, const fs::path& dst, CopyEngine::CopyBatch& batch) {
     if (!fs::exists(dst)) {
         fs::create_directories(dst);
     }
 
-    for (const auto& entry : fs::directory_iterator(src)) {
-        std::string itemName = entry.path().filename().string();
+    // The kernel merges differently-cased folders on its own
+    if (DirWalker::isCaseFolded(dst)) {
+        batch.setCaseInsensitiveDest(true);
+        batch.addTree(src, dst);
+        return;
+    }
+
+    DirWalker::Listing listing = DirWalker::children(src);
+    for (const auto& entry : listing) {
+        std::string itemName(entry.name);
 
-        if (entry.is_directory()) {
+        if (entry.isDirectory()) {
             // Check for case-insensitive match in destination
             fs::path existingDir = findExistingFolder(dst, itemName);
             if (!existingDir.empty()) {
                 // Merge into existing folder
-                copyDirMerge(entry.path(), existingDir);
+                copyDirMerge(listing.path(entry), existingDir, batch);
             } else {
                 // Create new folder and copy
-                fs::path newDir = dst / itemName;
-                copyDirMerge(entry.path(), newDir);
+                fs::path newDir = dst / DirWalker::toPath(entry.name);
+                copyDirMerge(listing.path(entry), newDir, batch);
             }
         } else {
             // Copy file, overwriting if exists
-            fs::path target = dst / itemName;
-            fs::copy_file(entry.path(), target, fs::copy_options::overwrite_existing);
+            fs::path target = dst / DirWalker::toPath(entry.name);
+            batch.add(listing.path(entry), target);
         }
     }
 }
 
 // Install a folder recursively
 static void installFolder(const pugi::xml_node& folderNode, const fs::path& srcRoot,
-                          const fs::path& dstRoot) {
+                          const fs::path& dstRoot, CopyEngine::CopyBatch& batch) {
     std::string src = normalizePath(folderNode.attribute("source").as_string());
     std::string dst = folderNode.attribute("destination").as_string();
     dst = normalizePath(dst);
@@ -307,28 +288,37 @@ static void installFolder(const pugi::xml_node& folderNode, const fs::path& srcR
             }
 
             int copied = 0;
-            for (const auto& entry : fs::directory_iterator(sourcePath)) {
-                std::string itemName = entry.path().filename().string();
+            DirWalker::Listing listing = DirWalker::children(sourcePath);
+            for (const auto& entry : listing) {
+                std::string itemName(entry.name);
 
-                if (fs::is_directory(entry)) {
+                if (entry.isDirectory()) {
                     // Check for case-insensitive match in destination
                     fs::path existingDir = findExistingFolder(destPath, itemName);
                     if (!existingDir.empty()) {
                         // Merge into existing folder
-                        copyDirMerge(entry.path(), existingDir);
+                        copyDirMerge(listing.path(entry), existingDir, batch);
                     } else {
                         // Create new folder and copy
-                        fs::path target = destPath / itemName;
-                        copyDirMerge(entry.path(), target);
+                        fs::path target = destPath / DirWalker::toPath(entry.name);
+                        copyDirMerge(listing.path(entry), target, batch);
                     }
                 } else {
-                    fs::path target = destPath / itemName;
-                    fs::copy_file(entry.path(), target, fs::copy_options::overwrite_existing);
+                    fs::path target = destPath / DirWalker::toPath(entry.name);
+                    batch.add(listing.path(entry), target);
                 }
                 copied++;
             }
             std::cout << "        [folder] Copied " << copied << " items from " << sourcePath.filename() << std::endl;
+            if (t_trace) {
+                *t_trace << "      folder " << src << " -> " << (dst.empty() ? "(root)" : dst)
+                         << " (" << copied << " items)\n";
+            }
         } else {
+            if (t_trace) {
+                *t_trace << "      folder " << src << " -> " << (dst.empty() ? "(root)" : dst)
+                         << ": not in the archive\n";
+            }
             std::cerr << "        [WARN] Source folder not found: " << sourcePath << std::endl;
         }
     } catch (const std::exception& e) {
@@ -403,43 +393,47 @@ static bool evaluateDependencies(const pugi::xml_node& dependencies,
 
 // Install files from a conditional pattern
 static void installPatternFiles(const pugi::xml_node& pattern, const fs::path& srcRoot,
-                                 const fs::path& dstRoot) {
+                                 const fs::path& dstRoot, CopyEngine::CopyBatch& batch) {
     pugi::xml_node files = pattern.child("files");
     if (!files) return;
 
     for (pugi::xml_node file : files.children("file")) {
-        installFile(file, srcRoot, dstRoot);
+        installFile(file, srcRoot, dstRoot, batch);
     }
     for (pugi::xml_node folder : files.children("folder")) {
-        installFolder(folder, srcRoot, dstRoot);
+        installFolder(folder, srcRoot, dstRoot, batch);
     }
 }
 
 // Install files from a plugin node
 static void installPluginFiles(const pugi::xml_node& plugin, const fs::path& srcRoot,
-                                const fs::path& dstRoot) {
+                                const fs::path& dstRoot, CopyEngine::CopyBatch& batch) {
     // Check for <files> container
     pugi::xml_node filesNode = plugin.child("files");
     if (filesNode) {
         for (pugi::xml_node file : filesNode.children("file")) {
-            installFile(file, srcRoot, dstRoot);
+            installFile(file, srcRoot, dstRoot, batch);
         }
         for (pugi::xml_node folder : filesNode.children("folder")) {
-            installFolder(folder, srcRoot, dstRoot);
+            installFolder(folder, srcRoot, dstRoot, batch);
         }
     } else {
         // Files might be direct children
         for (pugi::xml_node file : plugin.children("file")) {
-            installFile(file, srcRoot, dstRoot);
+            installFile(file, srcRoot, dstRoot, batch);
         }
         for (pugi::xml_node folder : plugin.children("folder")) {
-            installFolder(folder, srcRoot, dstRoot);
+            installFolder(folder, srcRoot, dstRoot, batch);
         }
     }
 }
 
 bool process(const std::string& sourceRoot, const std::string& destRoot,
-             const FomodChoices& choices) {
+             const FomodChoices& choices, std::ostream* trace) {
+    struct TraceScope {
+        explicit TraceScope(std::ostream* trace) { t_trace = trace; }
+        ~TraceScope() { t_trace = nullptr; }
+    } traceScope(trace);
 
     fs::path xmlPath = findModuleConfig(sourceRoot);
     if (xmlPath.empty()) {
@@ -453,6 +447,7 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
     // xmlPath = .../fomod/ModuleConfig.xml, so parent.parent = data root
     fs::path srcRoot = xmlPath.parent_path().parent_path();
     std::cout << "    Source root: " << srcRoot << std::endl;
+    if (t_trace) *t_trace << "FOMOD " << xmlPath.string() << "\n  source root " << srcRoot.string() << "\n";
 
     // Load XML with pugixml - handle various encodings including UTF-16
     pugi::xml_document doc;
@@ -490,6 +485,7 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
 
     if (!result) {
         std::cerr << "  [ERROR] Failed to parse XML: " << result.description() << std::endl;
+        if (t_trace) *t_trace << "  XML parse error: " << result.description() << "\n";
         return false;
     }
 
@@ -499,6 +495,10 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
     // Track flags set by selected plugins for conditional installs
     std::map<std::string, std::string> flags;
 
+    // File copies are collected here and performed together at the end;
+    // a later install of the same destination still wins
+    CopyEngine::CopyBatch batch;
+
     // Get root config element
     pugi::xml_node config = doc.child("config");
     if (!config) {
@@ -516,11 +516,12 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
     pugi::xml_node requiredFiles = config.child("requiredInstallFiles");
     if (requiredFiles) {
         std::cout << "  Installing required files..." << std::endl;
+        if (t_trace) *t_trace << "  required files\n";
         for (pugi::xml_node file : requiredFiles.children("file")) {
-            installFile(file, srcRoot, dstRoot);
+            installFile(file, srcRoot, dstRoot, batch);
         }
         for (pugi::xml_node folder : requiredFiles.children("folder")) {
-            installFolder(folder, srcRoot, dstRoot);
+            installFolder(folder, srcRoot, dstRoot, batch);
         }
     }
 
@@ -546,6 +547,8 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
                 // Get selected options for this step+group combination
                 std::set<std::string> selectedOptions = choices.getSelectedOptions(stepName, groupName);
                 std::cout << " (" << selectedOptions.size() << " selected)" << std::endl;
+                if (t_trace) *t_trace << "  step \"" << stepName << "\" group \"" << groupName << "\"\n";
+                std::set<std::string> unmatched = selectedOptions;
 
                 pugi::xml_node plugins = group.child("plugins");
                 if (!plugins) continue;
@@ -563,19 +566,29 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
                     for (const auto& selected : selectedOptions) {
                         if (iequals(selected, pluginName)) {
                             isSelected = true;
+                            unmatched.erase(selected);
                             break;
                         }
                     }
+                    if (t_trace) {
+                        *t_trace << "    [" << (isSelected ? 'x' : ' ') << "] "
+                                 << (pluginName.empty() ? "(default)" : pluginName) << "\n";
+                    }
 
                     if (isSelected) {
                         std::cout << "      [+] Installing: " << (pluginName.empty() ? "(default)" : pluginName) << std::flush;
                         // Collect flags from selected plugin for conditional installs
                         collectPluginFlags(plugin, flags);
-                        installPluginFiles(plugin, srcRoot, dstRoot);
+                        installPluginFiles(plugin, srcRoot, dstRoot, batch);
                         std::cout << " - done" << std::endl;
                     }
                     pluginIndex++;
                 }
+                if (t_trace) {
+                    for (const auto& name : unmatched) {
+                        *t_trace << "    chosen in the collection but not offered here: " << name << "\n";
+                    }
+                }
             }
         }
     }
@@ -594,23 +607,43 @@ bool process(const std::string& sourceRoot, const std::string& destRoot,
             std::cout << std::endl;
         }
 
+        if (t_trace) {
+            *t_trace << "  conditional installs, flags:";
+            for (const auto& [name, value] : flags) *t_trace << " " << name << "=" << value;
+            *t_trace << "\n";
+        }
+
         pugi::xml_node patterns = conditionalInstalls.child("patterns");
         if (patterns) {
+            int patternNumber = 0;
             for (pugi::xml_node pattern : patterns.children("pattern")) {
+                patternNumber++;
                 pugi::xml_node dependencies = pattern.child("dependencies");
                 if (dependencies) {
-                    if (evaluateDependencies(dependencies, flags)) {
+                    bool matched = evaluateDependencies(dependencies, flags);
+                    if (t_trace) {
+                        *t_trace << "    pattern " << patternNumber << ": "
+                                 << (matched ? "matched" : "not matched") << "\n";
+                    }
+                    if (matched) {
                         std::cout << "      [+] Pattern matched, installing files..." << std::endl;
-                        installPatternFiles(pattern, srcRoot, dstRoot);
+                        installPatternFiles(pattern, srcRoot, dstRoot, batch);
                     }
                 } else {
                     // No dependencies = always install
-                    installPatternFiles(pattern, srcRoot, dstRoot);
+                    installPatternFiles(pattern, srcRoot, dstRoot, batch);
                 }
             }
         }
     }
 
+    std::vector<std::string> copyErrors;
+    batch.run(&copyErrors);
+    for (const auto& error : copyErrors) {
+        std::cerr << "  [WARN] Failed to copy file: " << error << std::endl;
+        if (t_trace) *t_trace << "  copy failed: " << error << "\n";
+    }
+
     return true;
 }
 
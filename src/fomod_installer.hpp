@@ -5,6 +5,7 @@
 #include <map>
 #include <set>
 #include <filesystem>
+#include <ostream>
 #include "../include/nlohmann/json.hpp"
 
 namespace fs = std::filesystem;
@@ -51,9 +52,11 @@ FomodChoices parseChoices(const json& choicesJson);
 // sourceRoot: extracted mod directory containing fomod/ModuleConfig.xml
 // destRoot: destination directory for installed files
 // choices: parsed choices from collection.json
+// trace: if set, receives how each step, option and pattern was decided
+// and where every file and folder went
 // Returns true on success
 bool process(const std::string& sourceRoot, const std::string& destRoot,
-             const FomodChoices& choices);
+             const FomodChoices& choices, std::ostream* trace = nullptr);
 
 // Find ModuleConfig.xml in a mod directory (case-insensitive)
 fs::path findModuleConfig(const fs::path& modRoot);
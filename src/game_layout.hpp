@@ -0,0 +1,315 @@
+#pragma once
+
+// Per-game archive layout rules: which top-level folders are game data
+// (never unwrapped) and which loose files are readmes and other junk.
+//
+// The tables are built by the compiler: folder names and junk extensions
+// go into perfect hash sets, junk name fragments into an Aho-Corasick
+// automaton. Lookups fold case on the fly and never allocate. A table
+// that can't be built (duplicate or upper-case entry, too many states)
+// is a compile error, not a runtime surprise.
+
+#include "case_fold.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+namespace GameLayout {
+
+namespace detail {
+
+constexpr uint64_t hashFolded(std::string_view text, uint64_t seed) {
+    uint64_t h = 0xCBF29CE484222325ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(CaseFold::foldChar(c));
+        h *= 0x100000001B3ULL;
+    }
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+constexpr size_t slotCountFor(size_t keys) {
+    // n^2 slots makes a collision-free seed likely within a few tries;
+    // slots are one byte each, so this stays small
+    size_t slots = 16;
+    while (slots < keys * keys) slots *= 2;
+    return slots;
+}
+
+constexpr size_t totalLength(const std::string_view* items, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) total += items[i].size();
+    return total;
+}
+
+constexpr bool isFolded(std::string_view text) {
+    for (char c : text) {
+        if (CaseFold::foldChar(c) != c) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Non-template handle to a PerfectSet, so layouts of different sizes
+// share one type
+struct SetView {
+    const std::string_view* keys;
+    const uint8_t* slots;
+    uint64_t mask;
+    uint64_t seed;
+    size_t maxLength;
+
+    bool contains(std::string_view name) const {
+        if (name.empty() || name.size() > maxLength) return false;
+        uint8_t index = slots[detail::hashFolded(name, seed) & mask];
+        return index != 0xFF && CaseFold::equals(keys[index], name);
+    }
+};
+
+template <size_t N>
+class PerfectSet {
+    static_assert(N > 0 && N < 0xFF, "PerfectSet holds 1-254 keys");
+    static constexpr size_t kSlots = detail::slotCountFor(N);
+
+public:
+    constexpr explicit PerfectSet(const std::string_view (&keys)[N]) : keys_{}, slots_{} {
+        for (size_t i = 0; i < N; ++i) {
+            if (keys[i].empty() || !detail::isFolded(keys[i])) {
+                throw std::logic_error("PerfectSet keys must be non-empty and lower case");
+            }
+            keys_[i] = keys[i];
+            if (keys[i].size() > maxLength_) maxLength_ = keys[i].size();
+        }
+        for (uint64_t seed = 0; seed < 10000; ++seed) {
+            if (tryPlace(seed)) {
+                seed_ = seed;
+                return;
+            }
+        }
+        throw std::logic_error("PerfectSet: no collision-free seed (duplicate key?)");
+    }
+
+    constexpr SetView view() const {
+        return SetView{keys_.data(), slots_.data(), kSlots - 1, seed_, maxLength_};
+    }
+
+    bool contains(std::string_view name) const { return view().contains(name); }
+
+private:
+    constexpr bool tryPlace(uint64_t seed) {
+        for (auto& slot : slots_) slot = 0xFF;
+        for (size_t i = 0; i < N; ++i) {
+            uint8_t& slot = slots_[detail::hashFolded(keys_[i], seed) & (kSlots - 1)];
+            if (slot != 0xFF) return false;
+            slot = static_cast<uint8_t>(i);
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> keys_;
+    std::array<uint8_t, kSlots> slots_;
+    uint64_t seed_ = 0;
+    size_t maxLength_ = 0;
+};
+
+// Non-template handle to a SubstringMatcher
+struct MatcherView {
+    const uint8_t* classes;   // byte -> character class (0 = in no pattern)
+    const uint16_t* delta;    // state * stride + class -> next state
+    const bool* accepting;
+    size_t stride;            // Row width of delta
+
+    // True if any pattern occurs in text (case-insensitive)
+    bool matches(std::string_view text) const {
+        size_t state = 0;
+        for (char c : text) {
+            uint8_t cls = classes[static_cast<unsigned char>(CaseFold::foldChar(c))];
+            state = delta[state * stride + cls];
+            if (accepting[state]) return true;
+        }
+        return false;
+    }
+};
+
+// Aho-Corasick automaton over a fixed pattern list, with the failure links
+// folded into a dense transition table so matching is one lookup per byte.
+// States = total pattern length + 1 (the root).
+template <size_t States>
+class SubstringMatcher {
+    static constexpr size_t kMaxClasses = 48;
+
+public:
+    template <size_t N>
+    constexpr explicit SubstringMatcher(const std::string_view (&patterns)[N])
+        : classes_{}, delta_{}, accepting_{} {
+        if (detail::totalLength(patterns, N) + 1 != States) {
+            throw std::logic_error("SubstringMatcher: wrong state count");
+        }
+
+        // Only characters that appear in a pattern get their own class
+        classCount_ = 1;
+        for (size_t p = 0; p < N; ++p) {
+            if (patterns[p].empty() || !detail::isFolded(patterns[p])) {
+                throw std::logic_error("SubstringMatcher patterns must be non-empty and lower case");
+            }
+            for (char c : patterns[p]) {
+                uint8_t& cls = classes_[static_cast<unsigned char>(c)];
+                if (cls == 0) {
+                    if (classCount_ == kMaxClasses) {
+                        throw std::logic_error("SubstringMatcher: too many distinct characters");
+                    }
+                    cls = static_cast<uint8_t>(classCount_++);
+                }
+            }
+        }
+
+        // Trie
+        constexpr uint16_t kNone = 0xFFFF;
+        for (auto& next : delta_) next = kNone;
+        size_t used = 1;
+        for (size_t p = 0; p < N; ++p) {
+            size_t state = 0;
+            for (char c : patterns[p]) {
+                size_t cell = state * kMaxClasses + classes_[static_cast<unsigned char>(c)];
+                if (delta_[cell] == kNone) delta_[cell] = static_cast<uint16_t>(used++);
+                state = delta_[cell];
+            }
+            accepting_[state] = true;
+        }
+
+        // Breadth-first: resolve missing edges through failure links
+        std::array<uint16_t, States> fail{};
+        std::array<uint16_t, States> queue{};
+        size_t head = 0, tail = 0;
+        for (size_t cls = 0; cls < classCount_; ++cls) {
+            uint16_t& next = delta_[cls];
+            if (next == kNone) {
+                next = 0;
+            } else {
+                fail[next] = 0;
+                queue[tail++] = next;
+            }
+        }
+        while (head < tail) {
+            size_t state = queue[head++];
+            for (size_t cls = 0; cls < classCount_; ++cls) {
+                uint16_t& next = delta_[state * kMaxClasses + cls];
+                uint16_t viaFail = delta_[fail[state] * kMaxClasses + cls];
+                if (next == kNone) {
+                    next = viaFail;
+                } else {
+                    fail[next] = viaFail;
+                    accepting_[next] = accepting_[next] || accepting_[viaFail];
+                    queue[tail++] = next;
+                }
+            }
+        }
+    }
+
+    constexpr MatcherView view() const {
+        return MatcherView{classes_.data(), delta_.data(), accepting_.data(), kMaxClasses};
+    }
+
+    bool matches(std::string_view text) const { return view().matches(text); }
+
+private:
+    std::array<uint8_t, 256> classes_;
+    std::array<uint16_t, States * kMaxClasses> delta_;
+    std::array<bool, States> accepting_;
+    size_t classCount_ = 0;
+};
+
+// Everything the unwrapping heuristics need to know about a game
+struct Layout {
+    std::string_view name;
+    SetView dataFolders;   // Top-level folders that belong in Data/
+    SetView junkExtensions;
+    MatcherView junkNames; // Fragments that mark a readme/license/etc.
+
+    bool isDataFolder(std::string_view folder) const { return dataFolders.contains(folder); }
+
+    // Readmes, licenses, screenshots and the like, which shouldn't stop a
+    // wrapper folder from being unwrapped
+    bool isJunkFile(std::string_view file) const {
+        size_t dot = file.find_last_of('.');
+        if (dot != std::string_view::npos && junkExtensions.contains(file.substr(dot))) return true;
+        return junkNames.matches(file);
+    }
+};
+
+namespace tables {
+
+// Shared by every game
+inline constexpr std::string_view kJunkExtensions[] = {
+    ".txt", ".md",  ".pdf", ".doc",  ".docx", ".rtf", ".url",
+    ".ini", ".png", ".jpg", ".jpeg", ".bmp",  ".gif"};
+inline constexpr std::string_view kJunkNames[] = {
+    "readme",  "license", "changelog",   "credits",
+    "authors", "install", "instructions"};
+
+inline constexpr std::string_view kSkyrimFolders[] = {
+    "meshes",       "textures",      "scripts",        "sound",
+    "interface",    "strings",       "seq",            "grass",
+    "video",        "music",         "shaders",        "shadersfx",
+    "lodsettings",  "skse",          "netscriptframework",
+    "edit scripts", "dialogueviews", "facegen",        "caliente tools",
+    "actors",       "fonts",         "materials",      "platform",
+    "source",       "terrain",       "trees",          "vis",
+    "distantlod",   "lod",           "dyndolod",       "nemesis_engine"};
+
+inline constexpr std::string_view kFallout4Folders[] = {
+    "meshes",       "textures",      "scripts",        "sound",
+    "interface",    "strings",       "seq",            "video",
+    "music",        "shadersfx",     "lodsettings",    "f4se",
+    "mcm",          "edit scripts",  "materials",      "programs",
+    "source",       "terrain",       "vis",            "distantlod",
+    "lod",          "dyndolod",      "fonts",          "misc"};
+
+inline constexpr std::string_view kStarfieldFolders[] = {
+    "meshes",       "textures",      "scripts",        "sound",
+    "interface",    "strings",       "video",          "music",
+    "geometries",   "materials",     "particles",      "planetdata",
+    "terrain",      "sfse",          "edit scripts",   "lodsettings",
+    "shadersfx",    "misc",          "distantlod"};
+
+inline constexpr std::string_view kOblivionFolders[] = {
+    "meshes",       "textures",      "sound",          "music",
+    "menus",        "fonts",         "shaders",        "trees",
+    "distantlod",   "lsdata",        "video",          "obse",
+    "edit scripts", "ini"};
+
+inline constexpr PerfectSet kJunkExtensionSet(kJunkExtensions);
+inline constexpr SubstringMatcher<detail::totalLength(kJunkNames, std::size(kJunkNames)) + 1>
+    kJunkNameMatcher(kJunkNames);
+
+inline constexpr PerfectSet kSkyrimFolderSet(kSkyrimFolders);
+inline constexpr PerfectSet kFallout4FolderSet(kFallout4Folders);
+inline constexpr PerfectSet kStarfieldFolderSet(kStarfieldFolders);
+inline constexpr PerfectSet kOblivionFolderSet(kOblivionFolders);
+
+} // namespace tables
+
+inline constexpr Layout kSkyrimSE{"Skyrim", tables::kSkyrimFolderSet.view(),
+                                  tables::kJunkExtensionSet.view(), tables::kJunkNameMatcher.view()};
+inline constexpr Layout kFallout4{"Fallout 4", tables::kFallout4FolderSet.view(),
+                                  tables::kJunkExtensionSet.view(), tables::kJunkNameMatcher.view()};
+inline constexpr Layout kStarfield{"Starfield", tables::kStarfieldFolderSet.view(),
+                                   tables::kJunkExtensionSet.view(), tables::kJunkNameMatcher.view()};
+inline constexpr Layout kOblivion{"Oblivion", tables::kOblivionFolderSet.view(),
+                                  tables::kJunkExtensionSet.view(), tables::kJunkNameMatcher.view()};
+
+// Layout for a Nexus game domain; anything unknown gets the Skyrim rules
+inline const Layout& forDomain(std::string_view domain) {
+    if (domain == "fallout4" || domain == "fallout4vr") return kFallout4;
+    if (domain == "starfield") return kStarfield;
+    if (domain == "oblivion") return kOblivion;
+    return kSkyrimSE;
+}
+
+} // namespace GameLayout
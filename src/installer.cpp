@@ -1,9 +1,13 @@
 #pragma once
+#include "subprocess.hpp"
 #include <iostream>
-#include <cstdlib>
 #include <string>
 #include <filesystem>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 namespace fs = std::filesystem;
 
 class Installer {
@@ -22,8 +26,10 @@ public:
             const std::string bundled = "./7zzs";
             if (fs::exists(bundled)) {
                 // Ensure it's executable on Linux
-                std::string chmod = "chmod +x " + bundled;
-                (void)std::system(chmod.c_str());
+                struct stat st;
+                if (::stat(bundled.c_str(), &st) == 0 && (st.st_mode & S_IXUSR) == 0) {
+                    (void)::chmod(bundled.c_str(), st.st_mode | S_IXUSR | S_IXGRP | S_IXOTH);
+                }
                 return bundled;
             }
         #endif
@@ -36,9 +42,9 @@ public:
         if (!fs::exists(archivePath)) return false;
         if (!fs::exists(destPath)) fs::create_directories(destPath);
 
-        std::string cmd = get7zCommand() + " x \"" + archivePath + "\" -o\"" + destPath + "\" -y > /dev/null";
-        int ret = std::system(cmd.c_str());
-        return ret == 0;
+        Subprocess::Options options;
+        options.captureStderr = false;
+        return Subprocess::run({get7zCommand(), "x", archivePath, "-o" + destPath, "-y"}, options).ok();
     }
 
     static bool install(const std::string& archivePath, const std::string& modsDir, const std::string& modName) {
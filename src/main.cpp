@@ -1,6 +1,7 @@
 #include "json.h"
 #include "downloader.cpp"
 #include "installer.cpp"
+#include "subprocess.cpp"
 #include "fomod.cpp"
 #include "api_client.cpp"
 #include "console.h"
@@ -11,18 +11,38 @@
  */
 
 #include "../include/nlohmann/json.hpp"
+#include "background_qos.hpp"
+#include "bsa_writer.hpp"
+#include "case_fold.hpp"
+#include "cassette.hpp"
+#include "content_hash.hpp"
+#include "copy_engine.hpp"
+#include "dir_walker.hpp"
 #include "fomod_installer.hpp"
+#include "game_layout.hpp"
+#include "peer_cache.hpp"
+#include "resource_governor.hpp"
+#include "retry_policy.hpp"
+#include "run_report.hpp"
+#include "subprocess.hpp"
 #include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <climits>
 #include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <curl/curl.h>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iomanip>
 #include <iostream>
+#include <list>
 #include <map>
 #include <mutex>
 #include <numeric>
@@ -31,6 +51,8 @@
 #include <set>
 #include <sstream>
 #include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -57,6 +79,17 @@ bool isLongPathEnabled() {
 #else
   #include <unistd.h>
   #include <climits>
+  #include <fcntl.h>
+  #include <sys/file.h>
+  #include <sys/resource.h>
+  #include <sys/stat.h>
+  #ifdef __linux__
+    #include <linux/fs.h>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+  #endif
 #endif
 
 // libloot for plugin sorting
@@ -127,6 +160,29 @@ std::string trim(const std::string &str) {
   return str.substr(first, (last - first + 1));
 }
 
+// Case-insensitive glob match ('*' matches any run, '?' one character)
+bool globMatch(const std::string &pattern, const std::string &text) {
+  auto lower = CaseFold::foldChar;
+  size_t p = 0, t = 0;
+  size_t starP = std::string::npos, starT = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || lower(pattern[p]) == lower(text[t]))) {
+      ++p;
+      ++t;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      starP = p++;
+      starT = t;
+    } else if (starP != std::string::npos) {
+      p = starP + 1;
+      t = ++starT;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') ++p;
+  return p == pattern.size();
+}
+
 std::string urlEncode(const std::string &value) {
   std::ostringstream escaped;
   for (unsigned char c : value) {
@@ -189,7 +245,17 @@ std::string loadApiKey(const std::string &argKey) {
   return "";
 }
 
-std::string get7zCommand() {
+#ifndef _WIN32
+// Bundled 7zzs can lose its execute bit when unpacked from a zip
+static void ensureExecutable(const fs::path &path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0 && (st.st_mode & S_IXUSR) == 0) {
+    (void)::chmod(path.c_str(), st.st_mode | S_IXUSR | S_IXGRP | S_IXOTH);
+  }
+}
+#endif
+
+static std::string find7zCommand() {
 #ifdef _WIN32
   // First check for bundled 7z.exe (full version with RAR support)
   fs::path exeDir = getExecutableDir();
@@ -218,16 +284,13 @@ std::string get7zCommand() {
   fs::path exeDir = getExecutableDir();
   fs::path bundledPath = exeDir / exeName;
   if (fs::exists(bundledPath)) {
-    // Ensure it's executable on Linux
-    std::string chmod = "chmod +x " + bundledPath.string();
-    (void)std::system(chmod.c_str());
+    ensureExecutable(bundledPath);
     return bundledPath.string();
   }
 
   // Fallback: check current directory
   if (fs::exists(exeName)) {
-    std::string chmod = "chmod +x ./" + exeName;
-    (void)std::system(chmod.c_str());
+    ensureExecutable(exeName);
     return "./" + exeName;
   }
 
@@ -235,13 +298,27 @@ std::string get7zCommand() {
 #endif
 }
 
+// 7z location doesn't change during a run; look it up once
+std::string get7zCommand() {
+  static const std::string command = find7zCommand();
+  return command;
+}
+
 // ============================================================================
 // Mod Information Structures
 // ============================================================================
 
+// What the collection's hashes say about a file the mod ends up with,
+// beyond its path (either may be missing)
+struct ExpectedFile {
+  long long size = -1;
+  std::string md5;
+};
+
 struct ModInfo {
   std::string name;
   std::string logicalFilename;
+  std::string version;
   int modId = -1;
   int fileId = -1;
   long long fileSize = 0;
@@ -253,6 +330,7 @@ struct ModInfo {
   std::string sourceType; // "nexus" or "direct"
   std::string directUrl;  // URL for direct downloads (non-Nexus)
   std::vector<std::string> expectedPaths; // Expected file paths from collection hashes
+  std::vector<ExpectedFile> expectedFiles; // Size and MD5 of each, same order
 };
 
 struct ModRule {
@@ -392,6 +470,38 @@ static size_t WriteFileCallback(void *contents, size_t size, size_t nmemb,
   return fwrite(contents, size, nmemb, userp);
 }
 
+// Host the transfer ended up at after redirects: the one whose breaker
+// its result belongs to
+static std::string effectiveHost(CURL *curl) {
+  char *url = nullptr;
+  curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+  return url ? RetryPolicy::hostOf(url) : std::string();
+}
+
+// Archive body going to a file. The first bytes of a 2xx response tell
+// the host's circuit breaker it is up: a half-open breaker's probe may be
+// a multi-GB download, and other workers shouldn't wait for all of it.
+struct DownloadSink {
+  FILE *file = nullptr;
+  CURL *curl = nullptr;
+  RetryPolicy::Admission *admission = nullptr;
+  bool reported = false;
+};
+
+static size_t WriteDownloadCallback(void *contents, size_t size, size_t nmemb,
+                                    DownloadSink *sink) {
+  if (!sink->reported) {
+    long code = 0;
+    curl_easy_getinfo(sink->curl, CURLINFO_RESPONSE_CODE, &code);
+    if (code >= 200 && code < 300) {
+      sink->admission->record(RetryPolicy::ErrorClass::None, RetryPolicy::Millis(0),
+                              effectiveHost(sink->curl));
+      sink->reported = true;
+    }
+  }
+  return fwrite(contents, size, nmemb, sink->file);
+}
+
 static int ProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
                             curl_off_t /*ultotal*/, curl_off_t /*ulnow*/) {
   if (dltotal <= 0)
@@ -415,116 +525,698 @@ static int ProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
   return 0;
 }
 
-std::string httpGet(const std::string &url, const std::string &apiKey,
-                    long *httpCode = nullptr, int maxRetries = 3) {
+// Where performRequest reports failures: std::cerr, unless the thread is
+// collecting them to print later (see NexusAPI::fetchKeyInfo)
+thread_local std::ostream *t_requestLog = nullptr;
+
+static std::ostream &requestLog() {
+  return t_requestLog ? *t_requestLog : std::cerr;
+}
+
+// Runs a request under the retry policy. Transient and rate-limit
+// failures are retried after a jittered backoff (never sooner than the
+// server's Retry-After); permanent ones return straight away. configure()
+// sets up a fresh handle for every attempt. Every attempt goes to the
+// cassette when recording, and comes from it when replaying (method and
+// requestBody identify the request there). Returns the last response body.
+static std::string performRequest(const std::string &url, const char *method,
+                                  const std::string &requestBody,
+                                  const std::function<void(CURL *)> &configure,
+                                  long *httpCode, int maxAttempts,
+                                  RetryPolicy::ErrorClass *errorClass) {
   std::string response;
+  std::string host = RetryPolicy::hostOf(url);
+  RetryPolicy::Backoff backoff(std::chrono::seconds(1), std::chrono::seconds(30));
+  RetryPolicy::ErrorClass cls = RetryPolicy::ErrorClass::Transient;
+  long code = 0;
 
-  for (int attempt = 1; attempt <= maxRetries; ++attempt) {
+  for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
     response.clear();
-    CURL *curl = curl_easy_init();
+    code = 0;
+    RetryPolicy::Admission admission(host, std::chrono::minutes(2));
+    if (!admission) {
+      requestLog() << "  HTTP request failed: " << host
+                << " is unavailable (too many recent failures)" << std::endl;
+      break;
+    }
 
-    if (curl) {
-      struct curl_slist *headers = nullptr;
-      if (!apiKey.empty()) {
-        headers = curl_slist_append(headers, ("apikey: " + apiKey).c_str());
+    CURLcode res;
+    curl_off_t retryAfter = 0;
+    Cassette::Exchange exchange;
+    std::string redirectedTo;
+    if (Cassette::replaying()) {
+      if (!Cassette::replayRequest(method, url, requestBody, exchange)) {
+        requestLog() << "  HTTP request failed: not in the cassette: "
+                  << Cassette::redactUrl(url) << std::endl;
+        cls = RetryPolicy::ErrorClass::Local;
+        break;
       }
-      headers = curl_slist_append(headers, "User-Agent: NexusBridge/2.0");
-
-      curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+      res = static_cast<CURLcode>(exchange.curlCode);
+      code = exchange.httpCode;
+      retryAfter = exchange.retryAfter;
+      response = std::move(exchange.body);
+    } else {
+      CURL *curl = curl_easy_init();
+      if (!curl) {
+        cls = RetryPolicy::ErrorClass::Local;
+        break;
+      }
+      configure(curl);
       curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
       curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-      curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-      curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);  // 60 second timeout
-      curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);  // 30 second connect timeout
 
-      CURLcode res = curl_easy_perform(curl);
-
-      if (httpCode) {
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, httpCode);
-      }
-
-      curl_slist_free_all(headers);
+      auto started = std::chrono::steady_clock::now();
+      res = curl_easy_perform(curl);
+      curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+      curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+      redirectedTo = effectiveHost(curl);
       curl_easy_cleanup(curl);
 
-      if (res == CURLE_OK) {
-        return response;  // Success
+      if (Cassette::recording()) {
+        exchange.curlCode = res;
+        exchange.httpCode = code;
+        exchange.retryAfter = retryAfter;
+        exchange.body = response;
+        exchange.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started);
+        Cassette::recordRequest(method, url, requestBody, exchange);
       }
+    }
 
-      // Retry on timeout or connection errors
-      if (res == CURLE_OPERATION_TIMEDOUT || res == CURLE_COULDNT_CONNECT ||
-          res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_GOT_NOTHING) {
-        if (attempt < maxRetries) {
-          std::cerr << "  HTTP request failed (attempt " << attempt << "/" << maxRetries
-                    << "): " << curl_easy_strerror(res) << " - retrying..." << std::endl;
-          std::this_thread::sleep_for(std::chrono::seconds(2));
-          continue;
-        }
-      }
+    cls = RetryPolicy::classify(res, code);
+    std::chrono::seconds wait(static_cast<long long>(retryAfter));
+    admission.record(cls, wait, redirectedTo);
+    if (!RetryPolicy::retryable(cls)) break;
 
-      std::cerr << "  HTTP request failed: " << curl_easy_strerror(res)
-                << std::endl;
-      return response;  // Return empty on final failure
+    std::string why = res != CURLE_OK ? curl_easy_strerror(res)
+                                      : "HTTP " + std::to_string(code);
+    if (attempt == maxAttempts) {
+      requestLog() << "  HTTP request failed: " << why << std::endl;
+      break;
     }
+    auto delay = backoff.next(wait);
+    requestLog() << "  HTTP request failed (attempt " << attempt << "/" << maxAttempts
+              << "): " << why << " - retrying in "
+              << std::fixed << std::setprecision(1) << delay.count() / 1000.0
+              << "s..." << std::endl;
+    std::this_thread::sleep_for(delay);
+  }
+
+  if (httpCode) *httpCode = code;
+  if (errorClass) *errorClass = cls;
+  return response;
+}
+
+std::string httpGet(const std::string &url, const std::string &apiKey,
+                    long *httpCode = nullptr, int maxRetries = 3,
+                    RetryPolicy::ErrorClass *errorClass = nullptr) {
+  struct curl_slist *headers = nullptr;
+  if (!apiKey.empty()) {
+    headers = curl_slist_append(headers, ("apikey: " + apiKey).c_str());
   }
+  headers = curl_slist_append(headers, "User-Agent: NexusBridge/2.0");
+
+  std::string response = performRequest(url, "GET", "", [&](CURL *curl) {
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);  // 60 second timeout
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);  // 30 second connect timeout
+  }, httpCode, maxRetries, errorClass);
 
+  curl_slist_free_all(headers);
   return response;
 }
 
+// One attempt; errorClass (optional) says whether trying again could help.
+// The CDN host's circuit breaker is consulted and updated.
 bool downloadFile(const std::string &url, const std::string &destPath,
                   const std::string &filename = "",
-                  long long expectedSize = 0) {
-  CURL *curl = curl_easy_init();
-  if (!curl)
+                  long long expectedSize = 0,
+                  RetryPolicy::ErrorClass *errorClass = nullptr) {
+  auto fail = [&](RetryPolicy::ErrorClass cls) {
+    if (errorClass) *errorClass = cls;
     return false;
+  };
 
-  FILE *fp = fopen(destPath.c_str(), "wb");
-  if (!fp) {
-    curl_easy_cleanup(curl);
-    return false;
+  std::string host = RetryPolicy::hostOf(url);
+  RetryPolicy::Admission admission(host, std::chrono::minutes(2));
+  if (!admission) {
+    std::cerr << "  Download failed: " << host
+              << " is unavailable (too many recent failures)" << std::endl;
+    return fail(RetryPolicy::ErrorClass::Transient);
   }
 
-  DownloadProgress progress;
-  progress.filename = filename;
+  CURLcode res;
+  long httpCode = 0;
+  curl_off_t retryAfter = 0;
+  std::string redirectedTo;
+  std::chrono::milliseconds elapsed{0};
+  if (Cassette::replaying()) {
+    Cassette::Exchange exchange;
+    if (!Cassette::replayDownload(url, destPath, exchange)) {
+      std::cerr << "  Download failed: no recorded archive in the cassette" << std::endl;
+      return fail(RetryPolicy::ErrorClass::Local);
+    }
+    res = static_cast<CURLcode>(exchange.curlCode);
+    httpCode = exchange.httpCode;
+    retryAfter = exchange.retryAfter;
+  } else {
+    CURL *curl = curl_easy_init();
+    if (!curl)
+      return fail(RetryPolicy::ErrorClass::Local);
 
-  // Encode spaces in URL path (Nexus CDN returns filenames with spaces)
-  std::string encodedUrl = encodeUrlSpaces(url);
-  curl_easy_setopt(curl, CURLOPT_URL, encodedUrl.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFileCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  curl_easy_setopt(curl, CURLOPT_USERAGENT, "NexusBridge/2.0");
-  curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
-  curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress);
-  curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L); // 1KB/s minimum
-  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);    // for 60 seconds
+    FILE *fp = fopen(destPath.c_str(), "wb");
+    if (!fp) {
+      curl_easy_cleanup(curl);
+      return fail(RetryPolicy::ErrorClass::Local);
+    }
 
-  CURLcode res = curl_easy_perform(curl);
-  std::cout << std::endl; // New line after progress
+    DownloadProgress progress;
+    progress.filename = filename;
+    DownloadSink sink;
+    sink.file = fp;
+    sink.curl = curl;
+    sink.admission = &admission;
+
+    // Encode spaces in URL path (Nexus CDN returns filenames with spaces)
+    std::string encodedUrl = encodeUrlSpaces(url);
+    curl_easy_setopt(curl, CURLOPT_URL, encodedUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteDownloadCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "NexusBridge/2.0");
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L); // 1KB/s minimum
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);    // for 60 seconds
+
+    auto started = std::chrono::steady_clock::now();
+    res = curl_easy_perform(curl);
+    std::cout << std::endl; // New line after progress
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+    redirectedTo = effectiveHost(curl);
+    fclose(fp);
+    curl_easy_cleanup(curl);
+  }
 
-  fclose(fp);
-  curl_easy_cleanup(curl);
+  // The cassette keeps the archive only once it has passed the checks
+  // below, so a replay never hands out a truncated one
+  auto recordOutcome = [&](bool verified) {
+    if (!Cassette::recording()) return;
+    Cassette::Exchange exchange;
+    exchange.curlCode = res;
+    exchange.httpCode = httpCode;
+    exchange.retryAfter = retryAfter;
+    exchange.elapsed = elapsed;
+    Cassette::recordDownload(url, verified ? destPath : "", exchange);
+  };
 
-  if (res != CURLE_OK) {
-    std::cerr << "  Download failed: " << curl_easy_strerror(res) << std::endl;
+  RetryPolicy::ErrorClass cls = RetryPolicy::classify(res, httpCode);
+  admission.record(cls, std::chrono::seconds(static_cast<long long>(retryAfter)), redirectedTo);
+  if (cls != RetryPolicy::ErrorClass::None) {
+    // An error page isn't an archive
+    std::cerr << "  Download failed: "
+              << (res != CURLE_OK ? curl_easy_strerror(res) : "HTTP " + std::to_string(httpCode))
+              << std::endl;
+    recordOutcome(false);
     fs::remove(destPath);
-    return false;
+    return fail(cls);
   }
 
-  // Verify file size if expected
+  // Verify file size if expected. A wrong size without a transfer error
+  // is most likely a body cut short, so it's worth another try
   if (expectedSize > 0) {
-    auto actualSize = fs::file_size(destPath);
-    if (actualSize != static_cast<uintmax_t>(expectedSize)) {
-      std::cerr << "  Size mismatch: expected " << expectedSize << ", got "
-                << actualSize << std::endl;
-      // Don't delete - partial download might be resumable
+    std::error_code ec;
+    auto actualSize = fs::file_size(destPath, ec);
+    if (ec || actualSize != static_cast<uintmax_t>(expectedSize)) {
+      std::cerr << "  Download failed: size mismatch: expected " << expectedSize << ", got "
+                << (ec ? 0 : actualSize) << std::endl;
+      recordOutcome(false);
+      fs::remove(destPath, ec);
+      return fail(RetryPolicy::ErrorClass::Transient);
     }
   }
+  recordOutcome(true);
 
+  if (errorClass) *errorClass = RetryPolicy::ErrorClass::None;
   return true;
 }
 
+// ============================================================================
+// Download Single-Flight
+// ============================================================================
+
+// One download per archive file, across threads and processes. Inside the
+// process, a second request for a path waits for the one in flight and
+// shares its result. Across processes (instances sharing a downloads
+// folder, or several --nxm runs from the GUI) the download is written to
+// <archive>.part under an exclusive lock (flock, or LockFileEx on
+// Windows); a process that finds the lock taken waits, then uses the
+// archive the holder renamed into place.
+class DownloadFlights {
+public:
+  // Writes the archive to the path it's given (the .part file); reports
+  // whether a failure is worth retrying through cls
+  using Fetch = std::function<bool(const std::string &partPath, RetryPolicy::ErrorClass &cls)>;
+
+  bool download(const std::string &url, const std::string &destPath,
+                const std::string &filename, long long expectedSize,
+                RetryPolicy::ErrorClass *errorClass = nullptr) {
+    return fetch(destPath, expectedSize, [&](const std::string &partPath, RetryPolicy::ErrorClass &cls) {
+      return downloadFile(url, partPath, filename, expectedSize, &cls);
+    }, errorClass);
+  }
+
+  bool fetch(const std::string &destPath, long long expectedSize, const Fetch &fetchPart,
+             RetryPolicy::ErrorClass *errorClass = nullptr) {
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto &slot = flights_[destPath];
+      if (!slot) {
+        slot = std::make_shared<Flight>();
+        leader = true;
+      }
+      flight = slot;
+    }
+
+    if (!leader) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [&] { return flight->done; });
+      if (errorClass) *errorClass = flight->errorClass;
+      return flight->ok;
+    }
+
+    RetryPolicy::ErrorClass cls = RetryPolicy::ErrorClass::None;
+    bool ok = fetchLocked(destPath, expectedSize, fetchPart, cls);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      flight->ok = ok;
+      flight->errorClass = cls;
+      flight->done = true;
+      flights_.erase(destPath);
+    }
+    done_.notify_all();
+    if (errorClass) *errorClass = cls;
+    return ok;
+  }
+
+private:
+  struct Flight {
+    bool done = false;
+    bool ok = false;
+    RetryPolicy::ErrorClass errorClass = RetryPolicy::ErrorClass::None;
+  };
+
+  static bool completeArchive(const std::string &path, long long expectedSize) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    return !ec && size > 0 &&
+           (expectedSize <= 0 || size == static_cast<uintmax_t>(expectedSize));
+  }
+
+#ifdef _WIN32
+  // The same protocol as below, with LockFileEx in place of flock.
+  // Windows byte-range locks are mandatory, so the locked byte lies far
+  // past the end of any archive rather than over the data being written.
+  // Every handle shares delete access, so the holder can still rename or
+  // remove the .part while others wait on it.
+  static constexpr DWORD kLockOffsetHigh = 0x7FFFFFFF;
+
+  static bool fetchLocked(const std::string &destPath, long long expectedSize,
+                          const Fetch &fetchPart, RetryPolicy::ErrorClass &cls) {
+    std::string partPath = destPath + ".part";
+    std::wstring widePart = fs::path(partPath).wstring();
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    bool announced = false;
+    int pendingDeletes = 0;
+    while (true) {
+      HANDLE file = CreateFileW(widePart.c_str(), GENERIC_READ | GENERIC_WRITE, share, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE) {
+        DWORD error = GetLastError();
+        // A .part the holder deleted stays in the way until every
+        // waiter's handle on it is closed
+        if (error == ERROR_ACCESS_DENIED && ++pendingDeletes <= 100) {
+          Sleep(100);
+          continue;
+        }
+        std::cerr << "  Download failed: can't create " << partPath << " (error "
+                  << error << ")" << std::endl;
+        cls = RetryPolicy::ErrorClass::Permanent;
+        return false;
+      }
+      OVERLAPPED region{};
+      region.OffsetHigh = kLockOffsetHigh;
+      if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &region)) {
+        if (!announced) {
+          std::cout << "  Waiting for another process downloading "
+                    << fs::path(destPath).filename().string() << std::endl;
+          announced = true;
+        }
+        LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &region);
+      }
+
+      // As below: the file locked here may have been renamed into place
+      // or deleted since it was opened
+      bool stillPart = false;
+      HANDLE current = CreateFileW(widePart.c_str(), 0, share, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (current != INVALID_HANDLE_VALUE) {
+        BY_HANDLE_FILE_INFORMATION lockedInfo, currentInfo;
+        stillPart = GetFileInformationByHandle(file, &lockedInfo) &&
+                    GetFileInformationByHandle(current, &currentInfo) &&
+                    lockedInfo.dwVolumeSerialNumber == currentInfo.dwVolumeSerialNumber &&
+                    lockedInfo.nFileIndexHigh == currentInfo.nFileIndexHigh &&
+                    lockedInfo.nFileIndexLow == currentInfo.nFileIndexLow;
+        CloseHandle(current);
+      }
+      if (completeArchive(destPath, expectedSize)) {
+        if (stillPart) DeleteFileW(widePart.c_str());
+        CloseHandle(file);
+        cls = RetryPolicy::ErrorClass::None;
+        return true;
+      }
+      if (!stillPart) {
+        CloseHandle(file);
+        continue;
+      }
+
+      bool ok = fetchPart(partPath, cls);
+      if (ok) {
+        std::error_code ec;
+        fs::rename(partPath, destPath, ec);
+        if (ec) {
+          std::cerr << "  Download failed: can't move " << partPath << " into place: "
+                    << ec.message() << std::endl;
+          fs::remove(partPath, ec);
+          cls = RetryPolicy::ErrorClass::Permanent;
+          ok = false;
+        }
+      }
+      CloseHandle(file);
+      return ok;
+    }
+  }
+#else
+  static bool fetchLocked(const std::string &destPath, long long expectedSize,
+                          const Fetch &fetchPart, RetryPolicy::ErrorClass &cls) {
+    std::string partPath = destPath + ".part";
+    bool announced = false;
+    while (true) {
+      int fd = open(partPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (fd < 0) {
+        std::cerr << "  Download failed: can't create " << partPath << ": "
+                  << std::strerror(errno) << std::endl;
+        cls = RetryPolicy::ErrorClass::Permanent;
+        return false;
+      }
+      if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (!announced) {
+          std::cout << "  Waiting for another process downloading "
+                    << fs::path(destPath).filename().string() << std::endl;
+          announced = true;
+        }
+        flock(fd, LOCK_EX);
+      }
+
+      // The holder renames its .part into place (or deletes it on
+      // failure), so the file locked here may no longer be the one at
+      // partPath: then see what it left behind and start over
+      struct stat locked, current;
+      bool stillPart = fstat(fd, &locked) == 0 && stat(partPath.c_str(), &current) == 0 &&
+                       locked.st_dev == current.st_dev && locked.st_ino == current.st_ino;
+      if (completeArchive(destPath, expectedSize)) {
+        if (stillPart) unlink(partPath.c_str());
+        close(fd);
+        cls = RetryPolicy::ErrorClass::None;
+        return true;
+      }
+      if (!stillPart) {
+        close(fd);
+        continue;
+      }
+
+      bool ok = fetchPart(partPath, cls);
+      if (ok && rename(partPath.c_str(), destPath.c_str()) != 0) {
+        std::cerr << "  Download failed: can't move " << partPath << " into place: "
+                  << std::strerror(errno) << std::endl;
+        unlink(partPath.c_str());
+        cls = RetryPolicy::ErrorClass::Permanent;
+        ok = false;
+      }
+      close(fd);
+      return ok;
+    }
+  }
+#endif
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  std::map<std::string, std::shared_ptr<Flight>> flights_;
+};
+
+DownloadFlights g_downloadFlights;
+
+// ============================================================================
+// Peer Archive Cache
+// ============================================================================
+
+// Other machines running --serve (see peer_cache.hpp). Archives are asked
+// for by MD5 before going to Nexus; whatever comes back is hashed and only
+// kept if it matches. A peer that can't be reached is left alone for the
+// rest of the run, so a machine that's switched off costs one connect
+// timeout.
+constexpr uint16_t kDefaultPeerPort = 8790;
+
+class PeerClient {
+public:
+  // "host" or "host:port"
+  void add(std::string address) {
+    if (address.find(':') == std::string::npos) address += ":" + std::to_string(kDefaultPeerPort);
+    peers_.emplace_back(address);
+  }
+  bool empty() const { return peers_.empty(); }
+
+  bool fetch(const std::string &md5, const std::string &destPath,
+             const std::string &filename, long long expectedSize) {
+    for (Peer &peer : peers_) {
+      if (peer.dead.load()) continue;
+      if (fetchFrom(peer, md5, destPath, filename, expectedSize)) return true;
+    }
+    return false;
+  }
+
+private:
+  struct Peer {
+    explicit Peer(std::string addr) : address(std::move(addr)) {}
+    std::string address;  // host:port
+    std::atomic<bool> dead{false};
+  };
+
+  static bool fetchFrom(Peer &peer, const std::string &md5, const std::string &destPath,
+                        const std::string &filename, long long expectedSize) {
+    CURL *curl = curl_easy_init();
+    if (!curl) return false;
+    FILE *fp = fopen(destPath.c_str(), "wb");
+    if (!fp) {
+      curl_easy_cleanup(curl);
+      return false;
+    }
+
+    DownloadProgress progress;
+    progress.filename = filename;
+    std::string url = "http://" + peer.address + "/md5/" + CaseFold::fold(md5);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFileCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "NexusBridge/2.0");
+    curl_easy_setopt(curl, CURLOPT_NOPROXY, "*");  // It's on the LAN
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 3L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1000L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+
+    CURLcode res = curl_easy_perform(curl);
+    long httpCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    fclose(fp);
+    curl_easy_cleanup(curl);
+
+    if (res == CURLE_COULDNT_CONNECT || res == CURLE_COULDNT_RESOLVE_HOST ||
+        (res == CURLE_OPERATION_TIMEDOUT && httpCode == 0)) {
+      if (!peer.dead.exchange(true)) {
+        std::cout << "  Peer " << peer.address << " unreachable ("
+                  << curl_easy_strerror(res) << "), not asking it again" << std::endl;
+      }
+      fs::remove(destPath);
+      return false;
+    }
+    if (res != CURLE_OK || httpCode != 200) {
+      if (res != CURLE_OK) std::cout << std::endl;  // After the progress line
+      fs::remove(destPath);  // 404: the peer doesn't have it
+      return false;
+    }
+    std::cout << std::endl;
+
+    std::error_code ec;
+    std::string actual;
+    bool sizeOk = expectedSize <= 0 ||
+                  fs::file_size(destPath, ec) == static_cast<uintmax_t>(expectedSize);
+    if (!sizeOk || !ContentHash::md5File(destPath, actual) ||
+        !CaseFold::equals(actual, md5)) {
+      std::cout << "  [WARN] " << filename << " from peer " << peer.address
+                << " doesn't match its MD5, discarding it" << std::endl;
+      fs::remove(destPath);
+      return false;
+    }
+    std::cout << "  Got " << filename << " from peer " << peer.address << std::endl;
+    return true;
+  }
+
+  std::list<Peer> peers_;
+};
+
+PeerClient g_peers;
+
+// --serve: share this instance's downloads/ with peers until killed
+int servePeerCache(const std::string &mo2Path, uint16_t port) {
+  fs::path downloadsDir = fs::path(mo2Path) / "downloads";
+  if (!fs::is_directory(downloadsDir)) {
+    std::cerr << "No downloads folder in " << mo2Path << std::endl;
+    return 1;
+  }
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  PeerCache::ArchiveIndex index(downloadsDir, fs::path(mo2Path) / ".nexusbridge" / "peer_md5.tsv");
+  std::cout << "Indexing " << downloadsDir.string() << "..." << std::endl;
+  size_t hashed = index.refresh(threads);
+  std::cout << "  " << index.size() << " archives (" << hashed << " hashed)" << std::endl;
+
+  PeerCache::Server server(index, threads);
+  std::string error;
+  if (!server.start(port, &error)) {
+    std::cerr << "Could not listen on port " << port << ": " << error << std::endl;
+    return 1;
+  }
+  std::cout << "Serving archives on port " << server.port() << " (Ctrl+C to stop)" << std::endl;
+  while (true) std::this_thread::sleep_for(std::chrono::hours(1));
+}
+
+// ============================================================================
+// Download Folder Watching
+// ============================================================================
+
+// Reports files that finish arriving in a folder. On Linux this is
+// inotify: a file counts once it's closed after writing or moved in
+// (browsers download to a temporary name and rename). Elsewhere, or if
+// inotify can't be set up, the folder is polled and a file counts once
+// its size has stayed the same between two polls.
+class DownloadWatcher {
+public:
+  explicit DownloadWatcher(const fs::path &dir) : dir_(dir) {
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0 && inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+#endif
+    if (fd_ < 0) {
+      // Files already there aren't new
+      for (const auto &[name, size] : listFiles()) sizes_[name] = {size, true};
+    }
+  }
+
+  ~DownloadWatcher() {
+#ifdef __linux__
+    if (fd_ >= 0) close(fd_);
+#endif
+  }
+
+  DownloadWatcher(const DownloadWatcher &) = delete;
+  DownloadWatcher &operator=(const DownloadWatcher &) = delete;
+
+  bool usingInotify() const { return fd_ >= 0; }
+
+  // Names of files completed since the last call, waiting up to timeout
+  // for the first one
+  std::vector<std::string> wait(std::chrono::milliseconds timeout) {
+#ifdef __linux__
+    if (fd_ >= 0) return waitInotify(timeout);
+#endif
+    return waitPolling(timeout);
+  }
+
+private:
+  std::map<std::string, uintmax_t> listFiles() const {
+    std::map<std::string, uintmax_t> files;
+    DirWalker::Options options;
+    options.recursive = false;
+    options.sizes = true;
+    DirWalker::Listing listing = DirWalker::walk(dir_, options);
+    for (const auto &entry : listing) files[std::string(entry.name)] = entry.size;
+    return files;
+  }
+
+#ifdef __linux__
+  std::vector<std::string> waitInotify(std::chrono::milliseconds timeout) {
+    std::vector<std::string> names;
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) return names;
+
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    while (true) {
+      ssize_t len = read(fd_, buffer, sizeof(buffer));
+      if (len <= 0) break;
+      for (ssize_t pos = 0; pos < len;) {
+        auto *event = reinterpret_cast<struct inotify_event *>(buffer + pos);
+        pos += sizeof(struct inotify_event) + event->len;
+        if (event->len > 0 && !(event->mask & IN_ISDIR)) names.emplace_back(event->name);
+      }
+    }
+    return names;
+  }
+#endif
+
+  std::vector<std::string> waitPolling(std::chrono::milliseconds timeout) {
+    std::vector<std::string> names;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      for (const auto &[name, size] : listFiles()) {
+        auto [it, added] = sizes_.try_emplace(name, Seen{size, false});
+        if (added) continue;
+        if (it->second.size != size) {
+          it->second = {size, false};
+        } else if (!it->second.reported) {
+          it->second.reported = true;
+          names.push_back(name);
+        }
+      }
+      if (!names.empty() || std::chrono::steady_clock::now() >= deadline) return names;
+      std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(
+          std::chrono::seconds(2), timeout));
+    }
+  }
+
+  struct Seen {
+    uintmax_t size;
+    bool reported;
+  };
+
+  fs::path dir_;
+  int fd_ = -1;
+  std::map<std::string, Seen> sizes_;  // Polling only
+};
+
 // ============================================================================
 // Nexus API Functions
 // ============================================================================
@@ -557,21 +1249,37 @@ public:
       : apiKey(key), gameDomain(game), lastRequest(std::chrono::steady_clock::now()) {
   }
 
-  bool validateKey() {
-    std::cout << "Validating Nexus API key..." << std::endl;
-
+  // users/validate.json, fetched without printing so it can run while the
+  // collection is still downloading; validateKey() reports the result
+  struct KeyInfo {
     long httpCode = 0;
-    std::string response = httpGet(
-        "https://api.nexusmods.com/v1/users/validate.json", apiKey, &httpCode);
+    std::string response;
+    std::string log;  // Failed attempts, printed under the validation line
+  };
 
-    if (httpCode != 200 || response.empty()) {
-      std::cerr << "API key validation failed (HTTP " << httpCode << ")"
+  static KeyInfo fetchKeyInfo(const std::string &key) {
+    KeyInfo info;
+    std::ostringstream log;
+    t_requestLog = &log;
+    info.response = httpGet("https://api.nexusmods.com/v1/users/validate.json",
+                            key, &info.httpCode);
+    t_requestLog = nullptr;
+    info.log = log.str();
+    return info;
+  }
+
+  bool validateKey(const KeyInfo &info) {
+    std::cout << "Validating Nexus API key..." << std::endl;
+    std::cerr << info.log << std::flush;
+
+    if (info.httpCode != 200 || info.response.empty()) {
+      std::cerr << "API key validation failed (HTTP " << info.httpCode << ")"
                 << std::endl;
       return false;
     }
 
     try {
-      json data = json::parse(response);
+      json data = json::parse(info.response);
       std::string username = data.value("name", "Unknown");
       isPremium = data.value("is_premium", false);
 
@@ -598,18 +1306,26 @@ public:
   }
 
   // Get download links for a file
-  // Returns empty vector if failed
-  std::vector<std::string> getDownloadLinks(int modId, int fileId) {
+  // Returns empty vector if failed; failure (optional) says whether asking
+  // again later could help
+  std::vector<std::string> getDownloadLinks(int modId, int fileId,
+                                            RetryPolicy::ErrorClass *failure = nullptr) {
     rateLimitWait();
 
     std::string url = "https://api.nexusmods.com/v1/games/" + gameDomain +
                       "/mods/" + std::to_string(modId) + "/files/" +
                       std::to_string(fileId) + "/download_link.json";
 
+    // One attempt: the download phase retries the whole download (with
+    // the server's Retry-After), so retrying here too would multiply them
     long httpCode = 0;
-    std::string response = httpGet(url, apiKey, &httpCode);
+    RetryPolicy::ErrorClass cls = RetryPolicy::ErrorClass::None;
+    std::string response = httpGet(url, apiKey, &httpCode, 1, &cls);
 
     std::vector<std::string> links;
+    // Empty or unreadable link lists are odd enough to be worth a retry
+    if (failure) *failure = cls == RetryPolicy::ErrorClass::None
+                                ? RetryPolicy::ErrorClass::Transient : cls;
 
     if (httpCode == 403) {
       // Premium required
@@ -636,6 +1352,7 @@ public:
                 << std::endl;
     }
 
+    if (failure && !links.empty()) *failure = RetryPolicy::ErrorClass::None;
     return links;
   }
 
@@ -730,6 +1447,9 @@ public:
           ModInfo mod;
           mod.name = modJson.value("name", "");
           mod.phase = modJson.value("phase", 0);
+          if (modJson.contains("version") && modJson["version"].is_string()) {
+            mod.version = modJson["version"].get<std::string>();
+          }
 
           if (modJson.contains("source")) {
             const auto &src = modJson["source"];
@@ -755,6 +1475,14 @@ public:
                 std::string path = hash["path"].get<std::string>();
                 std::replace(path.begin(), path.end(), '\\', '/');
                 mod.expectedPaths.push_back(path);
+                ExpectedFile file;
+                if (hash.contains("size") && hash["size"].is_number()) {
+                  file.size = hash["size"].get<long long>();
+                }
+                if (hash.contains("md5") && hash["md5"].is_string()) {
+                  file.md5 = hash["md5"].get<std::string>();
+                }
+                mod.expectedFiles.push_back(std::move(file));
               }
             }
           }
@@ -827,124 +1555,75 @@ public:
 // Archive Extraction
 // ============================================================================
 
-// Returns {success, errorMessage}
+// Returns {success, errorMessage}. 7z is killed if cancelled returns true.
+// With a listFile, only the entries named in it (one per line, exactly as
+// 7z lists them) are extracted.
 std::pair<bool, std::string> extractArchive(const std::string &archivePath,
-                                            const std::string &destPath) {
+                                            const std::string &destPath,
+                                            const std::function<bool()> &cancelled = {},
+                                            const std::string &listFile = "") {
   fs::create_directories(destPath);
 
-  std::string ext = fs::path(archivePath).extension().string();
-  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  std::string ext = CaseFold::fold(fs::path(archivePath).extension().string());
 
   std::string sevenZip = get7zCommand();
   if (ext != ".7z" && ext != ".zip" && ext != ".rar") {
     return {false, "Unsupported archive format: " + ext};
   }
 
-  std::string cmd;
-  std::string errorMsg;
-
+  // 7z is run directly (no shell), so paths need no quoting and stderr
+  // comes back through a pipe instead of a shared temp file
 #ifdef _WIN32
-  // Normalize all paths to backslashes for Windows
-  std::string winDestPath = destPath;
-  std::string winArchivePath = archivePath;
-  std::string winSevenZip = sevenZip;
-  std::replace(winDestPath.begin(), winDestPath.end(), '/', '\\');
-  std::replace(winArchivePath.begin(), winArchivePath.end(), '/', '\\');
-  std::replace(winSevenZip.begin(), winSevenZip.end(), '/', '\\');
-
-  // Copy archive to simple temp path to avoid cmd.exe quoting issues with
-  // filenames containing spaces, dashes, and special characters
-  std::string tempArchive = winDestPath + "\\a" + ext;  // e.g., C:\n\m123\a.7z
-
-  // Ensure dest directory exists
-  try {
-    fs::create_directories(winDestPath);
-  } catch (...) {}
+  std::replace(sevenZip.begin(), sevenZip.end(), '/', '\\');
+  std::string nativeDest = destPath;
+  std::string nativeArchive = archivePath;
+  std::replace(nativeDest.begin(), nativeDest.end(), '/', '\\');
+  std::replace(nativeArchive.begin(), nativeArchive.end(), '/', '\\');
+#else
+  const std::string &nativeDest = destPath;
+  const std::string &nativeArchive = archivePath;
+#endif
 
-  try {
-    fs::copy_file(winArchivePath, tempArchive, fs::copy_options::overwrite_existing);
-  } catch (const std::exception& e) {
-    return {false, std::string("Failed to copy archive: ") + e.what()};
+  Subprocess::Options options;
+  options.captureLimit = 4096;
+  options.cancelled = cancelled;
+  std::vector<std::string> args = {sevenZip, "x", "-y", "-o" + nativeDest, nativeArchive};
+  if (!listFile.empty()) {
+    // -spd: names are literal, so brackets and '*' in file names are safe
+    args.insert(args.begin() + 2, {"-spd", "-scsUTF-8"});
+    args.push_back("@" + listFile);
   }
-
-  // Verify copy succeeded - check file exists and has size
-  if (!fs::exists(tempArchive) || fs::file_size(tempArchive) == 0) {
-    return {false, "Archive copy failed or file is empty"};
+  Subprocess::Result run = Subprocess::run(args, options);
+  if (run.ok()) {
+    // Read once, not needed again: keep it from crowding out the cache
+    if (CopyEngine::cacheFriendly()) CopyEngine::dropCachedPages(archivePath);
+    return {true, ""};
   }
 
-  // Simple command - short paths (C:\n\m123) don't need quoting, only 7za.exe path does
-  std::string errFile = winDestPath + "\\7z_err.txt";
-  cmd = "\"" + winSevenZip + "\" x -y -o" + winDestPath + " " + tempArchive + " > nul 2>" + errFile;
-
-  int result = std::system(cmd.c_str());
-
-  if (result != 0) {
-    // Try to read the actual error from 7z
-    std::ifstream errStream(errFile);
-    if (errStream) {
-      std::stringstream buffer;
-      buffer << errStream.rdbuf();
-      errorMsg = buffer.str();
-      if (errorMsg.length() > 500) {
-        errorMsg = errorMsg.substr(0, 500);
-      }
-      // Trim whitespace
-      while (!errorMsg.empty() && (errorMsg.back() == '\n' || errorMsg.back() == '\r' || errorMsg.back() == ' ')) {
-        errorMsg.pop_back();
-      }
-    }
-    if (errorMsg.empty()) {
+  std::string errorMsg = run.err;
+  if (errorMsg.length() > 500) {
+    errorMsg = errorMsg.substr(0, 500) + "...";
+  }
+  // Trim whitespace
+  while (!errorMsg.empty() && (errorMsg.back() == '\n' || errorMsg.back() == '\r' || errorMsg.back() == ' ')) {
+    errorMsg.pop_back();
+  }
+  if (errorMsg.empty()) {
+    if (!run.started || run.timedOut || run.cancelled || run.signal != 0) {
+      errorMsg = "7z " + run.describe();
+    } else {
       // Fall back to exit code messages
-      switch (result) {
+      switch (run.exitCode) {
         case 1: errorMsg = "Warning: some files could not be extracted"; break;
         case 2: errorMsg = "Fatal error during extraction"; break;
         case 7: errorMsg = "Command line error"; break;
         case 8: errorMsg = "Not enough memory"; break;
         case 255: errorMsg = "User cancelled"; break;
-        default: errorMsg = "7z exit code: " + std::to_string(result); break;
-      }
-    }
-  }
-  // Clean up error file
-  try { fs::remove(errFile); } catch (...) {}
-
-  // Clean up temp archive
-  try { fs::remove(tempArchive); } catch (...) {}
-#else
-  // On Linux, we can safely capture stderr
-  fs::path tempDir = fs::temp_directory_path();
-  fs::path errFile = tempDir / ("nb_7z_err_" + std::to_string(getpid()) + ".txt");
-
-  cmd = sevenZip + " x -y -o\"" + destPath + "\" \"" + archivePath +
-        "\" > /dev/null 2>\"" + errFile.string() + "\"";
-  int result = system(cmd.c_str());
-
-  if (result != 0) {
-    // Read error output
-    std::ifstream errStream(errFile);
-    if (errStream) {
-      std::stringstream buffer;
-      buffer << errStream.rdbuf();
-      errorMsg = buffer.str();
-      // Trim and limit length
-      if (errorMsg.length() > 500) {
-        errorMsg = errorMsg.substr(0, 500) + "...";
-      }
-      // Remove trailing newlines
-      while (!errorMsg.empty() && (errorMsg.back() == '\n' || errorMsg.back() == '\r')) {
-        errorMsg.pop_back();
+        default: errorMsg = "7z exit code: " + std::to_string(run.exitCode); break;
       }
     }
-    if (errorMsg.empty()) {
-      errorMsg = "7z exit code: " + std::to_string(result);
-    }
   }
-
-  // Cleanup temp file
-  try { fs::remove(errFile); } catch (...) {}
-#endif
-
-  return {result == 0, errorMsg};
+  return {false, errorMsg};
 }
 
 // Fix Windows backslash paths in extracted files
@@ -954,12 +1633,10 @@ void fixWindowsBackslashPaths(const std::string &extractedPath) {
   std::vector<fs::path> toFix;
 
   // Collect files with backslashes in their names
-  for (const auto &entry : fs::recursive_directory_iterator(extractedPath)) {
-    if (entry.is_regular_file()) {
-      std::string filename = entry.path().filename().string();
-      if (filename.find('\\') != std::string::npos) {
-        toFix.push_back(entry.path());
-      }
+  DirWalker::Listing listing = DirWalker::files(extractedPath);
+  for (const auto &entry : listing) {
+    if (entry.name.find('\\') != std::string_view::npos) {
+      toFix.push_back(listing.path(entry));
     }
   }
 
@@ -987,90 +1664,29 @@ void fixWindowsBackslashPaths(const std::string &extractedPath) {
   }
 }
 
-// Known Skyrim data folders that should NOT be treated as wrappers
-static bool isDataFolder(const std::string &name) {
-  std::string lower = name;
-  std::transform(lower.begin(), lower.end(), lower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-
-  static const std::set<std::string> dataFolders = {
-      "meshes",       "textures",
-      "scripts",      "sound",
-      "interface",    "strings",
-      "seq",          "grass",
-      "video",        "music",
-      "shaders",      "shadersfx",    "lodsettings",
-      "skse",         "netscriptframework",
-      "edit scripts", "dialogueviews",
-      "facegen",      "caliente tools",
-      "actors",       "fonts",
-      "materials",    "platform",
-      "source",       "terrain",
-      "trees",        "vis",
-      "distantlod",   "lod",
-      "dyndolod",     "nemesis_engine"};
-
-  return dataFolders.count(lower) > 0;
-}
-
 // Check if folder is the game's "Data" folder (should be unwrapped)
 static bool isGameDataFolder(const std::string &name) {
-  std::string lower = name;
-  std::transform(lower.begin(), lower.end(), lower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-  return lower == "data";
+  return CaseFold::equals(name, "data");
 }
 
-// Check if file is "junk" (readme, license, etc.) that shouldn't prevent
-// unwrapping
-static bool isJunkFile(const std::string &name) {
-  std::string lower = name;
-  std::transform(lower.begin(), lower.end(), lower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-
-  // Extensions to ignore
-  static const std::set<std::string> junkExts = {
-      ".txt", ".md",  ".pdf", ".doc",  ".docx", ".rtf", ".url",
-      ".ini", ".png", ".jpg", ".jpeg", ".bmp",  ".gif"};
-
-  // Filenames to ignore (exact match)
-  static const std::set<std::string> junkNames = {
-      "readme",  "license", "changelog",   "credits",
-      "authors", "install", "instructions"};
-
-  // Check extension
-  size_t dotPos = lower.find_last_of('.');
-  if (dotPos != std::string::npos) {
-    std::string ext = lower.substr(dotPos);
-    if (junkExts.count(ext))
-      return true;
-  }
-
-  // Check filename (contains junk name)
-  for (const auto &junk : junkNames) {
-    if (lower.find(junk) != std::string::npos)
-      return true;
-  }
-
-  return false;
-}
-
-// Detect wrapper folder (single folder containing all mod content)
-// Recursively unwraps version folders and "Data" folders
-// Ignores junk files when determining if a folder is a wrapper
-std::string detectWrapperFolder(const std::string &extractedPath) {
-  std::string currentPath = extractedPath;
+// Detect wrapper folder (single folder containing all mod content)
+// Recursively unwraps version folders and "Data" folders
+// Ignores junk files when determining if a folder is a wrapper
+std::string detectWrapperFolder(const std::string &extractedPath,
+                                const GameLayout::Layout &layout) {
+  std::string currentPath = extractedPath;
 
   // Keep unwrapping until we find actual content
   while (true) {
     std::vector<fs::path> dirs;
     std::vector<fs::path> files;
 
-    for (const auto &entry : fs::directory_iterator(currentPath)) {
-      if (entry.is_directory()) {
-        dirs.push_back(entry.path());
+    DirWalker::Listing listing = DirWalker::children(currentPath);
+    for (const auto &entry : listing) {
+      if (entry.isDirectory()) {
+        dirs.push_back(listing.path(entry));
       } else {
-        files.push_back(entry.path());
+        files.push_back(listing.path(entry));
       }
     }
 
@@ -1078,7 +1694,7 @@ std::string detectWrapperFolder(const std::string &extractedPath) {
     if (dirs.size() == 1) {
       bool hasSignificantFiles = false;
       for (const auto &f : files) {
-        if (!isJunkFile(f.filename().string())) {
+        if (!layout.isJunkFile(f.filename().string())) {
           hasSignificantFiles = true;
           break;
         }
@@ -1095,7 +1711,7 @@ std::string detectWrapperFolder(const std::string &extractedPath) {
         }
 
         // Don't unwrap if it's a known mod data folder (meshes, textures, etc.)
-        if (isDataFolder(folderName)) {
+        if (layout.isDataFolder(folderName)) {
           return currentPath;
         }
 
@@ -1113,56 +1729,57 @@ std::string detectWrapperFolder(const std::string &extractedPath) {
 // Find existing folder with case-insensitive match in destination
 static fs::path findExistingFolder(const fs::path &destDir,
                                    const std::string &folderName) {
-  if (!fs::exists(destDir) || !fs::is_directory(destDir)) {
-    return fs::path();
-  }
-
-  std::string nameLower = folderName;
-  std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-
-  for (const auto &entry : fs::directory_iterator(destDir)) {
-    if (entry.is_directory()) {
-      std::string entryName = entry.path().filename().string();
-      std::string entryLower = entryName;
-      std::transform(entryLower.begin(), entryLower.end(), entryLower.begin(),
-                     [](unsigned char c) { return std::tolower(c); });
-      if (entryLower == nameLower) {
-        return entry.path();
-      }
-    }
-  }
-  return fs::path();
+  return DirWalker::findChildFolder(destDir, folderName);
 }
 
-// Recursively copy directory with case-insensitive merging
-static void copyDirMerge(const fs::path &src, const fs::path &dst) {
+// Queue a recursive copy with case-insensitive folder merging. Folders are
+// created immediately; files are copied when the batch runs.
+static void queueDirMerge(const fs::path &src, const fs::path &dst,
+                          CopyEngine::CopyBatch &batch) {
   if (!fs::exists(dst)) {
     fs::create_directories(dst);
   }
 
-  for (const auto &entry : fs::directory_iterator(src)) {
-    std::string itemName = entry.path().filename().string();
+  // The kernel merges differently-cased folders on its own
+  if (DirWalker::isCaseFolded(dst)) {
+    batch.setCaseInsensitiveDest(true);
+    batch.addTree(src, dst);
+    return;
+  }
+
+  DirWalker::Listing listing = DirWalker::children(src);
+  for (const auto &entry : listing) {
+    std::string itemName(entry.name);
 
-    if (entry.is_directory()) {
+    if (entry.isDirectory()) {
       // Check for case-insensitive match in destination
       fs::path existingDir = findExistingFolder(dst, itemName);
       if (!existingDir.empty()) {
         // Merge into existing folder
-        copyDirMerge(entry.path(), existingDir);
+        queueDirMerge(listing.path(entry), existingDir, batch);
       } else {
         // Create new folder and copy
-        fs::path newDir = dst / itemName;
-        copyDirMerge(entry.path(), newDir);
+        fs::path newDir = dst / DirWalker::toPath(entry.name);
+        queueDirMerge(listing.path(entry), newDir, batch);
       }
     } else {
       // Copy file, overwriting if exists
-      fs::path target = dst / itemName;
-      fs::copy_file(entry.path(), target, fs::copy_options::overwrite_existing);
+      fs::path target = dst / DirWalker::toPath(entry.name);
+      batch.add(listing.path(entry), target);
     }
   }
 }
 
+// Recursively copy directory with case-insensitive merging
+static void copyDirMerge(const fs::path &src, const fs::path &dst) {
+  CopyEngine::CopyBatch batch;
+  queueDirMerge(src, dst, batch);
+  std::vector<std::string> errors;
+  if (batch.run(&errors) > 0) {
+    throw std::runtime_error("copy failed: " + errors.front());
+  }
+}
+
 // Flatten "Data" folder if it exists in the root
 // Moves contents of Data/ to root/ and removes Data/
 void flattenDataFolder(const std::string &modRoot) {
@@ -1170,11 +1787,16 @@ void flattenDataFolder(const std::string &modRoot) {
   fs::path dataPath;
 
   // Find "Data" folder case-insensitively
-  for (const auto &entry : fs::directory_iterator(root)) {
-    if (entry.is_directory() &&
-        isGameDataFolder(entry.path().filename().string())) {
-      dataPath = entry.path();
-      break;
+  if (DirWalker::isCaseFolded(root)) {
+    std::error_code ec;
+    if (fs::is_directory(root / "Data", ec)) dataPath = root / "Data";
+  } else {
+    DirWalker::Listing rootListing = DirWalker::children(root);
+    for (const auto &entry : rootListing) {
+      if (entry.isDirectory() && isGameDataFolder(std::string(entry.name))) {
+        dataPath = rootListing.path(entry);
+        break;
+      }
     }
   }
 
@@ -1185,13 +1807,14 @@ void flattenDataFolder(const std::string &modRoot) {
             << std::endl;
 
   // Move everything from Data/ to root/
-  for (const auto &entry : fs::directory_iterator(dataPath)) {
-    fs::path src = entry.path();
+  DirWalker::Listing dataListing = DirWalker::children(dataPath);
+  for (const auto &entry : dataListing) {
+    fs::path src = dataListing.path(entry);
     fs::path dst = root / src.filename();
 
     try {
       if (fs::exists(dst)) {
-        if (fs::is_directory(src) && fs::is_directory(dst)) {
+        if (entry.isDirectory() && fs::is_directory(dst)) {
           // Merge directories
           copyDirMerge(src, dst);
           fs::remove_all(src);
@@ -1220,15 +1843,17 @@ void flattenDataFolder(const std::string &modRoot) {
 // When archive has multiple variant folders like "Mod - Option A" and "Mod - Option B",
 // and mod name is "Mod - Option A", we pick that folder and flatten it
 std::string selectVariantFolder(const std::string &contentPath,
-                                 const std::string &modName) {
+                                 const std::string &modName,
+                                 const GameLayout::Layout &layout) {
   std::vector<fs::path> dirs;
   std::vector<fs::path> files;
 
-  for (const auto &entry : fs::directory_iterator(contentPath)) {
-    if (entry.is_directory()) {
-      dirs.push_back(entry.path());
-    } else if (!isJunkFile(entry.path().filename().string())) {
-      files.push_back(entry.path());
+  DirWalker::Listing listing = DirWalker::children(contentPath);
+  for (const auto &entry : listing) {
+    if (entry.isDirectory()) {
+      dirs.push_back(listing.path(entry));
+    } else if (!layout.isJunkFile(entry.name)) {
+      files.push_back(listing.path(entry));
     }
   }
 
@@ -1237,19 +1862,10 @@ std::string selectVariantFolder(const std::string &contentPath,
     return contentPath;
   }
 
-  // Normalize mod name for comparison
-  std::string modNameLower = modName;
-  std::transform(modNameLower.begin(), modNameLower.end(), modNameLower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-
   // Look for a folder that matches the mod name
   for (const auto &dir : dirs) {
     std::string folderName = dir.filename().string();
-    std::string folderLower = folderName;
-    std::transform(folderLower.begin(), folderLower.end(), folderLower.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
-
-    if (folderLower == modNameLower) {
+    if (CaseFold::equals(folderName, modName)) {
       std::cout << "    Selected variant folder: " << folderName << std::endl;
       return dir.string();
     }
@@ -1258,6 +1874,206 @@ std::string selectVariantFolder(const std::string &contentPath,
   return contentPath;
 }
 
+// ============================================================================
+// Hash Manifest Placement
+// ============================================================================
+
+// Files in an archive, as 7z names them (folders left out). Uses the
+// technical listing (7z l -slt), which is read straight from the archive
+// headers without decompressing anything.
+static bool listArchiveFiles(const std::string &archivePath, std::vector<std::string> &files) {
+  bool inEntries = false;
+  std::string path;
+  bool folder = false;
+  auto flush = [&]() {
+    if (inEntries && !path.empty() && !folder) files.push_back(path);
+    path.clear();
+    folder = false;
+  };
+
+  Subprocess::Options options;
+  options.captureLimit = 4096;
+  options.onLine = [&](const std::string &line) {
+    if (line.empty()) {
+      flush();
+    } else if (line.rfind("----------", 0) == 0) {
+      // Archive properties end here; entries follow
+      path.clear();
+      inEntries = true;
+    } else if (line.rfind("Path = ", 0) == 0) {
+      path = line.substr(7);
+    } else if (line.rfind("Folder = +", 0) == 0 ||
+               (line.rfind("Attributes = ", 0) == 0 && line.size() > 13 && line[13] == 'D')) {
+      folder = true;
+    }
+  };
+  Subprocess::Result run =
+      Subprocess::run({get7zCommand(), "l", "-slt", "-sccUTF-8", archivePath}, options);
+  flush();
+  return run.ok() && inEntries;
+}
+
+// Where each file listed in the collection's hashes comes from in the
+// archive
+struct HashPlacement {
+  struct File {
+    std::string entry;     // Archive name as 7z lists it
+    std::string path;      // Path inside the mod folder
+    size_t expected;       // Index into the expected paths
+  };
+  std::vector<File> files;
+  bool identity = true;  // Every file is already where it belongs
+};
+
+// Map expected paths onto archive entries. An entry matches an expected
+// path exactly or by ending in "/<expected>" (under a wrapper, Data/ or
+// FOMOD option folder). A path several entries end with is resolved by
+// the folders the unambiguous matches came from. Fails, leaving the
+// heuristics to handle the mod, unless every expected file is found.
+static bool planHashPlacement(const std::vector<std::string> &archiveFiles,
+                              const std::vector<std::string> &expectedPaths,
+                              HashPlacement &plan, std::string &why) {
+  std::vector<std::string> normalized(archiveFiles);
+  CaseFold::KeyMap<size_t> byPath;
+  CaseFold::KeyMap<std::vector<size_t>> byName;
+  byPath.reserve(normalized.size());
+  for (size_t i = 0; i < normalized.size(); ++i) {
+    std::string &name = normalized[i];
+    std::replace(name.begin(), name.end(), '\\', '/');
+    byPath.emplace(CaseFold::Key(name), i);
+    size_t slash = name.rfind('/');
+    byName[CaseFold::Key(std::string_view(name).substr(slash == std::string::npos ? 0 : slash + 1))]
+        .push_back(i);
+  }
+
+  auto prefixOf = [&](size_t entry, const std::string &expected) {
+    return CaseFold::fold(std::string_view(normalized[entry]).substr(
+        0, normalized[entry].size() - expected.size()));
+  };
+
+  std::set<std::string> prefixes;  // Folders the unambiguous matches came from
+  std::vector<std::pair<size_t, std::vector<size_t>>> ambiguous;
+  std::vector<std::pair<size_t, size_t>> matched;  // expected index -> entry
+  CaseFold::KeySet seen;
+  for (size_t e = 0; e < expectedPaths.size(); ++e) {
+    const std::string &expected = expectedPaths[e];
+    if (expected.empty() || !seen.insert(CaseFold::Key(expected)).second) continue;
+
+    auto exact = byPath.find(CaseFold::Key::borrow(expected));
+    if (exact != byPath.end()) {
+      matched.emplace_back(e, exact->second);
+      prefixes.insert("");
+      continue;
+    }
+
+    size_t slash = expected.rfind('/');
+    auto named = byName.find(CaseFold::Key::borrow(
+        std::string_view(expected).substr(slash == std::string::npos ? 0 : slash + 1)));
+    std::vector<size_t> candidates;
+    if (named != byName.end()) {
+      for (size_t entry : named->second) {
+        const std::string &name = normalized[entry];
+        if (name.size() > expected.size() && name[name.size() - expected.size() - 1] == '/' &&
+            CaseFold::endsWith(name, expected)) {
+          candidates.push_back(entry);
+        }
+      }
+    }
+    if (candidates.empty()) {
+      why = "not in archive: " + expected;
+      return false;
+    }
+    if (candidates.size() == 1) {
+      matched.emplace_back(e, candidates[0]);
+      prefixes.insert(prefixOf(candidates[0], expected));
+    } else {
+      ambiguous.emplace_back(e, std::move(candidates));
+    }
+  }
+
+  for (const auto &[e, candidates] : ambiguous) {
+    size_t pick = SIZE_MAX;
+    for (size_t entry : candidates) {
+      if (!prefixes.count(prefixOf(entry, expectedPaths[e]))) continue;
+      if (pick != SIZE_MAX) {
+        pick = SIZE_MAX;
+        break;
+      }
+      pick = entry;
+    }
+    if (pick == SIZE_MAX) {
+      why = "several archive files could be " + expectedPaths[e];
+      return false;
+    }
+    matched.emplace_back(e, pick);
+  }
+
+  plan.files.clear();
+  plan.identity = true;
+  for (const auto &[e, entry] : matched) {
+    plan.files.push_back({archiveFiles[entry], expectedPaths[e], e});
+    if (archiveFiles[entry] != normalized[entry] ||
+        !CaseFold::equals(normalized[entry], expectedPaths[e])) {
+      plan.identity = false;
+    }
+  }
+  return true;
+}
+
+// Put the planned files from an extracted tree into the mod folder. Files
+// are moved when move is set (the tree is this task's own), else copied.
+static void placeHashPlanned(const HashPlacement &plan, const fs::path &from,
+                             const fs::path &modPath, bool move) {
+  CopyEngine::CopyBatch batch;
+  for (const auto &file : plan.files) {
+    fs::path source = from / DirWalker::toPath(file.entry);
+    fs::path target = modPath / file.path;
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+    if (move) {
+      fs::rename(source, target, ec);
+      if (!ec) {
+        uintmax_t size = fs::file_size(target, ec);
+        if (!ec) CopyEngine::notePlaced(size);
+        continue;
+      }
+      // Otherwise a different device - copy instead
+    }
+    batch.add(source, target);
+  }
+  std::vector<std::string> errors;
+  if (batch.run(&errors) > 0) {
+    throw std::runtime_error(errors.front());
+  }
+}
+
+// Check the planned files against the sizes and MD5s the collection gives
+// for them, in an extracted tree (placed: already at their mod folder
+// paths under root). A name match alone could be an older version of the
+// file.
+static bool verifyHashPlanned(const HashPlacement &plan, const std::vector<ExpectedFile> &expected,
+                              const fs::path &root, bool placed, std::string &why) {
+  for (const auto &file : plan.files) {
+    if (file.expected >= expected.size()) continue;
+    const ExpectedFile &check = expected[file.expected];
+    fs::path path = root / (placed ? fs::path(file.path) : DirWalker::toPath(file.entry));
+    if (check.size >= 0) {
+      std::error_code ec;
+      uintmax_t size = fs::file_size(path, ec);
+      if (ec || size != static_cast<uintmax_t>(check.size)) {
+        why = "size differs: " + file.path;
+        return false;
+      }
+    }
+    std::string md5;
+    if (!check.md5.empty() && (!ContentHash::md5File(path, md5) || !CaseFold::equals(md5, check.md5))) {
+      why = "MD5 differs: " + file.path;
+      return false;
+    }
+  }
+  return true;
+}
+
 // ============================================================================
 // Thread Pool for Parallel Installation
 // ============================================================================
@@ -1325,6 +2141,311 @@ private:
   bool stop;
 };
 
+// ============================================================================
+// Temp Directory Reclaimer (background deletion of staging trees)
+// ============================================================================
+
+// Deleting a large extraction tree can take seconds. Workers hand finished
+// staging directories to this reclaimer, which renames them into a trash
+// folder (instant, frees the original path) and deletes them on a
+// low-priority background thread.
+class TempReclaimer {
+public:
+  ~TempReclaimer() { drain(); }
+
+  void start(const fs::path &trash, size_t maxEntries = 64,
+             uintmax_t maxBytes = 16ULL * 1024 * 1024 * 1024) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    trashDir = trash;
+    maxBacklog = maxEntries;
+    maxBacklogBytes = maxBytes;
+    runTag = "t" + std::to_string(std::time(nullptr));
+    std::error_code ec;
+    fs::create_directories(trashDir, ec);
+
+    // Leftovers from an interrupted run are deleted first
+    if (!ec) {
+      DirWalker::Listing leftovers = DirWalker::children(trashDir);
+      for (const auto &entry : leftovers) {
+        queue.push({leftovers.path(entry), 0, 0});
+      }
+    }
+
+    stopping = false;
+    running = true;
+    thread = std::thread([this] { run(); });
+  }
+
+  // Queue a staging tree for deletion. estimatedBytes is used for backlog
+  // accounting until the tree is actually deleted.
+  void reclaim(const fs::path &path, uintmax_t estimatedBytes = 0) {
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running) {
+      lock.unlock();
+      removeWithRetry(path);
+      return;
+    }
+
+    // Bounded backlog: block until the deleter catches up
+    spaceAvailable.wait(lock, [&] {
+      return queue.size() < maxBacklog &&
+             (pendingBytes == 0 || pendingBytes + estimatedBytes <= maxBacklogBytes);
+    });
+
+    fs::path target = trashDir / (runTag + "_" + std::to_string(nextId++));
+    fs::rename(path, target, ec);
+    if (ec) {
+      // Rename can fail across devices or on locked files. Delete in place,
+      // now: callers reuse the path straight away, so it must never be
+      // queued (the deleter would remove whatever is extracted there next).
+      lock.unlock();
+      removeWithRetry(path);
+      return;
+    }
+    queue.push({target, estimatedBytes, 0});
+    pendingBytes += estimatedBytes;
+    lock.unlock();
+    workAvailable.notify_one();
+  }
+
+  // Wait for the backlog to empty and stop the background thread
+  void drain() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!running) return;
+      stopping = true;
+    }
+    workAvailable.notify_all();
+    if (thread.joinable()) thread.join();
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+
+  uintmax_t bytesReclaimed() const { return reclaimedBytes.load(); }
+
+  // Synchronous delete with retries for transient file locks (Windows AV etc.)
+  static void removeWithRetry(const fs::path &path) {
+    for (int retry = 0; retry < 5; retry++) {
+      try {
+        fs::remove_all(path);
+        return;
+      } catch (const std::exception &) {
+        if (retry < 4) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(100 * (retry + 1)));
+        } else {
+          throw;
+        }
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    fs::path path;
+    uintmax_t estimatedBytes;
+    int attempts;
+  };
+
+  static void lowerCurrentThreadPriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    (void)setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+    // IOPRIO_CLASS_IDLE (3) << IOPRIO_CLASS_SHIFT (13), IOPRIO_WHO_PROCESS (1)
+    (void)syscall(SYS_ioprio_set, 1, static_cast<int>(tid), 3 << 13);
+#endif
+  }
+
+  // Delete a tree, counting the bytes actually freed
+  static uintmax_t removeCounting(const fs::path &path) {
+    uintmax_t bytes = 0;
+    DirWalker::Options options;
+    options.sizes = true;
+    for (const auto &entry : DirWalker::walk(path, options)) {
+      bytes += entry.size;
+    }
+    fs::remove_all(path);
+    return bytes;
+  }
+
+  void run() {
+    lowerCurrentThreadPriority();
+
+    while (true) {
+      Entry entry;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        workAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;  // stopping with nothing left
+        entry = queue.front();
+        queue.pop();
+      }
+
+      bool done = true;
+      try {
+        reclaimedBytes += removeCounting(entry.path);
+      } catch (const std::exception &) {
+        done = ++entry.attempts >= 5;
+        if (!done) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(100 * entry.attempts));
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (done) {
+          pendingBytes -= std::min(pendingBytes, entry.estimatedBytes);
+        } else {
+          queue.push(entry);
+        }
+      }
+      spaceAvailable.notify_all();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable spaceAvailable;
+  std::queue<Entry> queue;
+  std::thread thread;
+  fs::path trashDir;
+  std::string runTag;
+  size_t maxBacklog = 64;
+  uintmax_t maxBacklogBytes = 0;
+  uintmax_t pendingBytes = 0;
+  std::atomic<uintmax_t> reclaimedBytes{0};
+  unsigned long long nextId = 0;
+  bool running = false;
+  bool stopping = false;
+};
+
+static TempReclaimer g_reclaimer;
+
+// ============================================================================
+// Install Manifests (per-mod file lists)
+// ============================================================================
+
+// Kept outside the mod folder (<mo2>/.nexusbridge/manifests/<folder>.json)
+// so MO2 doesn't expose it in the virtual Data folder.
+struct ManifestFile {
+  std::string path;  // Relative to the mod folder, forward slashes
+  uintmax_t size = 0;
+};
+
+struct InstallManifest {
+  std::string modName;
+  std::string folderName;
+  std::vector<ManifestFile> files;
+  std::vector<std::string> packedFiles;     // Loose files moved into archives
+  std::vector<std::string> generatedFiles;  // Archives/plugins NexusBridge created
+
+  static InstallManifest scan(const fs::path &modDir, const std::string &modName) {
+    InstallManifest manifest;
+    manifest.modName = modName;
+    manifest.folderName = modDir.filename().string();
+    DirWalker::Options options;
+    options.sizes = true;
+    DirWalker::Listing listing = DirWalker::walk(modDir, options);
+    manifest.files.reserve(listing.size());
+    for (const auto &entry : listing) {
+      if (entry.relative == "meta.ini") continue;  // MO2's own file
+      manifest.files.push_back({std::string(entry.relative), entry.size});
+    }
+    return manifest;
+  }
+
+  static bool load(const fs::path &path, InstallManifest &out) {
+    std::string content = readFile(path.string());
+    if (content.empty()) return false;
+    try {
+      json root = json::parse(content);
+      out.modName = root.value("modName", "");
+      out.folderName = root.value("folderName", "");
+      out.files.clear();
+      for (const auto &file : root.value("files", json::array())) {
+        out.files.push_back({file.value("path", ""), file.value("size", uintmax_t(0))});
+      }
+      out.packedFiles = root.value("packedFiles", std::vector<std::string>());
+      out.generatedFiles = root.value("generatedFiles", std::vector<std::string>());
+      return true;
+    } catch (const json::exception &) {
+      return false;
+    }
+  }
+
+  // Written to a temp file and renamed so an interrupted run never leaves
+  // a truncated manifest behind
+  bool save(const fs::path &path) const {
+    json root;
+    root["modName"] = modName;
+    root["folderName"] = folderName;
+    root["files"] = json::array();
+    for (const auto &file : files) {
+      root["files"].push_back({{"path", file.path}, {"size", file.size}});
+    }
+    root["packedFiles"] = packedFiles;
+    root["generatedFiles"] = generatedFiles;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::trunc);
+      if (!out) return false;
+      out << root.dump(1);
+      if (!out) return false;
+    }
+    fs::rename(tmp, path, ec);
+    return !ec;
+  }
+};
+
+fs::path manifestPathFor(const std::string &manifestDir, const std::string &folderName) {
+  return fs::path(manifestDir) / (folderName + ".json");
+}
+
+// Run the same work-stealing loop on numThreads threads and wait for them
+template <class F> static void runWorkers(F &worker, unsigned int numThreads) {
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < std::max(1u, numThreads); ++t) {
+    threads.emplace_back(worker);
+  }
+  for (auto &t : threads) t.join();
+}
+
+// Load (or build and save) the manifest of every installed mod.
+// present[i] is 0 for mods with no folder on disk.
+static void loadManifests(const std::vector<ModInfo> &mods, const std::string &modsDir,
+                          const std::string &manifestDir, unsigned int numThreads,
+                          std::vector<InstallManifest> &manifests,
+                          std::vector<char> &present) {
+  manifests.assign(mods.size(), InstallManifest());
+  present.assign(mods.size(), 0);
+  std::atomic<size_t> loadIndex{0};
+  auto loader = [&]() {
+    while (true) {
+      size_t i = loadIndex.fetch_add(1);
+      if (i >= mods.size()) break;
+      if (mods[i].folderName.empty()) continue;
+      fs::path modDir = fs::path(modsDir) / mods[i].folderName;
+      if (!fs::is_directory(modDir)) continue;
+      fs::path path = manifestPathFor(manifestDir, mods[i].folderName);
+      if (!InstallManifest::load(path, manifests[i])) {
+        manifests[i] = InstallManifest::scan(modDir, mods[i].name);
+        manifests[i].save(path);
+      }
+      present[i] = 1;
+    }
+  };
+  runWorkers(loader, numThreads);
+}
+
 // Download task for parallel downloading
 struct DownloadTask {
   std::string url;
@@ -1334,8 +2455,179 @@ struct DownloadTask {
   long long fileSize;
   int modId;
   int fileId;
+  std::string md5;  // From the collection, for asking peers
   bool isDirectDownload;
   size_t modIndex;  // Index into collection.mods
+  std::vector<size_t> sharedWith;  // Other entries that use the same archive
+};
+
+// Archive in downloads/
+struct DownloadedArchive {
+  std::string path;
+  std::string name;
+  std::string nameLower;  // Case-folded, for prefix matching
+  long long size;
+};
+
+// MO2 .meta sidecars and downloads still in progress (ours, MO2's and the
+// browsers' temporary names)
+bool isArchiveSidecar(std::string_view name) {
+  for (std::string_view suffix : {".meta", ".part", ".unfinished", ".crdownload", ".tmp"}) {
+    if (CaseFold::endsWith(name, suffix)) return true;
+  }
+  return false;
+}
+
+// Existing archive for a Nexus collection entry: one named after its
+// logical file name and mod id, else one with the mod id in its name. It
+// must have the expected size (or any size but zero, if the collection
+// doesn't give one). With allowLoose, an archive of the wrong size will
+// do as a last resort, preferably a named one (used for the initial scan,
+// not for single new files, which may be half-written or belong to
+// another entry of the same mod). Empty if none.
+std::string findDownloadedArchive(const ModInfo &mod,
+                                  const std::vector<DownloadedArchive> &archives,
+                                  bool allowLoose) {
+  std::string modIdPattern = "-" + std::to_string(mod.modId) + "-";
+  // Folded name prefixes to look for (built once, not per archive)
+  std::string expectedStart;
+  std::string simplifiedStart;
+  if (!mod.logicalFilename.empty()) {
+    std::string logicalLower = CaseFold::fold(mod.logicalFilename);
+    expectedStart = logicalLower + modIdPattern;
+
+    std::string ccPrefix = "creation club - ";
+    size_t ccPos = logicalLower.find(ccPrefix);
+    if (ccPos != std::string::npos) {
+      std::string simplifiedLogical = logicalLower.substr(0, ccPos) + logicalLower.substr(ccPos + ccPrefix.length());
+      simplifiedStart = simplifiedLogical + modIdPattern;
+    }
+  }
+  auto startsWith = [](const std::string &name, const std::string &prefix) {
+    return !prefix.empty() && name.compare(0, prefix.size(), prefix) == 0;
+  };
+
+  std::string namedFallback;
+  std::string fallbackMatch;
+  long long expectedSize = mod.fileSize;
+
+  for (const auto &entry : archives) {
+    if (entry.size <= 0 || entry.name.find(modIdPattern) == std::string::npos) continue;
+
+    bool named = startsWith(entry.nameLower, expectedStart) ||
+                 startsWith(entry.nameLower, simplifiedStart);
+    bool sizeOk = expectedSize > 0 ? entry.size == expectedSize : named;
+    if (sizeOk) return entry.path;
+
+    std::string &fallback = named ? namedFallback : fallbackMatch;
+    if (fallback.empty()) fallback = entry.path;
+  }
+
+  if (!allowLoose) return std::string();
+  return namedFallback.empty() ? fallbackMatch : namedFallback;
+}
+
+// ============================================================================
+// Mod Tracing (--trace-mod)
+// ============================================================================
+
+// Detailed install log for the mods picked with --trace-mod: what the
+// archive extracted to, which folder was installed from and why, how the
+// FOMOD choices were applied and what ended up in the mod folder. Each
+// traced mod gets its own file in .nexusbridge/traces/. Untraced mods
+// carry no trace object, so all the install path does for them is test a
+// null pointer.
+class ModTrace {
+public:
+  static void addPattern(const std::string &glob) { patterns().push_back(glob); }
+  static void setDirectory(const fs::path &dir) { directory() = dir; }
+  static bool enabled() { return !patterns().empty(); }
+  static const fs::path &outputDirectory() { return directory(); }
+
+  // Trace for a mod if a pattern matches its name or folder, else null
+  static std::shared_ptr<ModTrace> forMod(const std::string &modName,
+                                          const std::string &folderName) {
+    if (!enabled()) return nullptr;
+    for (const auto &pattern : patterns()) {
+      if (globMatch(pattern, modName) || globMatch(pattern, folderName)) {
+        return std::make_shared<ModTrace>(directory() / (folderName + ".log"), modName);
+      }
+    }
+    return nullptr;
+  }
+
+  ModTrace(const fs::path &file, const std::string &modName) : file_(file), modName_(modName) {}
+
+  void line(const std::string &text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open()) out_ << text << "\n" << std::flush;
+  }
+
+  // Every entry under root, with file sizes
+  void tree(const std::string &label, const fs::path &root) {
+    DirWalker::Options options;
+    options.includeDirectories = true;
+    options.includeOther = true;
+    options.sizes = true;
+    DirWalker::Listing listing = DirWalker::walk(root, options);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open()) return;
+    out_ << label << " (" << root.string() << ", " << listing.count(DirWalker::Type::File)
+         << " files):\n";
+    for (const auto &entry : listing) {
+      out_ << "  " << entry.relative;
+      if (entry.type == DirWalker::Type::Directory) out_ << "/";
+      else if (entry.type == DirWalker::Type::File) out_ << "  " << entry.size;
+      out_ << "\n";
+    }
+    out_ << std::flush;
+  }
+
+  // For FomodInstaller::process; only the installing thread writes to it
+  std::ostream *stream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open() ? &out_ : nullptr;
+  }
+
+  const fs::path &file() const { return file_; }
+
+private:
+  static std::vector<std::string> &patterns() {
+    static std::vector<std::string> list;
+    return list;
+  }
+  static fs::path &directory() {
+    static fs::path dir;
+    return dir;
+  }
+
+  // Opened on first use, so a trace that never records creates no file
+  bool open() {
+    if (!out_.is_open()) {
+      std::error_code ec;
+      fs::create_directories(file_.parent_path(), ec);
+      out_.open(file_, std::ios::app);
+      if (out_) {
+        std::time_t now = std::time(nullptr);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+        out_ << "=== " << modName_ << " (" << stamp << ") ===\n";
+      }
+    }
+    return static_cast<bool>(out_);
+  }
+
+  fs::path file_;
+  std::string modName_;
+  std::mutex mutex_;
+  std::ofstream out_;
 };
 
 // Install task for parallel processing
@@ -1349,6 +2641,13 @@ struct InstallTask {
   size_t index;
   size_t total;
   std::vector<std::string> expectedPaths; // Expected files from collection hashes
+  std::vector<ExpectedFile> expectedFiles; // Their sizes and MD5s, where known
+  std::string manifestPath; // Where to record installed files (empty = don't)
+  int phase = 0;             // Collection install phase
+  bool waitsForEarlierPhases = false;  // FOMOD choices may depend on earlier phases
+  const GameLayout::Layout *layout = &GameLayout::kSkyrimSE;  // Unwrapping rules
+  int attempt = 0;           // 0 = first try; retries start from a clean slate
+  std::shared_ptr<ModTrace> trace;  // --trace-mod; null for untraced mods
 };
 
 // Global counters for thread-safe progress
@@ -1362,107 +2661,644 @@ void safePrint(const std::string &msg) {
   std::cout << msg << std::flush;
 }
 
+// Rough size of an extracted archive (same 2x estimate used for install size)
+static uintmax_t estimateStagingBytes(const std::string &archivePath) {
+  std::error_code ec;
+  uintmax_t size = fs::file_size(archivePath, ec);
+  return ec ? 0 : size * 2;
+}
+
+// Descriptors one install may hold: a full copy batch plus 7z's pipes,
+// manifests and the like (set from the open-file budget)
+static size_t g_installOpenFiles = 2 * 64 + 16;
+
+// Peak needs of one install under the resource governor. 7z's dictionary
+// is never larger than the archive; the rest is copy buffers and the
+// trees we build.
+static ResourceGovernor::Cost installCost(const std::string &archivePath) {
+  constexpr uintmax_t kMB = 1024 * 1024;
+  std::error_code ec;
+  uintmax_t archiveBytes = fs::file_size(archivePath, ec);
+  ResourceGovernor::Cost cost;
+  cost.memoryBytes = 64 * kMB + std::min<uintmax_t>(ec ? 0 : archiveBytes, 1024 * kMB);
+  cost.openFiles = g_installOpenFiles;
+  cost.heavyTasks = 1;
+  return cost;
+}
+
+// ============================================================================
+// Install Watchdog
+// ============================================================================
+
+// Thrown inside installMod once the watchdog has given up on the attempt
+struct InstallCancelled : std::runtime_error {
+  InstallCancelled() : std::runtime_error("install cancelled") {}
+};
+
+// One try at installing one mod, shared by the worker running it and the
+// watchdog. The worker marks which stage it is in and beats whenever it
+// makes progress; the watchdog cancels the attempt when a stage runs past
+// its deadline or, for stages that beat, when the beats stop.
+class InstallAttempt {
+public:
+  InstallAttempt(size_t taskIndex, int number) : taskIndex(taskIndex), number(number) {
+    beat();
+  }
+
+  const size_t taskIndex;
+  const int number;  // 0 = first try
+
+  // Set on a retry: whether the thread of the attempt that stalled has
+  // stopped yet (it was only asked to)
+  std::shared_ptr<const std::atomic<bool>> previousExited;
+
+  void enterStage(const char *name, std::chrono::milliseconds budget, bool beats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_ = name;
+    beats_ = beats;
+    deadline_ = Clock::now() + budget;
+    beat();
+  }
+
+  // Back to no deadline, as before the first stage
+  void leaveStage(const char *name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_ = name;
+    beats_ = false;
+    deadline_ = Clock::time_point::max();
+  }
+
+  void beat() {
+    lastBeat_.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+  }
+
+  std::string stage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stage_;
+  }
+
+  // Don't count `spent` against the stage deadline or as time without
+  // progress, until `limit` has been granted in total
+  void stretch(std::chrono::steady_clock::duration spent, std::chrono::steady_clock::duration limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    spent = std::min(spent, limit - std::min(limit, stretched_));
+    stretched_ += spent;
+    if (deadline_ != Clock::time_point::max()) deadline_ += spent;
+    lastBeat_.fetch_add(spent.count(), std::memory_order_relaxed);
+  }
+
+  // Why the attempt should be given up on, or empty if it is healthy
+  std::string overdue(std::chrono::seconds stallLimit) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    if (now > deadline_) return "over its time budget";
+    auto quiet = now - Clock::time_point(Clock::duration(lastBeat_.load(std::memory_order_relaxed)));
+    if (beats_ && quiet > stallLimit) {
+      return "no progress for " +
+             std::to_string(std::chrono::duration_cast<std::chrono::seconds>(quiet).count()) + "s";
+    }
+    return "";
+  }
+
+  // The install's resource lease lives here rather than on the worker's
+  // stack, so the watchdog can return it when it abandons a worker that
+  // may never unwind
+  void holdResources(ResourceGovernor::Lease lease) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resources_ = std::move(lease);
+  }
+
+  void releaseResources() {
+    ResourceGovernor::Lease lease;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lease = std::move(resources_);
+    }
+  }
+
+  bool cancelRequested() const { return state_.load() == kCancelled; }
+
+  // Watchdog side: false if the worker already settled the result
+  bool cancel() {
+    int expected = kRunning;
+    return state_.compare_exchange_strong(expected, kCancelled);
+  }
+
+  // Worker side: claim the right to report the result. False if the
+  // watchdog cancelled the attempt first (its result belongs to the retry).
+  bool settle() {
+    int expected = kRunning;
+    return state_.compare_exchange_strong(expected, kSettled) || expected == kSettled;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  enum { kRunning, kSettled, kCancelled };
+
+  mutable std::mutex mutex_;
+  std::string stage_ = "starting";
+  bool beats_ = false;
+  Clock::time_point deadline_ = Clock::time_point::max();
+  Clock::duration stretched_{0};
+  std::atomic<Clock::rep> lastBeat_{0};
+  std::atomic<int> state_{kRunning};
+  ResourceGovernor::Lease resources_;
+};
+
+// Attempt the current thread is working on (null outside the install pool)
+static thread_local InstallAttempt *t_installAttempt = nullptr;
+
+// Stage deadline: two minutes plus 2 MB/s of staging data, doubled on
+// every retry so a slow but healthy disk gets through the second time
+static void installStage(const char *name, uintmax_t stagingBytes, bool beats) {
+  if (!t_installAttempt) return;
+  std::chrono::milliseconds budget(120000 + static_cast<long long>(stagingBytes / 2000));
+  t_installAttempt->enterStage(name, budget * (1 << t_installAttempt->number), beats);
+}
+
+static bool installCancelled() {
+  return t_installAttempt && t_installAttempt->cancelRequested();
+}
+
+static void installCheckpoint() {
+  if (installCancelled()) throw InstallCancelled();
+  if (t_installAttempt) t_installAttempt->beat();
+}
+
+// Must be called (and return true) before an install reports its result
+static bool settleInstall() {
+  return !t_installAttempt || t_installAttempt->settle();
+}
+
+// How long a cancelled attempt's thread gets to stop: its retry waits
+// this long for it, and it keeps its resource lease at most this long
+static constexpr std::chrono::minutes kStalledExitWait(2);
+
+// A retry starts over in the mod folder the stalled attempt was writing
+// to. That attempt was only asked to stop; wait until its thread has, or
+// give up on the retry too if it never does.
+static void waitForStalledAttempt() {
+  if (!t_installAttempt || !t_installAttempt->previousExited) return;
+  if (!*t_installAttempt->previousExited) {
+    t_installAttempt->enterStage("waiting for the stalled attempt to stop", kStalledExitWait, false);
+    while (!*t_installAttempt->previousExited) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      installCheckpoint();
+    }
+  }
+  t_installAttempt->leaveStage("starting");
+}
+
+// Temp space for one extraction. Waiting for it doesn't count against
+// the extracting stage's deadline.
+static ResourceGovernor::Lease acquireStaging(uintmax_t stagingBytes) {
+  ResourceGovernor::Cost cost;
+  cost.stagingBytes = stagingBytes;
+  bool waited = false;
+  ResourceGovernor::Lease lease = ResourceGovernor::acquire(cost, [&] {
+    if (!waited && t_installAttempt) {
+      t_installAttempt->enterStage("waiting for temp space", std::chrono::hours(24), false);
+    }
+    waited = true;
+    installCheckpoint();
+  });
+  if (waited) installStage("extracting", stagingBytes, false);
+  return lease;
+}
+
+// ============================================================================
+// Shared Staging
+// ============================================================================
+
+// Collections often list one archive several times, with different FOMOD
+// choices or variants. Each archive is extracted once; every task that
+// installs from it reads the same staging folder, which goes to the
+// reclaimer after the last of them has finished.
+class StagingRegistry {
+public:
+  struct Staging {
+    bool ok = false;
+    std::string path;   // Extracted tree
+    std::string error;  // Why extraction failed
+  };
+
+  // Register every install task before Phase 2 starts. The first task for
+  // an archive decides where it is staged.
+  void addConsumer(const InstallTask &task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = entries_[keyFor(task)];
+    if (!entry) {
+      entry = std::make_unique<Entry>();
+      entry->basePath = task.tempDir;
+    }
+    entry->consumers++;
+    entry->users++;
+  }
+
+  // More than one task installs from the task's archive
+  bool isShared(const InstallTask &task) {
+    Entry &entry = entryFor(task);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    return entry.users > 1;
+  }
+
+  // Archives that more than one task installs from
+  size_t sharedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t shared = 0;
+    for (const auto &[key, entry] : entries_) {
+      if (entry->users > 1) shared++;
+    }
+    return shared;
+  }
+
+  // Extract the task's archive, or wait for the task already doing so. A
+  // failed extraction fails every task sharing it; a cancelled one is
+  // started again by the next task that needs it.
+  Staging acquire(const InstallTask &task) {
+    Entry &entry = entryFor(task);
+    std::unique_lock<std::mutex> lock(entry.mutex);
+    while (entry.state == State::Extracting) {
+      entry.changed.wait_for(lock, std::chrono::milliseconds(200));
+      installCheckpoint();
+    }
+    if (entry.state == State::Ready || entry.state == State::Failed) {
+      entry.readers.insert(task.index);
+      entry.lease.park(false);
+      return {entry.state == State::Ready, entry.path, entry.error};
+    }
+
+    // After a cancelled extraction use a fresh folder, in case the old
+    // 7z hasn't quite let go of the previous one
+    entry.state = State::Extracting;
+    entry.path = entry.basePath;
+    if (entry.generation > 0) entry.path += "r" + std::to_string(entry.generation);
+    entry.generation++;
+    std::string path = entry.path;
+    lock.unlock();
+
+    Staging result{false, path, ""};
+    ResourceGovernor::Lease lease;
+    try {
+      lease = acquireStaging(estimateStagingBytes(task.archivePath));
+      // Move any stale extraction out of the way. It is deleted in the
+      // background only once renamed into the trash, otherwise right here,
+      // so nothing queued can delete what is extracted to path next.
+      g_reclaimer.reclaim(path);
+      auto [success, error] = extractArchive(task.archivePath, path, installCancelled);
+      if (success) {
+        // Fix Windows backslash paths (e.g., "SKSE\Plugins\file.dll" -> "SKSE/Plugins/file.dll")
+        fixWindowsBackslashPaths(path);
+      }
+      result.ok = success;
+      result.error = error;
+    } catch (const std::exception &e) {
+      result.error = e.what();
+    }
+
+    bool cancelled = installCancelled();
+    lock.lock();
+    entry.state = cancelled ? State::Idle : result.ok ? State::Ready : State::Failed;
+    entry.error = result.error;
+    if (!cancelled) {
+      entry.lease = std::move(lease);
+      entry.readers.insert(task.index);
+    }
+    entry.changed.notify_all();
+    lock.unlock();
+
+    if (cancelled) {
+      lease.release();
+      g_reclaimer.reclaim(path);
+      throw InstallCancelled();
+    }
+    return result;
+  }
+
+  // The task is done with its staging (once per task, when it reports
+  // its result). The last one out hands the folder to the reclaimer.
+  void release(const InstallTask &task) {
+    leave(task, true);
+  }
+
+  // The watchdog gave up on an attempt of the task, which will never call
+  // release(): it stops reading the staging now, and after its last
+  // attempt the task is done with it as well
+  void abandon(const InstallTask &task, bool lastAttempt) {
+    leave(task, lastAttempt);
+  }
+
+  // After Phase 2: reclaim staging still held for tasks that never
+  // released it (they stalled out)
+  void releaseAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &[key, entry] : entries_) {
+      std::lock_guard<std::mutex> entryLock(entry->mutex);
+      if (!entry->path.empty()) g_reclaimer.reclaim(entry->path);
+      entry->lease.release();
+    }
+    entries_.clear();
+  }
+
+private:
+  enum class State { Idle, Extracting, Ready, Failed };
+
+  struct Entry {
+    std::mutex mutex;
+    std::condition_variable changed;
+    State state = State::Idle;
+    std::string basePath;
+    std::string path;       // Current staging folder (empty once reclaimed)
+    std::string error;
+    int consumers = 0;      // Tasks that haven't released it yet
+    int users = 0;          // Tasks registered for it
+    int generation = 0;     // Extractions started
+    std::set<size_t> readers;          // Tasks installing from it right now
+    ResourceGovernor::Lease lease;     // Its temp space, until reclaimed
+  };
+
+  static std::string keyFor(const InstallTask &task) {
+    return fs::path(task.archivePath).lexically_normal().string();
+  }
+
+  Entry &entryFor(const InstallTask &task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = entries_[keyFor(task)];
+    if (!entry) {
+      // Not registered (single install outside Phase 2)
+      entry = std::make_unique<Entry>();
+      entry->basePath = task.tempDir;
+      entry->consumers = 1;
+      entry->users = 1;
+    }
+    return *entry;
+  }
+
+  // An extraction in progress belongs to a cancelled attempt by the time
+  // the last consumer leaves; that attempt cleans it up
+  void leave(const InstallTask &task, bool done) {
+    Entry &entry = entryFor(task);
+    std::string path;
+    ResourceGovernor::Lease lease;
+    {
+      std::lock_guard<std::mutex> lock(entry.mutex);
+      entry.readers.erase(task.index);
+      if (!done || --entry.consumers > 0 || entry.state == State::Idle ||
+          entry.state == State::Extracting) {
+        // Consumers still to come can only run once other tasks make room
+        if (entry.readers.empty()) entry.lease.park(true);
+        return;
+      }
+      // A consumer added later (watch mode: a replacement archive under
+      // the same name) extracts afresh
+      entry.state = State::Idle;
+      path.swap(entry.path);
+      lease = std::move(entry.lease);
+    }
+    if (!path.empty()) g_reclaimer.reclaim(path, estimateStagingBytes(task.archivePath));
+  }
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Entry>> entries_;
+};
+
+static StagingRegistry g_staging;
+
+// Install a mod from its collection hashes: match the archive against the
+// expected paths and place exactly those files, with no wrapper, variant
+// or Data/ heuristics. Only the needed entries are extracted, unless other
+// tasks share the archive (then the shared extraction is used). Returns
+// false when the archive doesn't match, by name or by the sizes and MD5s
+// the collection gives. The mod folder is left alone then, except for the
+// listed files when they were extracted straight into it.
+static bool installFromHashes(const InstallTask &task, uintmax_t stagingBytes) {
+  HashPlacement plan;
+  std::string why;
+  installStage("extracting", stagingBytes, false);
+  auto mismatch = [&] {
+    safePrint("  [INFO] " + task.modName + ": " + why + ", installing by archive layout\n");
+    return false;
+  };
+
+  if (g_staging.isShared(task)) {
+    StagingRegistry::Staging staging = g_staging.acquire(task);
+    installCheckpoint();
+    if (!staging.ok) return false;  // The normal install reports the error
+
+    std::vector<std::string> files;
+    DirWalker::Listing listing = DirWalker::files(staging.path);
+    files.reserve(listing.size());
+    for (const auto &entry : listing) files.emplace_back(entry.relative);
+    if (!planHashPlacement(files, task.expectedPaths, plan, why) ||
+        !verifyHashPlanned(plan, task.expectedFiles, staging.path, false, why)) {
+      return mismatch();
+    }
+    installStage("installing", stagingBytes, true);
+    placeHashPlanned(plan, staging.path, task.destModPath, false);
+    return true;
+  }
+
+  std::vector<std::string> files;
+  if (!listArchiveFiles(task.archivePath, files)) return false;
+  installCheckpoint();
+  if (!planHashPlacement(files, task.expectedPaths, plan, why)) return mismatch();
+
+  // Entries already at their final paths are extracted straight into the
+  // mod folder; anything else is staged and moved into place
+  std::string listFile = task.tempDir + ".list";
+  {
+    std::ofstream list(listFile, std::ios::binary);
+    for (const auto &file : plan.files) list << file.entry << "\n";
+    if (!list) return false;
+  }
+  std::string extractTo = plan.identity ? task.destModPath : task.tempDir;
+  // 7z truncates existing files in place, which would write through to
+  // mods hardlinked to them by --dedup; give it fresh files instead. The
+  // same goes for taking back an extraction that didn't work out.
+  auto removePlanned = [&] {
+    std::error_code ec;
+    for (const auto &file : plan.files) fs::remove(fs::path(task.destModPath) / file.path, ec);
+  };
+  if (plan.identity) removePlanned();
+  ResourceGovernor::Lease stagingLease;
+  if (!plan.identity) stagingLease = acquireStaging(stagingBytes);
+  g_reclaimer.reclaim(task.tempDir);
+  auto [extracted, error] =
+      extractArchive(task.archivePath, extractTo, installCancelled, listFile);
+  std::error_code ec;
+  fs::remove(listFile, ec);
+  if (!extracted) {
+    if (plan.identity) removePlanned();
+    g_reclaimer.reclaim(task.tempDir);
+    installCheckpoint();
+    why = "selective extraction failed (" + error + ")";
+    return mismatch();
+  }
+  installCheckpoint();
+
+  if (!verifyHashPlanned(plan, task.expectedFiles, extractTo, plan.identity, why)) {
+    if (plan.identity) removePlanned();
+    g_reclaimer.reclaim(task.tempDir);
+    return mismatch();
+  }
+
+  if (!plan.identity) {
+    installStage("installing", stagingBytes, true);
+    placeHashPlanned(plan, task.tempDir, task.destModPath, true);
+    g_reclaimer.reclaim(task.tempDir, stagingBytes);
+  }
+  return true;
+}
+
+// Tells the plugin preloader (if one is running) that a task's install
+// is over, successful or not
+static void notifyInstallFinished(const InstallTask &task, bool ok);
+
+// Record the installed files and report success. Throws InstallCancelled
+// if the watchdog gave up on the attempt first.
+static bool finishInstall(const InstallTask &task) {
+  installCheckpoint();
+  if (!settleInstall()) throw InstallCancelled();
+
+  // Only now: a cancelled attempt must not replace its retry's manifest
+  if (!task.manifestPath.empty()) {
+    InstallManifest::scan(task.destModPath, task.modName).save(task.manifestPath);
+  }
+
+  // Cleanup - the last task using the staging hands it to the reclaimer
+  g_staging.release(task);
+
+  g_installed++;
+  safePrint("  [" + std::to_string(task.index + 1) + "/" +
+            std::to_string(task.total) + "] " + task.modName + " - Done!\n");
+  return true;
+}
+
 // Install a single mod (can be called from thread pool)
 bool installMod(const InstallTask &task) {
-  // Use tempDir directly - it's already unique per mod (e.g., /tmp/nb_ext/m123)
-  std::string extractPath = task.tempDir;
+  uintmax_t stagingBytes = estimateStagingBytes(task.archivePath);
+  ModTrace *trace = task.trace.get();
+  if (trace) {
+    trace->line("attempt " + std::to_string(task.attempt + 1) + ": " + task.archivePath +
+                " -> " + task.destModPath);
+  }
 
   try {
-    // Cleanup any existing extraction with retry for file locks
-    if (fs::exists(extractPath)) {
-      for (int retry = 0; retry < 5; retry++) {
-        try {
-          fs::remove_all(extractPath);
-          break;
-        } catch (const std::exception&) {
-          if (retry < 4) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100 * (retry + 1)));
-          } else {
-            throw;  // Re-throw on final attempt
-          }
+    if (task.attempt > 0) waitForStalledAttempt();
+
+    // Under the resource governor, wait for room for a whole install
+    // (the attempt has no deadline until its first stage). The attempt
+    // holds the lease, so the watchdog can return it if it gives up.
+    ResourceGovernor::Lease resources =
+        ResourceGovernor::acquire(installCost(task.archivePath), installCheckpoint);
+    if (t_installAttempt) t_installAttempt->holdResources(std::move(resources));
+
+    if (task.attempt > 0) {
+      // Don't build on whatever the stalled attempt left behind (removed
+      // here, not by the reclaimer, which may delete in place later)
+      std::error_code ec;
+      fs::remove_all(task.destModPath, ec);
+    }
+
+    // The collection's hashes say exactly which files the mod ends up
+    // with; if the archive matches them, place just those
+    if (!task.expectedPaths.empty()) {
+      RunReport::StageTimer placing(task.index, RunReport::Stage::Place);
+      if (installFromHashes(task, stagingBytes)) {
+        placing.stop();
+        if (trace) {
+          trace->line("placed the " + std::to_string(task.expectedPaths.size()) +
+                      " files listed in the collection's hashes");
+          trace->tree("Installed", task.destModPath);
         }
+        return finishInstall(task);
       }
+      if (trace) trace->line("archive doesn't match the collection's hashes, extracting");
     }
 
-    // Extract archive
-    auto [extractSuccess, extractError] = extractArchive(task.archivePath, extractPath);
-    if (!extractSuccess) {
-      std::string errorDetail = extractError.empty() ? "Unknown error" : extractError;
+    // Extract archive, or share another task's extraction of it (7z
+    // reports no progress, so only the deadline applies)
+    installStage("extracting", stagingBytes, false);
+    RunReport::StageTimer extracting(task.index, RunReport::Stage::Extract);
+    StagingRegistry::Staging staging = g_staging.acquire(task);
+    extracting.stop();
+    installCheckpoint();
+    if (!staging.ok) {
+      if (!settleInstall()) throw InstallCancelled();
+      std::string errorDetail = staging.error.empty() ? "Unknown error" : staging.error;
+      RunReport::installFailed(task.index, "extraction failed: " + errorDetail);
+      if (trace) trace->line("extraction failed: " + errorDetail);
       safePrint("  [" + std::to_string(task.index + 1) + "/" +
                 std::to_string(task.total) + "] " + task.modName +
                 " - FAILED: Extraction failed: " + errorDetail + "\n");
       g_failed++;
+      g_staging.release(task);
       return false;
     }
+    // Read-only from here on: other tasks may be installing from it too
+    const std::string &extractPath = staging.path;
 
-    // Fix Windows backslash paths (e.g., "SKSE\Plugins\file.dll" -> "SKSE/Plugins/file.dll")
-    fixWindowsBackslashPaths(extractPath);
-
-    // DEBUG: List extracted files
-    if (task.modName.find("Animated Armoury") != std::string::npos ||
-        task.modName.find("College of Winterhold") != std::string::npos) {
-      safePrint("  [DEBUG] Extracted contents for " + task.modName + ":\n");
-      for (const auto &entry : fs::recursive_directory_iterator(extractPath)) {
-        safePrint("    " + entry.path().string() + "\n");
-      }
-    }
+    if (trace) trace->tree("Extracted", extractPath);
 
     // Handle wrapper folders
-    std::string actualContent = detectWrapperFolder(extractPath);
-
-    // DEBUG: Show what detectWrapperFolder returned
-    if (task.modName.find("Cougar") != std::string::npos) {
-      safePrint("  [DEBUG " + task.modName + "] extractPath: " + extractPath + "\n");
-      safePrint("  [DEBUG " + task.modName + "] actualContent: " + actualContent + "\n");
+    std::string actualContent = detectWrapperFolder(extractPath, *task.layout);
+    if (trace) {
+      trace->line(actualContent == extractPath ? "no wrapper folder"
+                                               : "wrapper folder: content is in " + actualContent);
     }
 
+    // Copies beat once per file or batch
+    installCheckpoint();
+    installStage("installing", stagingBytes, true);
+
     // Check for FOMOD
     fs::path fomodXml = FomodInstaller::findModuleConfig(actualContent);
 
     if (!fomodXml.empty() && task.choices.contains("options")) {
       // FOMOD with explicit choices from collection
+      RunReport::StageTimer fomod(task.index, RunReport::Stage::Fomod);
       FomodInstaller::FomodChoices choices =
           FomodInstaller::parseChoices(task.choices);
-      if (!FomodInstaller::process(actualContent, task.destModPath, choices)) {
+      if (trace) trace->line("FOMOD with the collection's choices");
+      if (!FomodInstaller::process(actualContent, task.destModPath, choices,
+                                   trace ? trace->stream() : nullptr)) {
         // FOMOD had issues but may have partially worked
       }
+      installCheckpoint();
     } else if (!fomodXml.empty() && !task.expectedPaths.empty()) {
       // FOMOD without choices but we have expected file paths from collection hashes
       // Use hash-based installation: find expected files in archive and copy them
+      RunReport::StageTimer placing(task.index, RunReport::Stage::Place);
       fs::create_directories(task.destModPath);
 
       // Build a case-insensitive map of files in the extracted archive
-      std::map<std::string, fs::path> archiveFiles;
-      for (const auto &entry : fs::recursive_directory_iterator(actualContent)) {
-        if (entry.is_regular_file()) {
-          // Get relative path from actualContent
-          std::string relPath = fs::relative(entry.path(), actualContent).string();
-          // Normalize to forward slashes and lowercase for matching
-          std::replace(relPath.begin(), relPath.end(), '\\', '/');
-          std::string lowerPath = relPath;
-          std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
-          archiveFiles[lowerPath] = entry.path();
-        }
+      // (relative paths are already forward-slashed)
+      DirWalker::Listing archiveListing = DirWalker::files(actualContent);
+      CaseFold::KeyMap<size_t> archiveFiles;
+      archiveFiles.reserve(archiveListing.size());
+      for (size_t f = 0; f < archiveListing.size(); ++f) {
+        archiveFiles[CaseFold::Key(archiveListing[f].relative)] = f;
       }
 
       int copiedCount = 0;
+      CopyEngine::CopyBatch batch;
       for (const std::string &expectedPath : task.expectedPaths) {
-        // Normalize expected path for case-insensitive matching
-        std::string lowerExpected = expectedPath;
-        std::transform(lowerExpected.begin(), lowerExpected.end(), lowerExpected.begin(), ::tolower);
-
         // Try to find the file in the archive (case-insensitive)
         fs::path sourcePath;
-        if (archiveFiles.count(lowerExpected)) {
-          sourcePath = archiveFiles[lowerExpected];
+        auto exact = archiveFiles.find(CaseFold::Key::borrow(expectedPath));
+        if (exact != archiveFiles.end()) {
+          sourcePath = archiveListing.path(exact->second);
         } else {
-          // Try searching within subfolders (FOMOD installers often have files in subfolders)
-          for (const auto &[archivePath, fullPath] : archiveFiles) {
-            // Check if archivePath ends with expectedPath
-            if (archivePath.length() >= lowerExpected.length() &&
-                archivePath.substr(archivePath.length() - lowerExpected.length()) == lowerExpected) {
-              sourcePath = fullPath;
-              break;
+          // Try searching within subfolders (FOMOD installers often have files in subfolders).
+          // Several archive paths can end with the expected one; take the
+          // alphabetically first so the pick doesn't depend on listing order.
+          std::string bestMatch;
+          for (const auto &entry : archiveListing) {
+            if (!CaseFold::endsWith(entry.relative, expectedPath)) continue;
+            std::string folded = CaseFold::fold(entry.relative);
+            if (sourcePath.empty() || folded < bestMatch) {
+              bestMatch = std::move(folded);
+              sourcePath = archiveListing.path(entry);
             }
           }
         }
@@ -1470,80 +3306,87 @@ bool installMod(const InstallTask &task) {
         if (!sourcePath.empty() && fs::exists(sourcePath)) {
           fs::path destPath = fs::path(task.destModPath) / expectedPath;
           fs::create_directories(destPath.parent_path());
-          fs::copy_file(sourcePath, destPath, fs::copy_options::overwrite_existing);
+          batch.add(sourcePath, destPath);
           copiedCount++;
         }
       }
-
+      if (trace) {
+        trace->line("FOMOD without choices: found " + std::to_string(copiedCount) + " of " +
+                    std::to_string(task.expectedPaths.size()) + " files listed in the collection's hashes");
+      }
       if (copiedCount == 0) {
         // Hash-based install failed, fall back to standard copy
         safePrint("  [WARN] Hash-based install found 0 files for " + task.modName + ", falling back to standard\n");
-        std::string installFrom = selectVariantFolder(actualContent, task.modName);
-        for (const auto &entry : fs::directory_iterator(installFrom)) {
-          fs::copy(entry.path(), fs::path(task.destModPath) / entry.path().filename(),
-                   fs::copy_options::recursive | fs::copy_options::overwrite_existing);
-        }
+        std::string installFrom = selectVariantFolder(actualContent, task.modName, *task.layout);
+        if (trace) trace->line("copying everything from " + installFrom);
+        batch.addTree(installFrom, task.destModPath);
+      }
+      std::vector<std::string> copyErrors;
+      if (batch.run(&copyErrors) > 0) {
+        throw std::runtime_error(copyErrors.front());
       }
     } else {
       // Standard install - check for variant folder selection first
-      std::string installFrom = selectVariantFolder(actualContent, task.modName);
-
-      // DEBUG: Show what selectVariantFolder returned
-      if (task.modName.find("Cougar") != std::string::npos) {
-        safePrint("  [DEBUG " + task.modName + "] installFrom: " + installFrom + "\n");
-        safePrint("  [DEBUG " + task.modName + "] destModPath: " + task.destModPath + "\n");
+      std::string installFrom = selectVariantFolder(actualContent, task.modName, *task.layout);
+      if (trace) {
+        trace->line(installFrom == actualContent ? "standard install from " + installFrom
+                                                 : "variant folder selected: " + installFrom);
       }
 
+      RunReport::StageTimer placing(task.index, RunReport::Stage::Place);
       fs::create_directories(task.destModPath);
 
       // Count source files for verification
-      int sourceFileCount = 0;
-      for (const auto &e : fs::recursive_directory_iterator(installFrom)) {
-        if (e.is_regular_file()) sourceFileCount++;
-      }
+      int sourceFileCount = static_cast<int>(DirWalker::countFiles(installFrom));
 
-      // Copy files
-      for (const auto &entry : fs::directory_iterator(installFrom)) {
-        fs::copy(
-            entry.path(), fs::path(task.destModPath) / entry.path().filename(),
-            fs::copy_options::recursive | fs::copy_options::overwrite_existing);
+      // Copy files (batched; failures or missing files are retried below)
+      std::vector<std::string> copyErrors;
+      {
+        CopyEngine::CopyBatch batch;
+        batch.addTree(installFrom, task.destModPath);
+        batch.run(&copyErrors);
       }
+      installCheckpoint();
 
       // Verify destination file count
-      int destFileCount = 0;
-      for (const auto &e : fs::recursive_directory_iterator(task.destModPath)) {
-        if (e.is_regular_file()) destFileCount++;
-      }
+      int destFileCount = static_cast<int>(DirWalker::countFiles(task.destModPath));
 
-      // If truncated, retry with manual recursive copy
-      if (destFileCount < sourceFileCount) {
-        safePrint("  [WARN] Copy incomplete for " + task.modName +
-                  " (" + std::to_string(destFileCount) + "/" +
-                  std::to_string(sourceFileCount) + " files). Retrying...\n");
+      // If a copy failed or the tree is short, retry with manual recursive copy
+      if (!copyErrors.empty() || destFileCount < sourceFileCount) {
+        if (!copyErrors.empty()) {
+          safePrint("  [WARN] " + std::to_string(copyErrors.size()) + " file(s) failed to copy for " +
+                    task.modName + " (" + copyErrors.front() + "). Retrying...\n");
+        } else {
+          safePrint("  [WARN] Copy incomplete for " + task.modName +
+                    " (" + std::to_string(destFileCount) + "/" +
+                    std::to_string(sourceFileCount) + " files). Retrying...\n");
+        }
 
         // Clear destination and retry with explicit recursive copy
+        installCheckpoint();
         fs::remove_all(task.destModPath);
         fs::create_directories(task.destModPath);
 
         // Manual recursive copy with error catching
         try {
-            for (const auto& dirEntry : fs::recursive_directory_iterator(installFrom)) {
-                if (dirEntry.is_regular_file()) {
-                    fs::path relPath = fs::relative(dirEntry.path(), fs::path(installFrom));
-                    fs::path targetPath = fs::path(task.destModPath) / relPath;
-                    fs::create_directories(targetPath.parent_path());
-                    fs::copy_file(dirEntry.path(), targetPath, fs::copy_options::overwrite_existing);
-                }
+            DirWalker::Listing sourceListing = DirWalker::files(installFrom);
+            for (const auto& dirEntry : sourceListing) {
+                installCheckpoint();
+                fs::path targetPath = fs::path(task.destModPath) / DirWalker::toPath(dirEntry.relative);
+                fs::create_directories(targetPath.parent_path());
+                fs::copy_file(sourceListing.path(dirEntry), targetPath, fs::copy_options::overwrite_existing);
+                CopyEngine::notePlaced(fs::file_size(targetPath));
             }
+        } catch (const InstallCancelled &) {
+            throw;
         } catch (const std::exception& e) {
+            // This time a failure fails the install
             safePrint("  [ERROR] Manual copy failed: " + std::string(e.what()) + "\n");
+            throw;
         }
 
         // Re-verify
-        destFileCount = 0;
-        for (const auto &e : fs::recursive_directory_iterator(task.destModPath)) {
-          if (e.is_regular_file()) destFileCount++;
-        }
+        destFileCount = static_cast<int>(DirWalker::countFiles(task.destModPath));
 
         if (destFileCount < sourceFileCount) {
           safePrint("  [ERROR] Copy still incomplete after retry for " + task.modName +
@@ -1553,31 +3396,375 @@ bool installMod(const InstallTask &task) {
       }
     }
 
-    // Ensure Data folder is flattened (match Vortex structure)
-    flattenDataFolder(task.destModPath);
-
-    // Cleanup
-    fs::remove_all(extractPath);
+    // Ensure Data folder is flattened (match Vortex structure)
+    installCheckpoint();
+    flattenDataFolder(task.destModPath);
+    if (trace) trace->tree("Installed", task.destModPath);
+    return finishInstall(task);
+
+  } catch (const std::exception &e) {
+    // A cancelled attempt stays quiet: the watchdog reports and retries it,
+    // and the retry reuses the staging if extraction had finished
+    if (trace) trace->line(std::string("attempt ended: ") + e.what());
+    if (!dynamic_cast<const InstallCancelled *>(&e) && settleInstall()) {
+      RunReport::installFailed(task.index, e.what());
+      safePrint("  [" + std::to_string(task.index + 1) + "/" +
+                std::to_string(task.total) + "] " + task.modName +
+                " - FAILED: " + std::string(e.what()) + "\n");
+      g_failed++;
+      try {
+        g_staging.release(task);
+      } catch (...) {
+      }
+    }
+    return false;
+  }
+}
+
+// Hands out install tasks in collection phase order (tasks must be sorted
+// by phase). Tasks that need earlier phases on disk wait until all of them
+// have finished; the rest run straight away so workers never sit idle at
+// a phase boundary while there is independent work left.
+class PhaseScheduler {
+public:
+  explicit PhaseScheduler(std::vector<InstallTask> &tasks)
+      : tasks_(tasks), started_(tasks.size(), 0), attempts_(tasks.size(), 0),
+        firstAdded_(tasks.size()) {
+    for (const auto &task : tasks) unfinished_[task.phase]++;
+  }
+
+  // Blocks until a task is runnable. Returns false once every task has
+  // been handed out (and the scheduler isn't held open). attempt is how
+  // many times the task was retried.
+  bool next(size_t &out, int &attempt) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      while (cursor_ < tasks_.size() && started_[cursor_]) cursor_++;
+      if (cursor_ >= tasks_.size()) {
+        if (!open_) return false;
+        cv_.wait(lock);
+        continue;
+      }
+
+      int lowestUnfinished = unfinished_.empty() ? INT_MAX : unfinished_.begin()->first;
+      for (size_t i = cursor_; i < tasks_.size(); ++i) {
+        if (started_[i]) continue;
+        if (tasks_[i].waitsForEarlierPhases && tasks_[i].phase > lowestUnfinished) continue;
+        started_[i] = 1;
+        out = i;
+        attempt = attempts_[i];
+        return true;
+      }
+      cv_.wait(lock);
+    }
+  }
+
+  // ok: whether the install succeeded
+  void finish(size_t idx, bool ok) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idx >= firstAdded_) outcomes_.emplace_back(idx, ok);
+    auto it = unfinished_.find(tasks_[idx].phase);
+    if (it != unfinished_.end() && --it->second == 0) {
+      unfinished_.erase(it);
+      cv_.notify_all();
+    }
+  }
+
+  // Hand a started (unfinished) task out again
+  void retry(size_t idx) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    started_[idx] = 0;
+    attempts_[idx]++;
+    cursor_ = std::min(cursor_, idx);
+    cv_.notify_all();
+  }
+
+  // Watch mode: workers wait for add() instead of finishing until close()
+  void holdOpen() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = true;
+  }
+
+  // Append a task while the pool runs and return its index. The task
+  // vector must have capacity reserved for it: workers hold references
+  // into it.
+  size_t add(InstallTask task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.size() == tasks_.capacity()) {
+      throw std::logic_error("PhaseScheduler::add without reserved capacity");
+    }
+    unfinished_[task.phase]++;
+    tasks_.push_back(std::move(task));
+    started_.push_back(0);
+    attempts_.push_back(0);
+    cv_.notify_all();
+    return tasks_.size() - 1;
+  }
+
+  // How the tasks from add() that finished since the last call went
+  // (task index, succeeded)
+  std::vector<std::pair<size_t, bool>> takeOutcomes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::exchange(outcomes_, {});
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = false;
+    cv_.notify_all();
+  }
+
+private:
+  std::vector<InstallTask> &tasks_;
+  std::vector<char> started_;
+  std::vector<int> attempts_;
+  std::map<int, size_t> unfinished_;  // phase -> tasks not yet finished
+  size_t firstAdded_;                 // Tasks from here on came from add()
+  std::vector<std::pair<size_t, bool>> outcomes_;
+  size_t cursor_ = 0;                 // Everything before this has started
+  bool open_ = false;                 // More tasks may still be added
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+// Runs install tasks on worker threads under a watchdog. An attempt that
+// runs past its stage deadline, or stops making copy progress for the
+// stall limit, is cancelled: its 7z is killed and its copies stop at the
+// next file. A replacement worker takes over the slot straight away, since
+// the stuck thread may be blocked in I/O that can't be interrupted. The
+// task is requeued with a clean mod folder (and a fresh extraction if
+// that is what stalled), plain one-at-a-time copies and doubled
+// deadlines; if that stalls too, the mod is marked failed. A retry waits
+// for the stalled thread to stop before it touches the mod folder.
+//
+// In background mode installs only get idle CPU and I/O and can starve
+// for minutes on a busy machine, so their clocks run at a quarter speed
+// while it is on (for at most half an hour per attempt, so a hung install
+// still trips the watchdog).
+class InstallPool {
+public:
+  static constexpr int kMaxAttempts = 2;
+  static constexpr std::chrono::minutes kMaxBackgroundStretch{30};
+
+  InstallPool(const std::vector<InstallTask> &tasks, PhaseScheduler &scheduler,
+              std::chrono::seconds stallLimit)
+      : tasks_(tasks), scheduler_(scheduler), stallLimit_(stallLimit) {}
+
+  // stallLimit 0 turns the watchdog off
+  void run(unsigned threads) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (unsigned t = 0; t < threads; ++t) spawnWorker();
+
+    std::thread watchdog;
+    if (stallLimit_.count() > 0) watchdog = std::thread([this] { watch(); });
+
+    idle_.wait(lock, [this] { return active_ == 0; });
+    stopping_ = true;
+    lock.unlock();
+    idle_.notify_all();
+    if (watchdog.joinable()) watchdog.join();
+
+    // Cancelled workers normally notice within a fraction of a second (and
+    // kill their 7z); give them that long before leaving them behind
+    auto graceEnd = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    for (auto &worker : workers_) {
+      while (worker.abandoned && !*worker.exited && std::chrono::steady_clock::now() < graceEnd) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+    }
+
+    // Workers still blocked can't be joined; they hold only their own
+    // copies of the task and exit on their own once unblocked. Until they
+    // do, the process must not run static destructors (see stranded()).
+    size_t stuck = 0;
+    for (auto &worker : workers_) {
+      if (!worker.abandoned || *worker.exited) {
+        worker.thread.join();
+      } else {
+        if (worker.stalled) worker.stalled->releaseResources();
+        worker.thread.detach();
+        std::lock_guard<std::mutex> lock(strandedMutex());
+        strandedWorkers().push_back(worker.exited);
+        stuck++;
+      }
+    }
+    if (stuck > 0) {
+      safePrint("  [WARN] " + std::to_string(stuck) +
+                " stalled install thread(s) are still blocked and were left behind\n");
+    }
+  }
+
+  // Detached workers of any pool that are still running
+  static bool stranded() {
+    std::lock_guard<std::mutex> lock(strandedMutex());
+    for (const auto &exited : strandedWorkers()) {
+      if (!*exited) return true;
+    }
+    return false;
+  }
+
+private:
+  // Never destroyed, so a stranded worker can't outlive them
+  static std::mutex &strandedMutex() {
+    static std::mutex *mutex = new std::mutex;
+    return *mutex;
+  }
+  static std::vector<std::shared_ptr<std::atomic<bool>>> &strandedWorkers() {
+    static auto *workers = new std::vector<std::shared_ptr<std::atomic<bool>>>;
+    return *workers;
+  }
+
+  struct Worker {
+    std::thread thread;
+    std::shared_ptr<InstallAttempt> attempt;  // Current attempt, if any
+    bool abandoned = false;                   // Replaced after a stall
+    std::shared_ptr<InstallAttempt> stalled;  // Attempt it was abandoned in, until its lease is back
+    std::chrono::steady_clock::time_point abandonedAt;
+    std::shared_ptr<std::atomic<bool>> exited = std::make_shared<std::atomic<bool>>(false);
+  };
+
+  // Called with mutex_ held
+  void spawnWorker() {
+    workers_.emplace_back();
+    Worker *worker = &workers_.back();
+    active_++;
+    worker->thread = std::thread([this, worker] { work(worker); });
+  }
+
+  void work(Worker *self) {
+    std::shared_ptr<std::atomic<bool>> exited = self->exited;
+    size_t idx;
+    int attemptNumber;
+    while (scheduler_.next(idx, attemptNumber)) {
+      auto attempt = std::make_shared<InstallAttempt>(idx, attemptNumber);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        self->attempt = attempt;
+        auto stalled = stalledExited_.find(idx);
+        if (stalled != stalledExited_.end()) attempt->previousExited = stalled->second;
+      }
+
+      InstallTask task = tasks_[idx];
+      task.attempt = attemptNumber;
+      bool ok = runAttempt(task, attempt.get());
+
+      if (!attempt->settle()) {
+        // The watchdog gave up on us and a replacement has our slot; the
+        // pool may already be gone, so touch nothing but our own state
+        *exited = true;
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        self->attempt.reset();
+      }
+      notifyInstallFinished(task, ok);
+      scheduler_.finish(idx, ok);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_--;
+    *exited = true;
+    idle_.notify_all();
+  }
 
-    g_installed++;
-    safePrint("  [" + std::to_string(task.index + 1) + "/" +
-              std::to_string(task.total) + "] " + task.modName + " - Done!\n");
-    return true;
+  static bool runAttempt(const InstallTask &task, InstallAttempt *attempt) {
+    t_installAttempt = attempt;
+    CopyEngine::setThreadSequential(task.attempt > 0);
+    CopyEngine::setThreadProgressHook([attempt](size_t) {
+      attempt->beat();
+      return !attempt->cancelRequested();
+    });
+    auto started = RunReport::Clock::now();
+    uint64_t placedBefore = CopyEngine::threadBytesPlaced();
+    bool ok = installMod(task);
+    attempt->releaseResources();
+    RunReport::installAttempt(task.index, started, RunReport::Clock::now(), ok,
+                              CopyEngine::threadBytesPlaced() - placedBefore);
+    CopyEngine::setThreadProgressHook(nullptr);
+    CopyEngine::setThreadSequential(false);
+    t_installAttempt = nullptr;
+    return ok;
+  }
 
-  } catch (const std::exception &e) {
-    safePrint("  [" + std::to_string(task.index + 1) + "/" +
-              std::to_string(task.total) + "] " + task.modName +
-              " - FAILED: " + std::string(e.what()) + "\n");
-    g_failed++;
-    if (fs::exists(extractPath)) {
-      try {
-        fs::remove_all(extractPath);
-      } catch (...) {
+  void watch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto lastCheck = std::chrono::steady_clock::now();
+    bool wasBackground = BackgroundQos::active();
+    while (!stopping_) {
+      idle_.wait_for(lock, std::chrono::seconds(1));
+      if (stopping_) break;
+      auto now = std::chrono::steady_clock::now();
+      auto sinceLast = now - lastCheck;
+      lastCheck = now;
+      // The interval in which the mode changed counts as background too
+      bool background = BackgroundQos::active();
+      bool slowed = background || wasBackground;
+      wasBackground = background;
+      // spawnWorker appends; std::list keeps this iteration valid
+      for (auto &worker : workers_) {
+        if (worker.stalled) returnStalledLease(worker, now);
+        if (worker.abandoned || !worker.attempt) continue;
+        if (slowed) worker.attempt->stretch(sinceLast * 3 / 4, kMaxBackgroundStretch);
+        std::string reason = worker.attempt->overdue(stallLimit_);
+        if (reason.empty() || !worker.attempt->cancel()) continue;
+
+        worker.abandoned = true;
+        worker.abandonedAt = now;
+        stalledExited_[worker.attempt->taskIndex] = worker.exited;
+        active_--;
+        giveUp(*worker.attempt, reason);
+        worker.stalled = std::move(worker.attempt);
+        spawnWorker();
       }
     }
-    return false;
   }
-}
+
+  // A cancelled attempt keeps its resource lease until its thread exits
+  // (it returns the lease itself), so the heavy-task budget isn't
+  // overcommitted while it may still be copying. A thread that hasn't
+  // exited after kStalledExitWait is blocked in the kernel, not working;
+  // its lease goes back then so one stuck call can't starve the run.
+  // Called with mutex_ held.
+  void returnStalledLease(Worker &worker, std::chrono::steady_clock::time_point now) {
+    if (*worker.exited) {
+      worker.stalled.reset();
+    } else if (now - worker.abandonedAt >= kStalledExitWait) {
+      worker.stalled->releaseResources();
+      worker.stalled.reset();
+    }
+  }
+
+  // Called with mutex_ held
+  void giveUp(const InstallAttempt &attempt, const std::string &reason) {
+    const InstallTask &task = tasks_[attempt.taskIndex];
+    std::string why = "stalled while " + attempt.stage() + " (" + reason + ")";
+    bool lastAttempt = attempt.number + 1 >= kMaxAttempts;
+    g_staging.abandon(task, lastAttempt);
+    if (!lastAttempt) {
+      safePrint("  [WARN] " + task.modName + " " + why + ", retrying\n");
+      scheduler_.retry(attempt.taskIndex);
+    } else {
+      safePrint("  [" + std::to_string(task.index + 1) + "/" +
+                std::to_string(task.total) + "] " + task.modName +
+                " - FAILED: " + why + "\n");
+      g_failed++;
+      RunReport::installFailed(task.index, why);
+      notifyInstallFinished(task, false);
+      scheduler_.finish(attempt.taskIndex, false);
+    }
+  }
+
+  const std::vector<InstallTask> &tasks_;
+  PhaseScheduler &scheduler_;
+  std::chrono::seconds stallLimit_;
+  std::list<Worker> workers_;
+  std::map<size_t, std::shared_ptr<std::atomic<bool>>> stalledExited_;  // Task -> its stalled thread
+  unsigned active_ = 0;   // Workers not yet finished or abandoned
+  bool stopping_ = false;
+  std::mutex mutex_;
+  std::condition_variable idle_;
+};
 
 // ============================================================================
 // Mod List Generator (modlist.txt)
@@ -1791,14 +3978,12 @@ public:
   }
 
   // Build plugin position map from sorted plugins
-  static std::map<std::string, int> buildPluginPositionMap(
+  static CaseFold::KeyMap<int> buildPluginPositionMap(
       const std::vector<std::string> &sortedPlugins) {
-    std::map<std::string, int> pluginPosition;
+    CaseFold::KeyMap<int> pluginPosition;
+    pluginPosition.reserve(sortedPlugins.size());
     for (size_t i = 0; i < sortedPlugins.size(); ++i) {
-      std::string pluginLower = sortedPlugins[i];
-      std::transform(pluginLower.begin(), pluginLower.end(), pluginLower.begin(),
-                     [](unsigned char c) { return std::tolower(c); });
-      pluginPosition[pluginLower] = static_cast<int>(i);
+      pluginPosition[CaseFold::Key(sortedPlugins[i])] = static_cast<int>(i);
     }
     return pluginPosition;
   }
@@ -1806,25 +3991,16 @@ public:
   // Get the earliest plugin position for a mod folder
   static int getModPluginPosition(const std::string &modFolder,
                                    const std::string &modsDir,
-                                   const std::map<std::string, int> &pluginPosition) {
+                                   const CaseFold::KeyMap<int> &pluginPosition) {
     fs::path modPath = fs::path(modsDir) / modFolder;
     if (!fs::exists(modPath)) return INT_MAX;
 
     int earliestPos = INT_MAX;
     try {
-      for (const auto &entry : fs::recursive_directory_iterator(modPath)) {
-        if (!entry.is_regular_file()) continue;
-
-        std::string ext = entry.path().extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-
-        if (ext == ".esp" || ext == ".esm" || ext == ".esl") {
-          std::string pluginLower = entry.path().filename().string();
-          std::transform(pluginLower.begin(), pluginLower.end(), pluginLower.begin(),
-                         [](unsigned char c) { return std::tolower(c); });
-
-          auto it = pluginPosition.find(pluginLower);
+      for (const auto &entry : DirWalker::files(modPath)) {
+        if (CaseFold::endsWith(entry.name, ".esp") || CaseFold::endsWith(entry.name, ".esm") ||
+            CaseFold::endsWith(entry.name, ".esl")) {
+          auto it = pluginPosition.find(CaseFold::Key::borrow(entry.name));
           if (it != pluginPosition.end()) {
             earliestPos = std::min(earliestPos, it->second);
           }
@@ -1923,7 +4099,7 @@ public:
     }
 
     // Build plugin position map
-    std::map<std::string, int> pluginPosition = buildPluginPositionMap(sortedPlugins);
+    CaseFold::KeyMap<int> pluginPosition = buildPluginPositionMap(sortedPlugins);
 
     // Pre-compute plugin positions for each mod
     std::vector<int> modPluginPos(n);
@@ -2011,10 +4187,18 @@ public:
     }
 
     // =========================================================================
-    // Method 4: Collection Order (original order from collection)
+    // Method 4: Collection Order (install phase, then order in collection)
     // =========================================================================
+    // Later phases are installed after earlier ones in Vortex, so they win
+    // conflicts that no rule decides
+    std::vector<int> phaseIndices(n);
+    std::iota(phaseIndices.begin(), phaseIndices.end(), 0);
+    std::stable_sort(phaseIndices.begin(), phaseIndices.end(),
+                     [&](int a, int b) { return mods[a].phase < mods[b].phase; });
     std::vector<int> collectionRank(n);
-    std::iota(collectionRank.begin(), collectionRank.end(), 0);
+    for (size_t i = 0; i < phaseIndices.size(); ++i) {
+      collectionRank[phaseIndices[i]] = static_cast<int>(i);
+    }
 
     // =========================================================================
     // Combine votes: weighted average of ranks
@@ -2112,136 +4296,1024 @@ public:
     return "";
   }
 
-  // Sort plugins using libloot
-  static std::vector<std::string>
-  sortPluginsWithLoot(const std::string &gamePath,
-                      const std::string &modsDir,
-                      const std::vector<PluginInfo> &plugins) {
-    std::vector<std::string> sortedPlugins;
+  static void writePluginList(const std::string &path,
+                              const std::vector<std::string> &pluginOrder) {
+    std::ofstream out(path);
+    out << "# This file was automatically generated by NexusBridge"
+        << std::endl;
+
+    for (const auto &pluginName : pluginOrder) {
+      out << "*" << pluginName << std::endl;
+    }
+
+    out.close();
+    std::cout << "Generated plugins.txt with " << pluginOrder.size() << " plugins"
+              << std::endl;
+  }
+};
 
+// ============================================================================
+// Plugin Preloading
+// ============================================================================
+
+// Loads plugin headers into LOOT while Phase 2 is still running. Each mod
+// that finishes installing is handed over, and the enabled plugins in its
+// root are loaded on a background thread. Once every install that could
+// bring a plugin is over (whether it worked or not) the sort runs too,
+// overlapping the tail of big texture installs instead of following it.
+// finish() checks the result against the mods folder as it ended up and
+// only redoes what changed.
+class PluginPreloader {
+public:
+  PluginPreloader(const std::string &gamePath, const std::string &modsDir,
+                  const std::vector<PluginInfo> &plugins)
+      : gamePath_(gamePath), modsDir_(modsDir) {
+    for (const auto &plugin : plugins) {
+      if (!plugin.enabled) continue;
+      collectionOrder_.push_back(plugin.name);
+      if (wanted_.insert(CaseFold::Key(plugin.name)).second) {
+        pluginNames_.push_back(plugin.name);
+      }
+    }
+    // Mods from an earlier run, listed before any install starts writing
+    // to the mods folder; everything after that arrives via modInstalled
+    existingMods_ = listModFolders();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  ~PluginPreloader() { stop(); }
+
+  // A collection entry is going to be installed (before Phase 2 starts).
+  // The sort waits for it if the collection's file list has an enabled
+  // plugin in it, or if there is no list to tell.
+  void expect(size_t entry, const std::vector<std::string> &expectedPaths) {
+    bool bringsPlugin = expectedPaths.empty();
+    for (const auto &path : expectedPaths) {
+      size_t slash = path.find_last_of('/');
+      std::string_view name = std::string_view(path).substr(slash == std::string::npos ? 0 : slash + 1);
+      if (wanted_.count(CaseFold::Key::borrow(name))) bringsPlugin = true;
+    }
+    if (!bringsPlugin) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    outstanding_.insert(entry);
+  }
+
+  // An entry's install is over (called from install workers); its mod
+  // folder is scanned if it worked
+  void installFinished(size_t entry, const std::string &modPath, bool ok) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (ok) pending_.push_back(modPath);
+      outstanding_.erase(entry);
+      changed_ = true;
+    }
+    wake_.notify_one();
+  }
+
+  // Load order sorted by LOOT, or collection order if LOOT can't be used
+  std::vector<std::string> finish() {
+    stop();
     try {
-      // Find local app data folder
-      std::string localPath = findLocalAppData();
-      std::cout << "  Local app data: " << (localPath.empty() ? "(not found)" : localPath) << std::endl;
-
-      // Create game handle for Skyrim SE
-      auto game = loot::CreateGameHandle(
-          loot::GameType::tes5se,
-          fs::path(gamePath),
-          localPath.empty() ? fs::path() : fs::path(localPath));
-
-      // Set additional data paths (MO2 virtual filesystem mods)
-      // Each mod folder's root is effectively a data path
-      std::vector<fs::path> additionalPaths;
-      if (fs::exists(modsDir)) {
-        for (const auto &entry : fs::directory_iterator(modsDir)) {
-          if (entry.is_directory()) {
-            additionalPaths.push_back(entry.path());
-          }
+      if (!error_.empty()) throw std::runtime_error(error_);
+      if (!game_) throw std::runtime_error("game handle was not created");
+
+      std::cout << "  Local app data: " << (localPath_.empty() ? "(not found)" : localPath_) << std::endl;
+      std::cout << "  Unique plugins: " << pluginNames_.size() << " (from "
+                << collectionOrder_.size() << " total)" << std::endl;
+
+      // The copies that count: first mod folder (in listing order) with
+      // the plugin in its root, else the game's Data folder
+      std::vector<fs::path> modFolders = listModFolders();
+      CaseFold::KeyMap<fs::path> chosen;
+      for (const auto &modDir : modFolders) collectPlugins(modDir, chosen);
+      for (const auto &name : pluginNames_) {
+        if (chosen.count(CaseFold::Key::borrow(name))) continue;
+        fs::path gamePluginPath = fs::path(gamePath_) / "Data" / name;
+        if (fs::exists(gamePluginPath)) chosen.emplace(CaseFold::Key(name), gamePluginPath);
+      }
+
+      std::vector<fs::path> reload;
+      for (const auto &[key, path] : chosen) {
+        auto it = loaded_.find(key);
+        if (it == loaded_.end() || it->second != path) reload.push_back(path);
+      }
+      if (!reload.empty()) game_->LoadPlugins(reload, true);
+      std::cout << "  Loaded " << chosen.size() << " plugins for LOOT sorting ("
+                << chosen.size() - reload.size() << " while installing)" << std::endl;
+
+      if (haveEarlySort_ && reload.empty() && chosen == sortedWith_) {
+        std::cout << "  LOOT sorted " << earlySort_.size() << " plugins (during install)" << std::endl;
+        return earlySort_;
+      }
+      if (!modFolders.empty()) game_->SetAdditionalDataPaths(modFolders);
+      std::vector<std::string> sorted = game_->SortPlugins(existingNames(chosen));
+      std::cout << "  LOOT sorted " << sorted.size() << " plugins" << std::endl;
+      return sorted;
+
+    } catch (const std::exception &e) {
+      std::cerr << "  [WARN] LOOT sorting failed: " << e.what() << std::endl;
+      std::cerr << "  Falling back to collection order" << std::endl;
+      return collectionOrder_;
+    }
+  }
+
+private:
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void run() {
+    try {
+      localPath_ = PluginListGenerator::findLocalAppData();
+      game_ = loot::CreateGameHandle(loot::GameType::tes5se, fs::path(gamePath_),
+                                     localPath_.empty() ? fs::path() : fs::path(localPath_));
+
+      // Base game plugins (a mod may still replace them, e.g. cleaned
+      // masters) and mods installed by an earlier run
+      std::vector<fs::path> batch;
+      for (const auto &name : pluginNames_) {
+        fs::path gamePluginPath = fs::path(gamePath_) / "Data" / name;
+        if (fs::exists(gamePluginPath)) {
+          CaseFold::Key key(name);
+          fromGameData_.insert(key);
+          loaded_.emplace(std::move(key), gamePluginPath);
+          batch.push_back(gamePluginPath);
         }
       }
-      if (!additionalPaths.empty()) {
-        game->SetAdditionalDataPaths(additionalPaths);
+      for (const auto &modDir : existingMods_) queuePlugins(modDir, batch);
+      load(batch);
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true) {
+        wake_.wait(lock, [this] { return stopping_ || changed_; });
+        if (!changed_) break;
+        changed_ = false;
+        std::vector<std::string> mods;
+        mods.swap(pending_);
+        bool allOver = outstanding_.empty();
+        lock.unlock();
+
+        batch.clear();
+        for (const auto &modDir : mods) queuePlugins(modDir, batch);
+        load(batch);
+        if (allOver) sortEarly();
+        lock.lock();
+      }
+    } catch (const std::exception &e) {
+      error_ = e.what();
+    }
+  }
+
+  std::vector<fs::path> listModFolders() const {
+    std::vector<fs::path> folders;
+    DirWalker::Listing listing = DirWalker::children(modsDir_);
+    for (const auto &entry : listing) {
+      if (entry.isDirectory()) folders.push_back(listing.path(entry));
+    }
+    return folders;
+  }
+
+  // Enabled plugins in a mod's root that aren't in the map yet
+  void collectPlugins(const fs::path &modDir, CaseFold::KeyMap<fs::path> &into) const {
+    DirWalker::Listing rootFiles = DirWalker::children(modDir);
+    for (const auto &entry : rootFiles) {
+      if (!entry.isFile()) continue;
+      CaseFold::Key probe = CaseFold::Key::borrow(entry.name);
+      if (wanted_.count(probe) && !into.count(probe)) {
+        into.emplace(CaseFold::Key(entry.name), rootFiles.path(entry));
+      }
+    }
+  }
+
+  // Queue a mod's plugins for loading unless another mod already provided
+  // them (the same file again means it was reinstalled: load it again)
+  void queuePlugins(const fs::path &modDir, std::vector<fs::path> &batch) {
+    CaseFold::KeyMap<fs::path> found;
+    collectPlugins(modDir, found);
+    for (auto &[key, path] : found) {
+      auto it = loaded_.find(key);
+      if (it != loaded_.end() && !fromGameData_.count(key) && it->second != path) continue;
+      fromGameData_.erase(key);
+      batch.push_back(path);
+      loaded_[key] = path;
+    }
+  }
+
+  // A batch that fails to load (a plugin still being written, say) is
+  // forgotten, so finish() loads those plugins again
+  void load(const std::vector<fs::path> &batch) {
+    if (batch.empty()) return;
+    haveEarlySort_ = false;
+    try {
+      game_->LoadPlugins(batch, true);
+    } catch (const std::exception &) {
+      std::set<fs::path> failed(batch.begin(), batch.end());
+      for (auto it = loaded_.begin(); it != loaded_.end();) {
+        it = failed.count(it->second) ? loaded_.erase(it) : std::next(it);
+      }
+    }
+  }
+
+  // Every install that could bring a plugin is over: sort now rather
+  // than after the last (plugin-less) mod finishes copying. Plugins whose
+  // mods failed are simply missing, as they will be in finish().
+  void sortEarly() {
+    if (haveEarlySort_) return;
+    try {
+      std::vector<fs::path> modFolders = listModFolders();
+      if (!modFolders.empty()) game_->SetAdditionalDataPaths(modFolders);
+      earlySort_ = game_->SortPlugins(existingNames(loaded_));
+      sortedWith_ = loaded_;
+      haveEarlySort_ = true;
+    } catch (const std::exception &) {
+      // finish() sorts instead
+    }
+  }
+
+  // Collection's plugin names that have a file, in collection order
+  std::vector<std::string> existingNames(const CaseFold::KeyMap<fs::path> &paths) const {
+    std::vector<std::string> names;
+    for (const auto &name : pluginNames_) {
+      if (paths.count(CaseFold::Key::borrow(name))) names.push_back(name);
+    }
+    return names;
+  }
+
+  const std::string gamePath_;
+  const std::string modsDir_;
+  std::vector<std::string> collectionOrder_;  // Enabled plugins, as listed
+  std::vector<std::string> pluginNames_;      // Same, without duplicates
+  CaseFold::KeySet wanted_;
+  std::vector<fs::path> existingMods_;        // Mod folders before installing
+
+  // Background thread only (until finish() has joined it)
+  std::unique_ptr<loot::GameInterface> game_;
+  std::string localPath_;
+  std::string error_;
+  CaseFold::KeyMap<fs::path> loaded_;  // Plugin -> file loaded for it
+  CaseFold::KeySet fromGameData_;      // Loaded from the game, not a mod
+  std::vector<std::string> earlySort_;
+  CaseFold::KeyMap<fs::path> sortedWith_;
+  bool haveEarlySort_ = false;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<std::string> pending_;   // Mod folders to scan
+  std::set<size_t> outstanding_;       // Entries from expect() not finished
+  bool changed_ = false;               // An install finished since the last look
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+static PluginPreloader *g_pluginPreloader = nullptr;
+
+static void notifyInstallFinished(const InstallTask &task, bool ok) {
+  if (g_pluginPreloader) g_pluginPreloader->installFinished(task.index, task.destModPath, ok);
+}
+
+// ============================================================================
+// MO2 Metadata Writer (downloads/*.meta and mods/*/meta.ini)
+// ============================================================================
+
+// One mod's worth of metadata. Empty modDir/archivePath skips that file.
+struct Mo2MetaJob {
+  std::string modDir;
+  std::string archivePath;
+  std::string modName;
+  std::string fileName;  // Nexus file display name (falls back to modName)
+  std::string version;
+  int modId = -1;
+  int fileId = -1;
+  bool installed = false;
+};
+
+class Mo2MetaWriter {
+public:
+  // MO2's gameShortName for a Nexus domain (used in meta.ini)
+  static std::string mo2GameName(const std::string &domain) {
+    static const std::map<std::string, std::string> names = {
+        {"skyrimspecialedition", "SkyrimSE"},
+        {"skyrim", "Skyrim"},
+        {"skyrimvr", "SkyrimVR"},
+        {"enderal", "Enderal"},
+        {"enderalspecialedition", "EnderalSE"},
+        {"fallout4", "Fallout4"},
+        {"fallout4vr", "Fallout4VR"},
+        {"fallout3", "Fallout3"},
+        {"newvegas", "FalloutNV"},
+        {"oblivion", "Oblivion"},
+        {"morrowind", "Morrowind"},
+        {"starfield", "Starfield"}};
+    auto it = names.find(domain);
+    return it != names.end() ? it->second : domain;
+  }
+
+  // Quote a value the way QSettings expects (commas would otherwise turn it
+  // into a string list when MO2 reads it back)
+  static std::string iniValue(const std::string &value) {
+    bool needsQuotes = value.find_first_of(",;=\"\\") != std::string::npos ||
+                       (!value.empty() && (value.front() == ' ' || value.back() == ' '));
+    if (!needsQuotes) return value;
+
+    std::string quoted = "\"";
+    for (char c : value) {
+      if (c == '"' || c == '\\') quoted += '\\';
+      quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+  }
+
+  // True if meta.ini is missing or was written without a Nexus mod ID
+  // (e.g. created by MO2 itself before NexusBridge ran)
+  static bool needsModMeta(const fs::path &metaIni) {
+    std::ifstream in(metaIni);
+    if (!in) return true;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.rfind("modid=", 0) == 0) {
+        std::string id = trim(line.substr(6));
+        return id.empty() || id == "0" || id == "-1";
+      }
+    }
+    return true;
+  }
+
+  static void writeModMeta(const Mo2MetaJob &job, const std::string &gameName,
+                           const std::string &timestamp) {
+    fs::path metaIni = fs::path(job.modDir) / "meta.ini";
+    if (!needsModMeta(metaIni)) return;
+
+    std::string installationFile =
+        job.archivePath.empty() ? "" : fs::path(job.archivePath).filename().string();
+
+    std::ofstream out(metaIni, std::ios::trunc);
+    out << "[General]\n";
+    out << "gameName=" << gameName << "\n";
+    out << "modid=" << job.modId << "\n";
+    out << "version=" << iniValue(job.version) << "\n";
+    out << "newestVersion=" << iniValue(job.version) << "\n";
+    out << "category=\n";
+    out << "nexusFileStatus=1\n";
+    out << "installationFile=" << iniValue(installationFile) << "\n";
+    out << "repository=Nexus\n";
+    out << "comments=\n";
+    out << "notes=\n";
+    out << "nexusDescription=\n";
+    out << "url=\n";
+    out << "hasCustomURL=false\n";
+    // Recent query/update stamps stop MO2 from re-querying Nexus on startup
+    out << "lastNexusQuery=" << timestamp << "\n";
+    out << "lastNexusUpdate=" << timestamp << "\n";
+    out << "nexusLastModified=" << timestamp << "\n";
+    out << "converted=false\n";
+    out << "validated=false\n";
+    out << "\n[installedFiles]\n";
+    out << "1\\modid=" << job.modId << "\n";
+    out << "1\\fileid=" << job.fileId << "\n";
+    out << "size=1\n";
+  }
+
+  static void writeDownloadMeta(const Mo2MetaJob &job, const std::string &gameDomain) {
+    fs::path metaFile = job.archivePath + ".meta";
+    if (fs::exists(metaFile)) return;
+
+    std::ofstream out(metaFile, std::ios::trunc);
+    out << "[General]\n";
+    out << "gameName=" << gameDomain << "\n";
+    out << "modID=" << job.modId << "\n";
+    out << "fileID=" << job.fileId << "\n";
+    out << "url=\n";
+    out << "name=" << iniValue(job.fileName.empty() ? job.modName : job.fileName) << "\n";
+    out << "description=\n";
+    out << "modName=" << iniValue(job.modName) << "\n";
+    out << "version=" << iniValue(job.version) << "\n";
+    out << "newestVersion=" << iniValue(job.version) << "\n";
+    out << "fileTime=\n";
+    out << "fileCategory=0\n";
+    out << "category=0\n";
+    out << "repository=Nexus\n";
+    out << "installed=" << (job.installed ? "true" : "false") << "\n";
+    out << "uninstalled=false\n";
+    out << "paused=false\n";
+    out << "removed=false\n";
+  }
+
+  // Write all metadata files in parallel; returns number of jobs processed
+  static int writeAll(const std::vector<Mo2MetaJob> &jobs,
+                      const std::string &gameDomain, unsigned int numThreads) {
+    if (jobs.empty()) return 0;
+
+    // Qt ISO date format, computed once (gmtime isn't thread-safe)
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    std::string gameName = mo2GameName(gameDomain);
+
+    // Hand out jobs in batches so small writes don't contend on the index
+    const size_t batchSize = 32;
+    std::atomic<size_t> nextBatch{0};
+    std::atomic<int> written{0};
+
+    auto worker = [&]() {
+      while (true) {
+        size_t start = nextBatch.fetch_add(batchSize);
+        if (start >= jobs.size()) break;
+        size_t end = std::min(start + batchSize, jobs.size());
+
+        for (size_t i = start; i < end; ++i) {
+          const auto &job = jobs[i];
+          try {
+            if (!job.modDir.empty() && fs::is_directory(job.modDir)) {
+              writeModMeta(job, gameName, timestamp);
+            }
+            if (!job.archivePath.empty() && fs::exists(job.archivePath)) {
+              writeDownloadMeta(job, gameDomain);
+            }
+            written++;
+          } catch (const std::exception &e) {
+            std::lock_guard<std::mutex> lock(g_printMutex);
+            std::cerr << "  [WARN] Failed to write MO2 metadata for " << job.modName
+                      << ": " << e.what() << std::endl;
+          }
+        }
       }
+    };
+
+    unsigned int threads = std::min<unsigned int>(
+        numThreads, static_cast<unsigned int>((jobs.size() + batchSize - 1) / batchSize));
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; ++t) {
+      pool.emplace_back(worker);
+    }
+    for (auto &t : pool) {
+      t.join();
+    }
+
+    return written.load();
+  }
+};
+
+// ============================================================================
+// BSA Packing (optional post-install stage)
+// ============================================================================
+
+struct BsaPackOptions {
+  bool compress = false;                  // LZ4 instead of uncompressed
+  std::vector<std::string> excludeGlobs;  // Relative paths that must stay loose
+  size_t minFiles = 25;                   // Smaller mods aren't worth an archive
+};
+
+struct BsaPackResult {
+  int modsPacked = 0;
+  int archivesWritten = 0;
+  size_t filesPacked = 0;
+  uintmax_t bytesPacked = 0;
+  std::vector<std::string> dummyPlugins;  // Must be added to plugins.txt
+};
+
+class BsaPacker {
+public:
+  static bool supportsGame(const std::string &domain) {
+    return domain == "skyrimspecialedition" || domain == "enderalspecialedition";
+  }
 
-      // Collect unique plugin names that are enabled
-      std::vector<std::string> pluginNames;
-      std::set<std::string> seenPlugins;
-      for (const auto &plugin : plugins) {
-        if (plugin.enabled) {
-          std::string nameLower = plugin.name;
-          std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-                         [](unsigned char c) { return std::tolower(c); });
-          if (seenPlugins.insert(nameLower).second) {
-            pluginNames.push_back(plugin.name);
+  static BsaPackResult packAll(const std::vector<ModInfo> &mods,
+                               const std::string &modsDir,
+                               const std::string &manifestDir,
+                               const BsaPackOptions &options,
+                               unsigned int numThreads) {
+    BsaPackResult result;
+
+    std::vector<InstallManifest> manifests;
+    std::vector<char> present;
+    loadManifests(mods, modsDir, manifestDir, numThreads, manifests, present);
+
+    // Anything provided by more than one mod (loose or in an existing BSA)
+    // stays loose so MO2's mod priority keeps deciding the winner
+    std::map<std::string, int> pathOwners;
+    std::set<std::string> pluginNames;
+    for (size_t i = 0; i < mods.size(); ++i) {
+      if (!present[i]) continue;
+      std::set<std::string> modPaths;
+      for (const auto &file : manifests[i].files) {
+        std::string lower = toLower(file.path);
+        modPaths.insert(lower);
+        if (isArchive(lower) && lower.find('/') == std::string::npos) {
+          for (const auto &inner :
+               BsaWriter::listFiles(fs::path(modsDir) / mods[i].folderName / file.path)) {
+            modPaths.insert(inner);
           }
         }
+        if (isPlugin(lower) && lower.find('/') == std::string::npos) {
+          pluginNames.insert(lower);
+        }
       }
-      std::cout << "  Unique plugins: " << pluginNames.size() << " (from " << plugins.size() << " total)" << std::endl;
-
-      // Find plugin files - track which plugins we've already found to avoid duplicates
-      std::vector<fs::path> pluginPaths;
-      std::set<std::string> foundPlugins; // Track by lowercase name
-
-      for (const auto &pluginName : pluginNames) {
-        std::string nameLower = pluginName;
-        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-
-        // Skip if we already found this plugin
-        if (foundPlugins.count(nameLower)) continue;
-
-        // Search for plugin in mods directory (first match wins - like MO2 priority)
-        bool found = false;
-        for (const auto &modDir : fs::directory_iterator(modsDir)) {
-          if (!modDir.is_directory()) continue;
-          fs::path pluginPath = modDir.path() / pluginName;
-          if (fs::exists(pluginPath)) {
-            pluginPaths.push_back(pluginPath);
-            foundPlugins.insert(nameLower);
-            found = true;
-            break;
+      for (const auto &path : modPaths) pathOwners[path]++;
+    }
+
+    std::mutex resultMutex;
+    std::atomic<size_t> packIndex{0};
+    auto packer = [&]() {
+      while (true) {
+        size_t i = packIndex.fetch_add(1);
+        if (i >= mods.size()) break;
+        if (!present[i]) continue;
+        if (!manifests[i].generatedFiles.empty()) {
+          // Packed by an earlier run - keep its dummy plugin enabled
+          std::lock_guard<std::mutex> lock(resultMutex);
+          for (const auto &name : manifests[i].generatedFiles) {
+            if (isPlugin(toLower(name))) result.dummyPlugins.push_back(name);
           }
+          continue;
+        }
+
+        try {
+          packMod(mods[i], fs::path(modsDir) / mods[i].folderName, manifests[i],
+                  manifestPathFor(manifestDir, mods[i].folderName), pathOwners,
+                  pluginNames, options, result, resultMutex);
+        } catch (const std::exception &e) {
+          std::lock_guard<std::mutex> lock(g_printMutex);
+          std::cerr << "  [WARN] BSA packing failed for " << mods[i].name << ": "
+                    << e.what() << std::endl;
+        }
+      }
+    };
+    runWorkers(packer, numThreads);
+
+    return result;
+  }
+
+  // Dummy plugins created by earlier runs (needed in plugins.txt even when
+  // packing isn't requested this time)
+  static std::vector<std::string> existingDummyPlugins(const std::vector<ModInfo> &mods,
+                                                       const std::string &manifestDir) {
+    std::vector<std::string> plugins;
+    if (!fs::is_directory(manifestDir)) return plugins;
+    for (const auto &mod : mods) {
+      if (mod.folderName.empty()) continue;
+      InstallManifest manifest;
+      if (!InstallManifest::load(manifestPathFor(manifestDir, mod.folderName), manifest)) continue;
+      for (const auto &name : manifest.generatedFiles) {
+        if (isPlugin(toLower(name))) plugins.push_back(name);
+      }
+    }
+    return plugins;
+  }
+
+private:
+  static std::string toLower(const std::string &s) { return CaseFold::fold(s); }
+
+  static bool hasExtension(const std::string &lower, std::initializer_list<const char *> exts) {
+    for (const char *ext : exts) {
+      size_t len = std::strlen(ext);
+      if (lower.size() > len && lower.compare(lower.size() - len, len, ext) == 0) return true;
+    }
+    return false;
+  }
+
+  static bool isPlugin(const std::string &lower) {
+    return hasExtension(lower, {".esp", ".esm", ".esl"});
+  }
+
+  static bool isArchive(const std::string &lower) {
+    return hasExtension(lower, {".bsa"});
+  }
+
+  // Asset types that load identically from an archive. Animation/behavior
+  // files, configs and scripts are left loose since tools (Nemesis, OAR,
+  // BodySlide) read them from disk.
+  static bool isPackable(const std::string &lower) {
+    if (lower.rfind("textures/", 0) == 0) return hasExtension(lower, {".dds"});
+    if (lower.rfind("meshes/", 0) == 0) {
+      return hasExtension(lower, {".nif", ".tri", ".btr", ".bto"});
+    }
+    if (lower.rfind("sound/", 0) == 0) return hasExtension(lower, {".wav", ".xwm", ".fuz", ".lip"});
+    return false;
+  }
+
+  // Fill an archive up to the size limit; whatever doesn't fit stays loose
+  static std::vector<BsaWriter::Entry> takeUpToLimit(std::vector<BsaWriter::Entry> &files) {
+    std::vector<BsaWriter::Entry> taken;
+    uint64_t total = 0;
+    // Leave headroom for records and names
+    const uint64_t limit = BsaWriter::kMaxArchiveBytes - 64ULL * 1024 * 1024;
+    for (const auto &entry : files) {
+      if (total + entry.size > limit) continue;
+      total += entry.size;
+      taken.push_back(entry);
+    }
+    files.clear();
+    return taken;
+  }
+
+  static void packMod(const ModInfo &mod, const fs::path &modDir, InstallManifest &manifest,
+                      const fs::path &manifestPath,
+                      const std::map<std::string, int> &pathOwners,
+                      const std::set<std::string> &pluginNames,
+                      const BsaPackOptions &options, BsaPackResult &result,
+                      std::mutex &resultMutex) {
+    std::vector<BsaWriter::Entry> textures;
+    std::vector<BsaWriter::Entry> other;
+    std::string existingPlugin;
+    std::set<std::string> rootFiles;
+
+    for (const auto &file : manifest.files) {
+      std::string lower = toLower(file.path);
+      if (lower.find('/') == std::string::npos) {
+        rootFiles.insert(lower);
+        if (isPlugin(lower) && (existingPlugin.empty() || file.path < existingPlugin)) {
+          existingPlugin = file.path;
+        }
+        continue;
+      }
+      if (!isPackable(lower)) continue;
+      auto owners = pathOwners.find(lower);
+      if (owners != pathOwners.end() && owners->second > 1) continue;
+      bool excluded = false;
+      for (const auto &glob : options.excludeGlobs) {
+        if (globMatch(glob, file.path)) {
+          excluded = true;
+          break;
+        }
+      }
+      if (excluded) continue;
+
+      BsaWriter::Entry entry{file.path, modDir / file.path, file.size};
+      (lower.rfind("textures/", 0) == 0 ? textures : other).push_back(entry);
+    }
+
+    if (textures.size() + other.size() < options.minFiles) return;
+
+    // Archives are named after a plugin so the game loads them. Reuse the
+    // mod's own plugin if its archive names are free, else add a dummy one.
+    auto archiveNamesFree = [&](const std::string &base) {
+      return !rootFiles.count(toLower(base + ".bsa")) &&
+             !rootFiles.count(toLower(base + " - textures.bsa"));
+    };
+    std::string base;
+    std::string dummyPlugin;
+    if (!existingPlugin.empty() &&
+        archiveNamesFree(fs::path(existingPlugin).stem().string())) {
+      base = fs::path(existingPlugin).stem().string();
+    } else {
+      base = manifest.folderName.empty() ? modDir.filename().string() : manifest.folderName;
+      dummyPlugin = base + ".esp";
+      if (pluginNames.count(toLower(dummyPlugin)) || !archiveNamesFree(base)) return;
+    }
+
+    BsaWriter::Compression compression =
+        options.compress ? BsaWriter::Compression::LZ4 : BsaWriter::Compression::None;
+
+    std::vector<std::pair<std::string, std::vector<BsaWriter::Entry>>> archives;
+    if (!other.empty()) archives.push_back({base + ".bsa", takeUpToLimit(other)});
+    if (!textures.empty()) archives.push_back({base + " - Textures.bsa", takeUpToLimit(textures)});
+
+    // Write every archive before touching loose files
+    std::vector<std::string> written;
+    for (const auto &[name, entries] : archives) {
+      if (entries.empty()) continue;
+      fs::path tmp = modDir / (name + ".tmp");
+      std::string error;
+      if (!BsaWriter::writeArchive(tmp, entries, compression, &error)) {
+        for (const auto &done : written) fs::remove(modDir / done);
+        throw std::runtime_error(name + ": " + error);
+      }
+      fs::rename(tmp, modDir / name);
+      written.push_back(name);
+    }
+    if (written.empty()) return;
+
+    if (!dummyPlugin.empty()) {
+      if (!BsaWriter::writeDummyPlugin(modDir / dummyPlugin)) {
+        for (const auto &done : written) fs::remove(modDir / done);
+        throw std::runtime_error("could not write " + dummyPlugin);
+      }
+      written.push_back(dummyPlugin);
+    }
+
+    // Remove the packed loose files and any folders left empty
+    std::set<std::string> packed;
+    uintmax_t packedBytes = 0;
+    std::set<fs::path> parents;
+    for (const auto &[name, entries] : archives) {
+      for (const auto &entry : entries) {
+        fs::remove(entry.sourcePath);
+        packed.insert(entry.archivePath);
+        packedBytes += entry.size;
+        for (fs::path dir = entry.sourcePath.parent_path(); dir != modDir && !dir.empty();
+             dir = dir.parent_path()) {
+          parents.insert(dir);
         }
-        if (!found) {
-          // Try game Data folder
-          fs::path gamePluginPath = fs::path(gamePath) / "Data" / pluginName;
-          if (fs::exists(gamePluginPath)) {
-            pluginPaths.push_back(gamePluginPath);
-            foundPlugins.insert(nameLower);
+      }
+    }
+    // Deepest first (longer paths sort after their parents)
+    for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
+      std::error_code ec;
+      if (fs::is_empty(*it, ec)) fs::remove(*it, ec);
+    }
+
+    // Update the manifest to describe what is on disk now
+    std::vector<ManifestFile> remaining;
+    for (const auto &file : manifest.files) {
+      if (!packed.count(file.path)) remaining.push_back(file);
+    }
+    for (const auto &name : written) {
+      remaining.push_back({name, fs::file_size(modDir / name)});
+    }
+    manifest.files = std::move(remaining);
+    manifest.packedFiles.assign(packed.begin(), packed.end());
+    manifest.generatedFiles = written;
+    manifest.save(manifestPath);
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    result.modsPacked++;
+    result.archivesWritten += static_cast<int>(written.size() - (dummyPlugin.empty() ? 0 : 1));
+    result.filesPacked += packed.size();
+    result.bytesPacked += packedBytes;
+    if (!dummyPlugin.empty()) result.dummyPlugins.push_back(dummyPlugin);
+    std::lock_guard<std::mutex> printLock(g_printMutex);
+    std::cout << "  Packed " << packed.size() << " files of " << mod.name << " into "
+              << base << (dummyPlugin.empty() ? "" : " (dummy plugin)") << std::endl;
+  }
+};
+
+// ============================================================================
+// Cross-Mod Deduplication (optional post-install stage)
+// ============================================================================
+
+enum class DedupMode {
+  Auto,      // Reflink where the filesystem supports it, else hardlink
+  Reflink,   // Copy-on-write clones only (btrfs, XFS, bcachefs)
+  Hardlink,  // Hardlinks only
+};
+
+struct DedupResult {
+  size_t filesLinked = 0;
+  uintmax_t bytesReclaimed = 0;
+  size_t filesHashed = 0;
+};
+
+class ModDeduplicator {
+public:
+  static bool parseMode(const std::string &name, DedupMode &out) {
+    if (name == "auto") out = DedupMode::Auto;
+    else if (name == "reflink") out = DedupMode::Reflink;
+    else if (name == "hardlink") out = DedupMode::Hardlink;
+    else return false;
+    return true;
+  }
+
+  // Replace byte-identical files in different mod folders with links to a
+  // single copy. Candidates come from the install manifests, are grouped
+  // by size, then by a hash of the first/last 64 KB, then by a full hash,
+  // and every pair is compared byte for byte before linking.
+  static DedupResult run(const std::vector<ModInfo> &mods, const std::string &modsDir,
+                         const std::string &manifestDir, DedupMode mode,
+                         unsigned int numThreads) {
+    DedupResult result;
+
+    std::vector<InstallManifest> manifests;
+    std::vector<char> present;
+    loadManifests(mods, modsDir, manifestDir, numThreads, manifests, present);
+
+    // Mods are visited in collection order so the kept copy is stable
+    // across runs
+    std::vector<Candidate> candidates;
+    std::map<uintmax_t, std::vector<size_t>> bySize;
+    for (size_t i = 0; i < mods.size(); ++i) {
+      if (!present[i]) continue;
+      fs::path modDir = fs::path(modsDir) / mods[i].folderName;
+      for (const auto &file : manifests[i].files) {
+        if (file.size < kMinFileSize) continue;
+        Candidate candidate;
+        candidate.path = modDir / file.path;
+        candidate.size = file.size;
+        candidate.modIndex = i;
+        candidate.editable = isEditable(file.path);
+        if (mode == DedupMode::Hardlink && candidate.editable) continue;
+
+        // Left over from an interrupted run
+        std::error_code ec;
+        fs::remove(tempPathFor(candidate.path), ec);
+
+        bySize[file.size].push_back(candidates.size());
+        candidates.push_back(std::move(candidate));
+      }
+    }
+
+    std::vector<std::vector<size_t>> groups;
+    for (auto &[size, members] : bySize) {
+      if (members.size() > 1) groups.push_back(std::move(members));
+    }
+    groups = collapseSharedFiles(groups, candidates);
+
+    // Cheap edge hash first; files small enough are fully hashed by it
+    groups = refine(groups, candidates, kEdgeBytes, numThreads, result);
+    std::vector<std::vector<size_t>> small, large;
+    for (auto &group : groups) {
+      (candidates[group[0]].size > kEdgeBytes * 2 ? large : small).push_back(std::move(group));
+    }
+    groups = refine(large, candidates, 0, numThreads, result);
+    groups.insert(groups.end(), std::make_move_iterator(small.begin()),
+                  std::make_move_iterator(small.end()));
+
+    std::mutex resultMutex;
+    std::atomic<size_t> groupIndex{0};
+    std::atomic<bool> reflinkSupported{mode != DedupMode::Hardlink};
+    auto linker = [&]() {
+      while (true) {
+        size_t g = groupIndex.fetch_add(1);
+        if (g >= groups.size()) break;
+        const auto &group = groups[g];
+        const Candidate &keep = candidates[group[0]];
+        for (size_t m = 1; m < group.size(); ++m) {
+          const Candidate &dup = candidates[group[m]];
+          if (dup.modIndex == keep.modIndex) continue;  // MO2 only sees one per mod anyway
+          if (!filesEqual(keep.path, dup.path)) continue;
+
+          bool linked = false;
+          if (reflinkSupported) {
+            bool unsupported = false;
+            linked = reflinkOver(keep.path, dup.path, unsupported);
+            if (unsupported && mode == DedupMode::Auto) reflinkSupported = false;
           }
+          // A hardlink shares writes too, so skip files tools edit in place
+          if (!linked && mode != DedupMode::Reflink && !dup.editable && !keep.editable) {
+            linked = hardlinkOver(keep.path, dup.path);
+          }
+          if (!linked) continue;
+
+          std::lock_guard<std::mutex> lock(resultMutex);
+          result.filesLinked++;
+          result.bytesReclaimed += dup.size;
         }
       }
+    };
+    runWorkers(linker, numThreads);
+
+    return result;
+  }
 
-      std::cout << "  Loading " << pluginPaths.size() << " plugins for LOOT sorting..." << std::endl;
+private:
+  // Below this, the link itself costs about as much as it saves
+  static constexpr uintmax_t kMinFileSize = 64 * 1024;
+  static constexpr size_t kEdgeBytes = 64 * 1024;
+
+  struct Candidate {
+    fs::path path;
+    uintmax_t size = 0;
+    size_t modIndex = 0;
+    bool editable = false;
+    uint64_t hash = 0;
+  };
 
-      // Load plugins (headers only for faster processing)
-      game->LoadPlugins(pluginPaths, true);
+  // Plugins and configs get rewritten in place by tools like xEdit and
+  // MCM; these are only ever reflinked (copy-on-write)
+  static bool isEditable(const std::string &path) {
+    static const std::unordered_set<std::string_view> editable = {
+        ".esp", ".esm", ".esl", ".ini", ".json", ".toml", ".yaml", ".yml", ".txt", ".xml"};
+    std::string ext = fs::path(path).extension().string();
+    return editable.count(CaseFold::Folded(ext).view()) > 0;
+  }
 
-      // Build list of plugins that actually exist (only sort what we loaded)
-      std::vector<std::string> existingPluginNames;
-      for (const auto &pluginName : pluginNames) {
-        std::string nameLower = pluginName;
-        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-        if (foundPlugins.count(nameLower)) {
-          existingPluginNames.push_back(pluginName);
-        }
-      }
+  static fs::path tempPathFor(const fs::path &path) {
+    fs::path tmp = path;
+    tmp += ".nbdedup";
+    return tmp;
+  }
 
-      // Sort only plugins that exist
-      sortedPlugins = game->SortPlugins(existingPluginNames);
+  // Files already hardlinked by an earlier run share an inode; keep one
+  // of them per group so a re-run doesn't hash them again
+  static std::vector<std::vector<size_t>> collapseSharedFiles(
+      const std::vector<std::vector<size_t>> &groups, const std::vector<Candidate> &candidates) {
+#ifdef _WIN32
+    (void)candidates;
+    return groups;
+#else
+    std::vector<std::vector<size_t>> out;
+    for (const auto &group : groups) {
+      std::set<std::pair<dev_t, ino_t>> seen;
+      std::vector<size_t> unique;
+      for (size_t idx : group) {
+        struct stat st;
+        if (::stat(candidates[idx].path.c_str(), &st) != 0) continue;
+        if (static_cast<uintmax_t>(st.st_size) != candidates[idx].size) continue;
+        if (seen.insert({st.st_dev, st.st_ino}).second) unique.push_back(idx);
+      }
+      if (unique.size() > 1) out.push_back(std::move(unique));
+    }
+    return out;
+#endif
+  }
 
-      std::cout << "  LOOT sorted " << sortedPlugins.size() << " plugins" << std::endl;
+  // Hash every member in parallel and split groups on the result
+  static std::vector<std::vector<size_t>> refine(const std::vector<std::vector<size_t>> &groups,
+                                                 std::vector<Candidate> &candidates,
+                                                 size_t edgeBytes, unsigned int numThreads,
+                                                 DedupResult &result) {
+    std::vector<size_t> work;
+    for (const auto &group : groups) work.insert(work.end(), group.begin(), group.end());
+    std::vector<char> ok(work.size(), 0);
+
+    std::atomic<size_t> hashIndex{0};
+    auto hasher = [&]() {
+      while (true) {
+        size_t w = hashIndex.fetch_add(1);
+        if (w >= work.size()) break;
+        Candidate &candidate = candidates[work[w]];
+        ok[w] = ContentHash::hashFile(candidate.path, candidate.hash, edgeBytes) ? 1 : 0;
+      }
+    };
+    runWorkers(hasher, numThreads);
+    result.filesHashed += work.size();
 
-    } catch (const std::exception &e) {
-      std::cerr << "  [WARN] LOOT sorting failed: " << e.what() << std::endl;
-      std::cerr << "  Falling back to collection order" << std::endl;
+    std::set<size_t> unreadable;
+    for (size_t w = 0; w < work.size(); ++w) {
+      if (!ok[w]) unreadable.insert(work[w]);
+    }
 
-      // Fallback: use original order
-      for (const auto &plugin : plugins) {
-        if (plugin.enabled) {
-          sortedPlugins.push_back(plugin.name);
-        }
+    std::vector<std::vector<size_t>> out;
+    for (const auto &group : groups) {
+      std::map<uint64_t, std::vector<size_t>> byHash;
+      for (size_t idx : group) {
+        if (!unreadable.count(idx)) byHash[candidates[idx].hash].push_back(idx);
+      }
+      for (auto &[hash, members] : byHash) {
+        if (members.size() > 1) out.push_back(std::move(members));
       }
     }
+    return out;
+  }
 
-    return sortedPlugins;
+  static bool filesEqual(const fs::path &a, const fs::path &b) {
+    std::ifstream inA(a, std::ios::binary);
+    std::ifstream inB(b, std::ios::binary);
+    if (!inA || !inB) return false;
+    std::vector<char> bufA(256 * 1024), bufB(256 * 1024);
+    while (true) {
+      inA.read(bufA.data(), static_cast<std::streamsize>(bufA.size()));
+      inB.read(bufB.data(), static_cast<std::streamsize>(bufB.size()));
+      std::streamsize gotA = inA.gcount();
+      if (gotA != inB.gcount()) return false;
+      if (gotA == 0) return !inA.bad() && !inB.bad();
+      if (std::memcmp(bufA.data(), bufB.data(), static_cast<size_t>(gotA)) != 0) return false;
+    }
   }
 
-  static void writePluginList(const std::string &path,
-                              const std::vector<std::string> &pluginOrder) {
-    std::ofstream out(path);
-    out << "# This file was automatically generated by NexusBridge"
-        << std::endl;
+  // The link is built under a temp name and renamed over the duplicate,
+  // so an interrupted run leaves either the original file or the link
+  static bool replaceWith(const fs::path &tmp, const fs::path &dup) {
+    std::error_code ec;
+    fs::rename(tmp, dup, ec);
+    if (ec) fs::remove(tmp, ec);
+    return !ec;
+  }
 
-    for (const auto &pluginName : pluginOrder) {
-      out << "*" << pluginName << std::endl;
+  // Sets unsupported when the filesystem can't clone at all
+  static bool reflinkOver(const fs::path &keep, const fs::path &dup, bool &unsupported) {
+#ifdef __linux__
+    fs::path tmp = tempPathFor(dup);
+    int src = ::open(keep.c_str(), O_RDONLY | O_CLOEXEC);
+    if (src < 0) return false;
+    int dst = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (dst < 0) {
+      ::close(src);
+      return false;
+    }
+    bool cloned = ::ioctl(dst, FICLONE, src) == 0;
+    if (!cloned && (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV ||
+                    errno == EINVAL)) {
+      unsupported = true;
     }
+    ::close(src);
+    ::close(dst);
+    std::error_code ec;
+    if (!cloned) {
+      fs::remove(tmp, ec);
+      return false;
+    }
+    fs::last_write_time(tmp, fs::last_write_time(dup, ec), ec);
+    return replaceWith(tmp, dup);
+#else
+    (void)keep;
+    (void)dup;
+    unsupported = true;
+    return false;
+#endif
+  }
 
-    out.close();
-    std::cout << "Generated plugins.txt with " << pluginOrder.size() << " plugins"
-              << std::endl;
+  static bool hardlinkOver(const fs::path &keep, const fs::path &dup) {
+    fs::path tmp = tempPathFor(dup);
+    std::error_code ec;
+    fs::create_hard_link(keep, tmp, ec);
+    if (ec) return false;
+    return replaceWith(tmp, dup);
   }
 };
 
@@ -2276,37 +5348,35 @@ CollectionUrlInfo parseCollectionUrl(const std::string &input) {
   return info;
 }
 
-// HTTP POST helper for GraphQL
+// HTTP POST helper for GraphQL (queries only, so retrying is safe)
 std::string httpPost(const std::string &url, const std::string &body,
                      const std::string &apiKey) {
-  CURL *curl = curl_easy_init();
-  if (!curl) return "";
-
-  std::string response;
   struct curl_slist *headers = NULL;
   headers = curl_slist_append(headers, "Content-Type: application/json");
   std::string authHeader = "apikey: " + apiKey;
   headers = curl_slist_append(headers, authHeader.c_str());
 
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-  curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
-
-  CURLcode res = curl_easy_perform(curl);
+  long httpCode = 0;
+  std::string response = performRequest(url, "POST", body, [&](CURL *curl) {
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+  }, &httpCode, 3, nullptr);
   curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
 
-  if (res != CURLE_OK) return "";
+  // Error responses are returned too: GraphQL explains them in the body
+  if (httpCode == 0) return "";
   return response;
 }
 
+// modFilesOut (optional) receives the revision's modFiles array so callers can
+// reuse Nexus file names/versions without querying the API again
 std::string fetchCollectionFromNexus(const std::string &game,
                                      const std::string &slug,
-                                     const std::string &apiKey) {
+                                     const std::string &apiKey,
+                                     json *modFilesOut = nullptr) {
   if (apiKey.empty()) {
     std::cerr << "Error: Nexus API key required" << std::endl;
     return "";
@@ -2359,6 +5429,11 @@ std::string fetchCollectionFromNexus(const std::string &game,
       collectionName = revision["collection"].value("name", slug);
     }
 
+    if (modFilesOut && revision.contains("modFiles") &&
+        revision["modFiles"].is_array()) {
+      *modFilesOut = revision["modFiles"];
+    }
+
     std::cout << "  Collection: " << collectionName << std::endl;
     std::cout << "  Revision: " << revision.value("revisionNumber", 0) << std::endl;
     std::cout << "  Download link: " << (downloadLink.empty() ? "(empty)" : downloadLink.substr(0, 100) + "...") << std::endl;
@@ -2449,18 +5524,16 @@ std::string fetchCollectionFromNexus(const std::string &game,
     std::cout << "  Archive: " << archivePath.string() << std::endl;
     std::cout << "  Extract to: " << extractDir.string() << std::endl;
 
-#ifdef _WIN32
-    // Windows: need to be careful with quoting for cmd.exe
-    std::string extractCmd = "\"\"" + sevenZip + "\" x -o\"" + extractDir.string() + "\" \"" + archivePath.string() + "\" collection.json -y\" > NUL 2>&1";
-#else
-    std::string extractCmd = sevenZip + " x -o" + extractDir.string() + " " + archivePath.string() + " collection.json -y > /dev/null 2>&1";
-#endif
-    std::cout << "  Command: " << extractCmd << std::endl;
-    int extractResult = std::system(extractCmd.c_str());
-    std::cout << "  Result: " << extractResult << std::endl;
+    std::vector<std::string> extractCmd = {sevenZip, "x", "-o" + extractDir.string(),
+                                           archivePath.string(), "collection.json", "-y"};
+    std::cout << "  Command: " << Subprocess::displayCommand(extractCmd) << std::endl;
+    Subprocess::Options extractOptions;
+    extractOptions.captureStderr = false;
+    Subprocess::Result extractResult = Subprocess::run(extractCmd, extractOptions);
+    std::cout << "  Result: " << (extractResult.ok() ? "ok" : extractResult.describe()) << std::endl;
 
-    if (extractResult != 0) {
-      std::cerr << "Failed to extract collection.json from archive (exit code: " << extractResult << ")" << std::endl;
+    if (!extractResult.ok()) {
+      std::cerr << "Failed to extract collection.json from archive (" << extractResult.describe() << ")" << std::endl;
       std::remove(archivePath.string().c_str());
       return "";
     }
@@ -2520,6 +5593,8 @@ void printUsage(const char *progName) {
   std::cout << "Usage:" << std::endl;
   std::cout << "  " << progName << " <collection_url> <mo2_path> [options]" << std::endl;
   std::cout << "  " << progName << " <collection.json> <mo2_path> [options]" << std::endl;
+  std::cout << "  " << progName << " --serve <mo2_path> [port]  Share downloads/ with --peer machines (default port: "
+            << kDefaultPeerPort << ")" << std::endl;
   std::cout << std::endl;
   std::cout << "Options:" << std::endl;
   std::cout << "  -y, --yes              Continue automatically on download failures" << std::endl;
@@ -2528,6 +5603,24 @@ void printUsage(const char *progName) {
   std::cout << "  --nxm <url>            Download single file using nxm:// URL (non-premium)" << std::endl;
   std::cout << "  --temp-dir <path>      Custom temp directory for extraction (default: C:\\n or ~/.cache/nexusbridge)" << std::endl;
   std::cout << "  --threads <n>          Max threads for parallel operations (default: auto)" << std::endl;
+  std::cout << "  --pack-bsa             Pack loose textures/meshes/sounds into BSAs after install (SSE)" << std::endl;
+  std::cout << "  --bsa-lz4              Use LZ4 compression for packed BSAs" << std::endl;
+  std::cout << "  --bsa-exclude <glob>   Keep matching files loose (repeatable, e.g. \"textures/effects/*\")" << std::endl;
+  std::cout << "  --dedup                Link identical files shared by several mods to save space" << std::endl;
+  std::cout << "  --dedup-mode <mode>    auto (default), reflink or hardlink" << std::endl;
+  std::cout << "  --no-io-uring          Copy files one at a time instead of batching with io_uring" << std::endl;
+  std::cout << "  --casefold-mods        Create the mods folder case-folding (Linux ext4/f2fs with casefold)" << std::endl;
+  std::cout << "  --stall-timeout <sec>  Retry an install that makes no progress this long (default: 300, 0 = off; 4x in background mode)" << std::endl;
+  std::cout << "  --watch                Install missing archives as they appear in downloads/ (works without Premium)" << std::endl;
+  std::cout << "  --watch-timeout <min>  Stop watching after this long without a new archive (default: 0 = never)" << std::endl;
+  std::cout << "  --trace-mod <glob>     Log extraction, FOMOD and placement details for matching mods to .nexusbridge/traces/ (repeatable, e.g. \"*Cougar*\")" << std::endl;
+  std::cout << "  --low-resource         Bound memory, temp space, open files and concurrent installs by what this machine has" << std::endl;
+  std::cout << "  --memory-budget <MB>   Memory the install may use (also --temp-budget <MB>, --max-open-files <n>, --heavy-tasks <n>)" << std::endl;
+  std::cout << "  --background           Use only spare CPU and disk time; switch with SIGUSR1 or by writing background/normal to .nexusbridge/qos" << std::endl;
+  std::cout << "  --peer <host[:port]>   Ask a machine running --serve for archives before Nexus (repeatable)" << std::endl;
+  std::cout << "  --record <dir>         Save API responses and downloaded archives to a cassette folder" << std::endl;
+  std::cout << "  --replay <dir>         Answer network requests from a recorded cassette (works offline)" << std::endl;
+  std::cout << "  --replay-speed <x>     Scale recorded request times when replaying (default: 1, 0 = instant)" << std::endl;
   std::cout << std::endl;
   std::cout << "Arguments:" << std::endl;
   std::cout << "  collection_url    Nexus collection URL" << std::endl;
@@ -2549,6 +5642,15 @@ void printUsage(const char *progName) {
 
 
 int main(int argc, char *argv[]) {
+  if (argc >= 3 && std::string(argv[1]) == "--serve") {
+    int port = argc >= 4 ? std::atoi(argv[3]) : kDefaultPeerPort;
+    if (port < 0 || port > 65535) {
+      std::cerr << "Invalid port: " << argv[3] << std::endl;
+      return 1;
+    }
+    return servePeerCache(argv[2], static_cast<uint16_t>(port));
+  }
+
   if (argc < 3) {
     printUsage(argv[0]);
     return 1;
@@ -2564,6 +5666,20 @@ int main(int argc, char *argv[]) {
   std::string nxmUrl;
   std::string customTempDir;
   int maxThreads = 0;  // 0 = auto
+  bool packBsa = false;
+  BsaPackOptions bsaOptions;
+  bool dedup = false;
+  DedupMode dedupMode = DedupMode::Auto;
+  std::chrono::seconds stallTimeout(300);
+  bool casefoldMods = false;
+  bool backgroundMode = false;
+  bool lowResource = false;
+  ResourceGovernor::Budgets budgetOverrides;
+  bool watchMode = false;
+  std::chrono::minutes watchTimeout(0);  // 0 = until every archive arrives
+  std::string cassetteDir;
+  Cassette::Mode cassetteMode = Cassette::Mode::Off;
+  double replaySpeed = 1.0;
   for (int i = 3; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "-y" || arg == "--yes") {
@@ -2578,6 +5694,55 @@ int main(int argc, char *argv[]) {
       customTempDir = argv[++i];
     } else if (arg == "--threads" && i + 1 < argc) {
       maxThreads = std::stoi(argv[++i]);
+    } else if (arg == "--pack-bsa") {
+      packBsa = true;
+    } else if (arg == "--bsa-lz4") {
+      bsaOptions.compress = true;
+    } else if (arg == "--bsa-exclude" && i + 1 < argc) {
+      bsaOptions.excludeGlobs.push_back(argv[++i]);
+    } else if (arg == "--background") {
+      backgroundMode = true;
+    } else if (arg == "--low-resource") {
+      lowResource = true;
+    } else if (arg == "--memory-budget" && i + 1 < argc) {
+      budgetOverrides.memoryBytes = std::stoull(argv[++i]) * 1024 * 1024;
+    } else if (arg == "--temp-budget" && i + 1 < argc) {
+      budgetOverrides.stagingBytes = std::stoull(argv[++i]) * 1024 * 1024;
+    } else if (arg == "--max-open-files" && i + 1 < argc) {
+      budgetOverrides.openFiles = static_cast<size_t>(std::stoul(argv[++i]));
+    } else if (arg == "--heavy-tasks" && i + 1 < argc) {
+      budgetOverrides.heavyTasks = static_cast<unsigned>(std::stoul(argv[++i]));
+    } else if (arg == "--no-io-uring") {
+      CopyEngine::setIoUringEnabled(false);
+    } else if (arg == "--casefold-mods") {
+      casefoldMods = true;
+    } else if (arg == "--watch") {
+      watchMode = true;
+    } else if (arg == "--watch-timeout" && i + 1 < argc) {
+      watchMode = true;
+      watchTimeout = std::chrono::minutes(std::max(0, std::stoi(argv[++i])));
+    } else if (arg == "--record" && i + 1 < argc) {
+      cassetteDir = argv[++i];
+      cassetteMode = Cassette::Mode::Record;
+    } else if (arg == "--replay" && i + 1 < argc) {
+      cassetteDir = argv[++i];
+      cassetteMode = Cassette::Mode::Replay;
+    } else if (arg == "--replay-speed" && i + 1 < argc) {
+      replaySpeed = std::atof(argv[++i]);
+    } else if (arg == "--trace-mod" && i + 1 < argc) {
+      ModTrace::addPattern(argv[++i]);
+    } else if (arg == "--peer" && i + 1 < argc) {
+      g_peers.add(argv[++i]);
+    } else if (arg == "--stall-timeout" && i + 1 < argc) {
+      stallTimeout = std::chrono::seconds(std::max(0, std::stoi(argv[++i])));
+    } else if (arg == "--dedup") {
+      dedup = true;
+    } else if (arg == "--dedup-mode" && i + 1 < argc) {
+      dedup = true;
+      if (!ModDeduplicator::parseMode(argv[++i], dedupMode)) {
+        std::cerr << "Unknown --dedup-mode '" << argv[i] << "', using auto" << std::endl;
+        dedupMode = DedupMode::Auto;
+      }
     }
   }
 
@@ -2585,6 +5750,21 @@ int main(int argc, char *argv[]) {
   std::string modsDir = mo2Path + "/mods";
   std::string downloadsDir = mo2Path + "/downloads";
   std::string profilesDir = mo2Path + "/profiles/" + profileName;
+  std::string manifestDir = mo2Path + "/.nexusbridge/manifests";
+  ModTrace::setDirectory(mo2Path + "/.nexusbridge/traces");
+
+  // Watched for every install run, so it can be sent to the background
+  // (or brought back) without restarting it; --query and --nxm only
+  // watch when asked to start in the background
+  if (backgroundMode || (!queryMode && nxmUrl.empty())) {
+    BackgroundQos::start(backgroundMode, fs::path(mo2Path) / ".nexusbridge" / "qos",
+                         [](bool background, const std::string &detail) {
+                           CopyEngine::setCacheFriendly(background);
+                           safePrint(std::string(background ? "  Background mode on: "
+                                                            : "  Background mode off: ") +
+                                     detail + "\n");
+                         });
+  }
 
   // Setup temp directory
   std::string tempDir;
@@ -2607,13 +5787,93 @@ int main(int argc, char *argv[]) {
 #endif
   }
 
+  if (casefoldMods) {
+    // The attribute can only be set on an empty folder, so this is for new
+    // instances; existing ones need their mods moved out and back in
+    std::error_code ec;
+    bool fresh = !fs::exists(modsDir, ec) || fs::is_empty(modsDir, ec);
+    fs::create_directories(modsDir);
+    std::string reason = "mods folder is not empty";
+    if (DirWalker::hasCaseFoldFlag(modsDir)) {
+      // Already set up
+    } else if (fresh && DirWalker::makeCaseFolded(modsDir, &reason)) {
+      std::cout << "Created case-folding mods folder: " << modsDir << std::endl;
+    } else {
+      std::cerr << "[WARN] Could not make the mods folder case-folding: " << reason << std::endl;
+    }
+  }
+
   fs::create_directories(modsDir);
   fs::create_directories(downloadsDir);
   fs::create_directories(profilesDir);
   fs::create_directories(tempDir);
+  // Resource budgets: the low-resource profile, with any explicit budget
+  // taking precedence (an explicit budget alone limits just that)
+  ResourceGovernor::Budgets budgets;
+  if (lowResource) budgets = ResourceGovernor::lowResourceProfile(tempDir);
+  if (budgetOverrides.memoryBytes) budgets.memoryBytes = budgetOverrides.memoryBytes;
+  if (budgetOverrides.stagingBytes) budgets.stagingBytes = budgetOverrides.stagingBytes;
+  if (budgetOverrides.openFiles) budgets.openFiles = budgetOverrides.openFiles;
+  if (budgetOverrides.heavyTasks) budgets.heavyTasks = budgetOverrides.heavyTasks;
+  uintmax_t trashBytes = 16ULL * 1024 * 1024 * 1024;
+  if (budgets.any()) {
+    std::cout << "Resource budgets: " << ResourceGovernor::describe(budgets) << std::endl;
+    // A fifth of the temp budget is for trees waiting to be deleted
+    if (budgets.stagingBytes) {
+      trashBytes = budgets.stagingBytes / 5;
+      budgets.stagingBytes -= trashBytes;
+    }
+    // Copy batches are sized so every install fits in its share of the
+    // descriptors, after downloads (socket and file) and a fixed reserve
+    if (budgets.openFiles) {
+      size_t installs = budgets.heavyTasks ? budgets.heavyTasks : 1;
+      size_t reserved = 32 + 4 * static_cast<size_t>(budgets.downloads ? budgets.downloads : 1);
+      size_t perInstall = budgets.openFiles > reserved ? (budgets.openFiles - reserved) / installs : 0;
+      size_t batchFiles = std::clamp<size_t>(perInstall > 16 ? (perInstall - 16) / 2 : 0, 4, 64);
+      CopyEngine::setMaxBatchFiles(batchFiles);
+      g_installOpenFiles = 2 * batchFiles + 16;
+    }
+    ResourceGovernor::configure(budgets);
+  }
+  g_reclaimer.start(fs::path(tempDir) / ".trash", 64, trashBytes);
+
+  // On case-folding folders the kernel does the case-insensitive matching,
+  // so folder merges and path resolution can use direct paths
+  bool modsCaseFolded = DirWalker::hasCaseFoldFlag(modsDir);
+  bool tempCaseFolded = DirWalker::hasCaseFoldFlag(tempDir);
+  if (modsCaseFolded || tempCaseFolded) {
+    DirWalker::enableCaseFoldChecks(true);
+    std::cout << "Case-folding "
+              << (modsCaseFolded && tempCaseFolded ? "mods and temp folders"
+                  : modsCaseFolded                 ? "mods folder"
+                                                   : "temp folder")
+              << " detected, using direct path lookups" << std::endl;
+  }
+
+  // Startup requests below run on several threads at once, and curl's
+  // implicit global init isn't thread-safe. Cleaned up on every return
+  // from main, after the threads declared below are done.
+  struct CurlGlobal {
+    CurlGlobal() { curl_global_init(CURL_GLOBAL_ALL); }
+    ~CurlGlobal() { curl_global_cleanup(); }
+  } curlGlobal;
+
+  // Record or replay network traffic (--record / --replay)
+  if (cassetteMode != Cassette::Mode::Off) {
+    std::string error;
+    if (!Cassette::open(cassetteDir, cassetteMode, replaySpeed, &error)) {
+      std::cerr << "Cassette unusable: " << error << std::endl;
+      return 1;
+    }
+    std::cout << (Cassette::replaying() ? "Replaying network traffic from " : "Recording network traffic to ")
+              << cassetteDir << std::endl;
+  }
 
   // Load API key
   std::string apiKey = loadApiKey("");
+  if (apiKey.empty() && Cassette::replaying()) {
+    apiKey = "replay";  // Never sent anywhere
+  }
   if (apiKey.empty()) {
     std::cerr << "Error: Nexus API key required" << std::endl;
     std::cerr << "Create a file 'nexus_apikey.txt' with your API key"
@@ -2683,7 +5943,7 @@ int main(int argc, char *argv[]) {
 
     std::cout << "Downloading to: " << destPath << std::endl;
 
-    bool success = downloadFile(links[0], destPath, filename, fileSize);
+    bool success = g_downloadFlights.download(links[0], destPath, filename, fileSize);
 
     if (success) {
       std::cout << std::endl << "NXM_DOWNLOAD_COMPLETE" << std::endl;
@@ -2695,16 +5955,43 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Nothing needs the key check or the downloads/ listing until the
+  // collection is parsed, so both run while it's fetched
+  std::future<NexusAPI::KeyInfo> keyCheck =
+      std::async(std::launch::async, NexusAPI::fetchKeyInfo, apiKey);
+
+  // Archives already in downloads/ (listed once, with sizes). MO2's .meta
+  // sidecars share the archive's name prefix, so they're left out, as are
+  // downloads still in progress.
+  std::future<std::vector<DownloadedArchive>> archiveIndex =
+      std::async(std::launch::async, [downloadsDir]() {
+        DirWalker::Options options;
+        options.recursive = false;
+        options.sizes = true;
+        DirWalker::Listing listing = DirWalker::walk(downloadsDir, options);
+        std::vector<DownloadedArchive> archives;
+        archives.reserve(listing.size());
+        for (const auto &entry : listing) {
+          if (isArchiveSidecar(entry.name)) continue;
+          std::string name(entry.name);
+          archives.push_back({listing.path(entry).string(), name, CaseFold::fold(name),
+                              static_cast<long long>(entry.size)});
+        }
+        return archives;
+      });
+
   // Load collection - either from URL or file
   std::string jsonContent;
   std::string gameDomain = "skyrimspecialedition"; // Default
+  json nexusModFiles; // GraphQL modFiles (file names/versions) when fetched by URL
 
   CollectionUrlInfo urlInfo = parseCollectionUrl(collectionInput);
   if (urlInfo.valid) {
     std::cout << "Detected Nexus collection URL" << std::endl;
     gameDomain = urlInfo.game;
 
-    std::string collectionPath = fetchCollectionFromNexus(urlInfo.game, urlInfo.slug, apiKey);
+    std::string collectionPath = fetchCollectionFromNexus(urlInfo.game, urlInfo.slug, apiKey,
+                                                          &nexusModFiles);
     if (collectionPath.empty()) {
       return 1;
     }
@@ -2740,20 +6027,37 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  // Only the parsed collection is used from here on: drop the raw JSON and
+  // keep just the file names and versions from the GraphQL file list
+  std::string().swap(jsonContent);
+  std::map<std::pair<int, int>, std::pair<std::string, std::string>> nexusFiles;
+  for (const auto &entry : nexusModFiles) {
+    if (!entry.contains("file") || !entry["file"].is_object()) continue;
+    const auto &file = entry["file"];
+    int modId = file.value("modId", -1);
+    int fileId = file.value("fileId", -1);
+    std::string name = file.contains("name") && file["name"].is_string()
+                           ? file["name"].get<std::string>() : "";
+    std::string version = file.contains("version") && file["version"].is_string()
+                              ? file["version"].get<std::string>() : "";
+    nexusFiles[{modId, fileId}] = {name, version};
+  }
+  nexusModFiles = json();
+
   gameDomain = collection.domainName;
 
   // Initialize Nexus API
   NexusAPI nexus(apiKey, gameDomain);
-  if (!nexus.validateKey()) {
+  if (!nexus.validateKey(keyCheck.get())) {
     return 1;
   }
 
   // For non-premium users, block direct downloads but allow query mode and nxm mode
-  if (!nexus.isPremium && !queryMode && nxmUrl.empty()) {
+  if (!nexus.isPremium && !queryMode && nxmUrl.empty() && !watchMode) {
     std::cerr << "ERROR: Nexus Premium is required for direct downloads."
               << std::endl;
-    std::cerr << "Without Premium, use --query to check collection, then --nxm for manual downloads."
-              << std::endl;
+    std::cerr << "Without Premium, use --query to check collection, then --nxm for manual downloads,"
+              << " or --watch to install archives as you download them." << std::endl;
     return 1;
   }
 
@@ -2767,6 +6071,9 @@ int main(int argc, char *argv[]) {
   if (maxThreads > 0) {
     numThreads = static_cast<unsigned int>(maxThreads);
     std::cout << "Using " << numThreads << " threads (user-specified)" << std::endl;
+  } else if (budgets.heavyTasks) {
+    numThreads = budgets.heavyTasks;
+    std::cout << "Using " << numThreads << " threads (resource budget)" << std::endl;
   } else {
     numThreads = std::thread::hardware_concurrency();
     if (numThreads == 0)
@@ -2824,12 +6131,31 @@ int main(int argc, char *argv[]) {
   // Collect install tasks
   std::vector<InstallTask> installTasks;
 
+  RunReport::start(collection.collectionName, numThreads);
+  for (size_t i = 0; i < collection.mods.size(); ++i) {
+    RunReport::describeMod(i, collection.mods[i].name, collection.mods[i].phase);
+  }
+
   std::cout << std::endl << "=== Phase 1: Scanning archives ===" << std::endl;
+  RunReport::beginPhase("scan");
 
   // Store archive paths for each mod index
   std::map<size_t, std::string> modArchivePaths;
   std::map<size_t, std::string> modFolderNames;
   std::vector<DownloadTask> downloadTasks;
+  // Archive identity -> index in downloadTasks, so an archive listed by
+  // several entries is only fetched once
+  std::map<std::string, size_t> queuedDownloads;
+  auto queueDownload = [&](DownloadTask dt, const std::string &identity) {
+    auto [it, added] = queuedDownloads.emplace(identity, downloadTasks.size());
+    if (added) {
+      downloadTasks.push_back(std::move(dt));
+    } else {
+      downloadTasks[it->second].sharedWith.push_back(dt.modIndex);
+    }
+  };
+
+  std::vector<DownloadedArchive> existingArchives = archiveIndex.get();
 
   // First pass: identify which mods need downloading
   for (size_t i = 0; i < collection.mods.size(); ++i) {
@@ -2883,73 +6209,19 @@ int main(int argc, char *argv[]) {
         dt.fileSize = mod.fileSize;
         dt.modId = mod.modId;
         dt.fileId = mod.fileId;
+        dt.md5 = mod.md5;
         dt.isDirectDownload = true;
         dt.modIndex = i;
-        downloadTasks.push_back(dt);
+        queueDownload(dt, "url:" + mod.directUrl);
       } else {
         modArchivePaths[i] = archivePath;
       }
     } else {
       // Nexus - try to find existing archive
-      std::string modIdPattern = "-" + std::to_string(mod.modId) + "-";
-      std::string logicalLower = mod.logicalFilename;
-      std::transform(logicalLower.begin(), logicalLower.end(), logicalLower.begin(),
-                     [](unsigned char c) { return std::tolower(c); });
-
-      bool found = false;
-      std::string bestMatch;
-      std::string fallbackMatch;
-      long long expectedSize = mod.fileSize;
-
-      for (const auto &entry : fs::directory_iterator(downloadsDir)) {
-        std::string fname = entry.path().filename().string();
-        std::string fnameLower = fname;
-        std::transform(fnameLower.begin(), fnameLower.end(), fnameLower.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-
-        if (!logicalLower.empty()) {
-          std::string expectedStart = logicalLower + modIdPattern;
-          std::transform(expectedStart.begin(), expectedStart.end(), expectedStart.begin(),
-                         [](unsigned char c) { return std::tolower(c); });
-
-          if (fnameLower.find(expectedStart) == 0) {
-            archivePath = entry.path().string();
-            modArchivePaths[i] = archivePath;
-            found = true;
-            break;
-          }
-
-          std::string ccPrefix = "creation club - ";
-          size_t ccPos = logicalLower.find(ccPrefix);
-          if (ccPos != std::string::npos) {
-            std::string simplifiedLogical = logicalLower.substr(0, ccPos) + logicalLower.substr(ccPos + ccPrefix.length());
-            std::string simplifiedStart = simplifiedLogical + modIdPattern;
-            if (fnameLower.find(simplifiedStart) == 0) {
-              archivePath = entry.path().string();
-              modArchivePaths[i] = archivePath;
-              found = true;
-              break;
-            }
-          }
-        }
-
-        if (!found && fname.find(modIdPattern) != std::string::npos) {
-          long long actualSize = static_cast<long long>(fs::file_size(entry.path()));
-          if (expectedSize > 0 && actualSize == expectedSize) {
-            archivePath = entry.path().string();
-            modArchivePaths[i] = archivePath;
-            found = true;
-            break;
-          } else if (fallbackMatch.empty()) {
-            fallbackMatch = entry.path().string();
-          }
-        }
-      }
-
-      if (!found && !fallbackMatch.empty()) {
-        archivePath = fallbackMatch;
+      archivePath = findDownloadedArchive(mod, existingArchives, true);
+      bool found = !archivePath.empty();
+      if (found) {
         modArchivePaths[i] = archivePath;
-        found = true;
       }
 
       if (!found) {
@@ -2958,15 +6230,17 @@ int main(int argc, char *argv[]) {
         dt.fileSize = mod.fileSize;
         dt.modId = mod.modId;
         dt.fileId = mod.fileId;
+        dt.md5 = mod.md5;
         dt.isDirectDownload = false;
         dt.modIndex = i;
-        downloadTasks.push_back(dt);
+        queueDownload(dt, "nexus:" + std::to_string(mod.modId) + ":" + std::to_string(mod.fileId));
       }
     }
   }
 
   std::cout << "  Found " << modArchivePaths.size() << " existing archives" << std::endl;
   std::cout << "  Need to download " << downloadTasks.size() << " archives" << std::endl;
+  RunReport::endPhase("scan");
 
   // Calculate total download size
   long long totalDownloadBytes = 0;
@@ -3028,128 +6302,188 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
-  // Phase 1b: Download missing archives in parallel
-  if (!downloadTasks.empty()) {
+  // Fetch earlier collection phases first so they're ready to install first
+  std::stable_sort(downloadTasks.begin(), downloadTasks.end(),
+                   [&](const DownloadTask &a, const DownloadTask &b) {
+                     return collection.mods[a.modIndex].phase < collection.mods[b.modIndex].phase;
+                   });
+
+  // Phase 1b: Download missing archives in parallel (without Premium,
+  // watch mode waits for them to be downloaded by hand instead, after
+  // asking any peers)
+  if (!downloadTasks.empty() && (nexus.isPremium || !watchMode || !g_peers.empty())) {
+    unsigned int downloadThreadCount =
+        budgets.downloads ? std::min(numThreads, budgets.downloads) : numThreads;
     std::cout << std::endl << "=== Phase 1b: Downloading " << downloadTasks.size()
-              << " archives with " << numThreads << " threads ===" << std::endl;
+              << " archives with " << downloadThreadCount << " threads ===" << std::endl;
+    RunReport::beginPhase("download");
 
-    std::atomic<size_t> downloadIndex{0};
     std::atomic<int> downloadedCount{0};
     std::mutex downloadMutex;
-    std::vector<size_t> failedIndices;  // Track failed download indices
-
-    // Download worker function - processes tasks from downloadTasks
-    auto downloadWorker = [&](const std::vector<DownloadTask>& tasks,
-                              std::atomic<size_t>& taskIdx,
-                              std::vector<size_t>& failed,
-                              bool isRetry) {
+    std::condition_variable downloadReady;
+    // Collection entries left without an archive: the one a failed
+    // download was queued for plus every entry sharing that archive
+    std::vector<size_t> failedMods;
+
+    // Failed downloads are retried one by one after their own jittered
+    // backoff, not in rounds, so a burst of failures doesn't come back as a
+    // burst of retries. Permanent failures (404, premium required) aren't
+    // retried at all.
+    const int maxRetries = 3;
+    size_t nextTask = 0;
+    int inFlight = 0;
+    std::multimap<std::chrono::steady_clock::time_point, size_t> deferred;
+    std::vector<int> attempts(downloadTasks.size(), 0);
+    std::vector<RetryPolicy::Backoff> backoffs(
+        downloadTasks.size(),
+        RetryPolicy::Backoff(std::chrono::seconds(2), std::chrono::seconds(60)));
+
+    // Next task to try: new ones first, then retries that are due. Waits
+    // while a retry is pending or a running download may still need one.
+    auto takeTask = [&](size_t &idx) {
+      std::unique_lock<std::mutex> lock(downloadMutex);
       while (true) {
-        size_t idx = taskIdx.fetch_add(1);
-        if (idx >= tasks.size()) break;
+        if (nextTask < downloadTasks.size()) {
+          idx = nextTask++;
+          break;
+        }
+        if (!deferred.empty() && deferred.begin()->first <= std::chrono::steady_clock::now()) {
+          idx = deferred.begin()->second;
+          deferred.erase(deferred.begin());
+          break;
+        }
+        if (deferred.empty() && inFlight == 0) return false;
+        if (deferred.empty()) {
+          downloadReady.wait(lock);
+        } else {
+          downloadReady.wait_until(lock, deferred.begin()->first);
+        }
+      }
+      inFlight++;
+      return true;
+    };
 
-        const auto& dt = tasks[idx];
+    auto downloadWorker = [&]() {
+      size_t idx = 0;
+      while (takeTask(idx)) {
+        const auto& dt = downloadTasks[idx];
+        int attempt = ++attempts[idx];  // Only the worker holding idx touches it
         std::string archivePath;
 
         {
           std::lock_guard<std::mutex> lock(downloadMutex);
-          if (isRetry) {
+          if (attempt > 1) {
             std::cout << "  [Retry] Downloading: " << dt.modName << std::endl;
           } else {
-            std::cout << "  [" << (idx + 1) << "/" << tasks.size()
+            std::cout << "  [" << (idx + 1) << "/" << downloadTasks.size()
                       << "] Downloading: " << dt.modName << std::endl;
           }
         }
 
-        bool success = false;
+        std::string filename = dt.filename;
         if (dt.isDirectDownload) {
           archivePath = dt.destPath;
-          success = downloadFile(dt.url, archivePath, dt.filename, dt.fileSize);
         } else {
-          auto links = nexus.getDownloadLinks(dt.modId, dt.fileId);
+          filename = dt.modName + "-" + std::to_string(dt.modId) +
+                     "-" + std::to_string(dt.fileId) + ".7z";
+          for (char& c : filename) {
+            if (c == '/' || c == '\\' || c == ':' || c == '*' ||
+                c == '?' || c == '"' || c == '<' || c == '>' || c == '|') {
+              c = '_';
+            }
+          }
+          archivePath = downloadsDir + "/" + filename;
+        }
+
+        bool success = false;
+        bool fromPeer = false;
+        RetryPolicy::ErrorClass failure = RetryPolicy::ErrorClass::Transient;
+        auto started = RunReport::Clock::now();
+        if (attempt == 1 && !dt.md5.empty() && !g_peers.empty()) {
+          // A peer that doesn't have it (or sends something else) just
+          // means going to Nexus, so its failures aren't retried
+          success = g_downloadFlights.fetch(archivePath, dt.fileSize,
+              [&](const std::string &partPath, RetryPolicy::ErrorClass &cls) {
+                cls = RetryPolicy::ErrorClass::Permanent;
+                return g_peers.fetch(dt.md5, partPath, filename, dt.fileSize);
+              });
+        }
+        if (success) {
+          fromPeer = true;
+          failure = RetryPolicy::ErrorClass::None;
+        } else if (dt.isDirectDownload) {
+          success = g_downloadFlights.download(dt.url, archivePath, filename, dt.fileSize, &failure);
+        } else if (!nexus.isPremium) {
+          failure = RetryPolicy::ErrorClass::Permanent;  // No peer had it
+        } else {
+          auto links = nexus.getDownloadLinks(dt.modId, dt.fileId, &failure);
           if (!links.empty()) {
             std::string downloadUrl = links[0];  // Already a string URL
-            std::string filename = dt.modName + "-" + std::to_string(dt.modId) +
-                                   "-" + std::to_string(dt.fileId) + ".7z";
-            for (char& c : filename) {
-              if (c == '/' || c == '\\' || c == ':' || c == '*' ||
-                  c == '?' || c == '"' || c == '<' || c == '>' || c == '|') {
-                c = '_';
-              }
-            }
-            archivePath = downloadsDir + "/" + filename;
-            success = downloadFile(downloadUrl, archivePath, filename, dt.fileSize);
+            success = g_downloadFlights.download(downloadUrl, archivePath, filename, dt.fileSize, &failure);
           }
         }
 
+        std::error_code sizeEc;
+        uintmax_t bytes = success ? fs::file_size(archivePath, sizeEc) : 0;
+        RunReport::downloadAttempt(dt.modIndex,
+                                   fromPeer ? "peer" : dt.isDirectDownload ? "direct" : "nexus",
+                                   started, RunReport::Clock::now(), sizeEc ? 0 : bytes,
+                                   success ? "" : std::string(RetryPolicy::describe(failure)) + " error");
+
+        std::lock_guard<std::mutex> lock(downloadMutex);
+        inFlight--;
         if (success && !archivePath.empty()) {
-          std::lock_guard<std::mutex> lock(downloadMutex);
           modArchivePaths[dt.modIndex] = archivePath;
+          for (size_t other : dt.sharedWith) modArchivePaths[other] = archivePath;
           downloadedCount++;
           downloaded++;
+        } else if (RetryPolicy::retryable(failure) && attempt <= maxRetries) {
+          auto delay = backoffs[idx].next(RetryPolicy::lastRetryAfter());
+          deferred.emplace(std::chrono::steady_clock::now() + delay, idx);
+          std::cout << "  Will retry " << dt.modName << " in " << std::fixed
+                    << std::setprecision(1) << delay.count() / 1000.0 << "s ("
+                    << RetryPolicy::describe(failure) << " error, attempt " << attempt
+                    << "/" << (maxRetries + 1) << ")" << std::endl;
         } else {
-          std::lock_guard<std::mutex> lock(downloadMutex);
-          failed.push_back(idx);
-          std::cout << "  FAILED: No download links for " << dt.modName << std::endl;
+          failedMods.push_back(dt.modIndex);
+          failedMods.insert(failedMods.end(), dt.sharedWith.begin(), dt.sharedWith.end());
+          std::cout << "  FAILED: Could not download " << dt.modName << " ("
+                    << RetryPolicy::describe(failure) << " error"
+                    << (attempt > 1 ? ", " + std::to_string(attempt) + " attempts" : "")
+                    << ")" << std::endl;
+          for (size_t other : dt.sharedWith) {
+            std::cout << "  FAILED: Could not download " << collection.mods[other].name
+                      << " (same archive as " << dt.modName << ")" << std::endl;
+          }
         }
+        downloadReady.notify_all();
       }
     };
 
-    // Initial download pass
     std::vector<std::thread> downloadThreads;
-    for (unsigned int t = 0; t < numThreads; ++t) {
-      downloadThreads.emplace_back([&]() {
-        downloadWorker(downloadTasks, downloadIndex, failedIndices, false);
-      });
+    for (unsigned int t = 0; t < downloadThreadCount; ++t) {
+      downloadThreads.emplace_back(downloadWorker);
     }
     for (auto& t : downloadThreads) {
       t.join();
     }
 
-    // Retry failed downloads up to 3 times
-    const int maxRetries = 3;
-    for (int retry = 1; retry <= maxRetries && !failedIndices.empty(); ++retry) {
-      std::cout << std::endl << "  === Retry " << retry << "/" << maxRetries
-                << " for " << failedIndices.size() << " failed downloads ===" << std::endl;
-
-      // Small delay before retry to let server recover
-      std::this_thread::sleep_for(std::chrono::seconds(2));
-
-      // Build retry task list
-      std::vector<DownloadTask> retryTasks;
-      for (size_t idx : failedIndices) {
-        retryTasks.push_back(downloadTasks[idx]);
-      }
-
-      failedIndices.clear();
-      std::atomic<size_t> retryIndex{0};
-
-      // Retry with fewer threads to be gentler on the API
-      unsigned int retryThreads = std::min(numThreads, 4u);
-      std::vector<std::thread> retryThreadPool;
-      for (unsigned int t = 0; t < retryThreads; ++t) {
-        retryThreadPool.emplace_back([&]() {
-          downloadWorker(retryTasks, retryIndex, failedIndices, true);
-        });
-      }
-      for (auto& t : retryThreadPool) {
-        t.join();
-      }
-    }
-
-    int failedDownloads = static_cast<int>(failedIndices.size());
+    RunReport::endPhase("download");
+    int failedDownloads = static_cast<int>(failedMods.size());
     std::cout << "  Downloaded: " << downloadedCount << ", Failed: " << failedDownloads << std::endl;
 
     // If there are still failures after retries, ask user if they want to continue
     if (failedDownloads > 0) {
       std::cout << std::endl;
-      std::cout << "WARNING: " << failedDownloads << " mod(s) failed to download after "
-                << maxRetries << " retries:" << std::endl;
-      for (size_t idx : failedIndices) {
-        std::cout << "  - " << downloadTasks[idx].modName << std::endl;
+      std::cout << "WARNING: " << failedDownloads << " mod(s) failed to download:" << std::endl;
+      for (size_t mod : failedMods) {
+        std::cout << "  - " << collection.mods[mod].name << std::endl;
       }
       std::cout << std::endl;
 
-      if (autoYes) {
+      if (watchMode) {
+        std::cout << "They'll be installed if they appear in downloads/ while watching." << std::endl;
+      } else if (autoYes) {
         std::cout << "Auto-continuing due to --yes flag..." << std::endl;
       } else {
         std::cout << "Continue anyway? This may cause issues with your mod setup. [y/N]: ";
@@ -3167,53 +6501,7 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  // Phase 2: Install mods in parallel
-  for (const auto& [idx, archivePath] : modArchivePaths) {
-    InstallTask task;
-    task.archivePath = archivePath;
-    task.destModPath = modsDir + "/" + modFolderNames[idx];
-    // Use short numeric folder to avoid Windows MAX_PATH limit
-    task.tempDir = tempDir + "/m" + std::to_string(idx);
-    task.folderName = "m" + std::to_string(idx);
-    task.modName = collection.mods[idx].name;
-    task.choices = collection.mods[idx].choices;
-    task.index = idx;
-    task.total = collection.mods.size();
-    task.expectedPaths = collection.mods[idx].expectedPaths;
-    installTasks.push_back(task);
-  }
-
-  if (!installTasks.empty()) {
-    std::cout << std::endl << "=== Phase 2: Installing " << installTasks.size()
-              << " mods with " << numThreads << " threads ===" << std::endl;
-
-    std::atomic<size_t> taskIndex{0};
-
-    auto installWorker = [&]() {
-      while (true) {
-        size_t idx = taskIndex.fetch_add(1);
-        if (idx >= installTasks.size()) break;
-
-        const auto& task = installTasks[idx];
-        installMod(task);
-      }
-    };
-
-    std::vector<std::thread> installThreads;
-    for (unsigned int t = 0; t < numThreads; ++t) {
-      installThreads.emplace_back(installWorker);
-    }
-    for (auto& t : installThreads) {
-      t.join();
-    }
-  }
-
-  int installed = g_installed.load();
-  int failed = g_failed.load();
-
-  // Generate plugins.txt with LOOT sorting
-  std::cout << std::endl << "Generating plugins.txt..." << std::endl;
-
+  // Game folder for LOOT
   std::string gamePath = mo2Path + "/Stock Game";
   if (!fs::exists(gamePath)) {
     std::ifstream iniFile(mo2Path + "/ModOrganizer.ini");
@@ -3249,10 +6537,315 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  std::vector<std::string> pluginOrder;
+  // Plugin headers are loaded into LOOT as their mods finish installing
+  std::unique_ptr<PluginPreloader> pluginPreloader;
   if (!gamePath.empty() && fs::exists(gamePath)) {
+    pluginPreloader = std::make_unique<PluginPreloader>(gamePath, modsDir, collection.plugins);
+    g_pluginPreloader = pluginPreloader.get();
+  }
+
+  // Phase 2: Install mods in parallel
+  const GameLayout::Layout &gameLayout = GameLayout::forDomain(gameDomain);
+  auto makeInstallTask = [&](size_t idx, const std::string &archivePath) {
+    InstallTask task;
+    task.archivePath = archivePath;
+    task.destModPath = modsDir + "/" + modFolderNames[idx];
+    // Use short numeric folder to avoid Windows MAX_PATH limit
+    task.tempDir = tempDir + "/m" + std::to_string(idx);
+    task.folderName = "m" + std::to_string(idx);
+    task.modName = collection.mods[idx].name;
+    task.choices = collection.mods[idx].choices;
+    task.index = idx;
+    task.total = collection.mods.size();
+    task.expectedPaths = collection.mods[idx].expectedPaths;
+    task.expectedFiles = collection.mods[idx].expectedFiles;
+    task.manifestPath = manifestPathFor(manifestDir, modFolderNames[idx]).string();
+    task.phase = collection.mods[idx].phase;
+    task.waitsForEarlierPhases = task.choices.contains("options");
+    task.layout = &gameLayout;
+    task.trace = ModTrace::forMod(task.modName, modFolderNames[idx]);
+    return task;
+  };
+  for (const auto& [idx, archivePath] : modArchivePaths) {
+    installTasks.push_back(makeInstallTask(idx, archivePath));
+  }
+
+  // Collection phases install in sequence (as in Vortex)
+  std::stable_sort(installTasks.begin(), installTasks.end(),
+                   [](const InstallTask &a, const InstallTask &b) { return a.phase < b.phase; });
+
+  // Watch mode: archives still missing are installed as they show up. An
+  // entry stays awaited until its install succeeds: if the file that
+  // arrived doesn't install, a replacement is watched for.
+  std::list<const DownloadTask *> awaited;
+  std::map<const DownloadTask *, std::vector<size_t>> failedEntries;  // Awaited again
+  size_t awaitedEntries = 0;
+  if (watchMode) {
+    for (const auto &dt : downloadTasks) {
+      if (modArchivePaths.count(dt.modIndex)) continue;
+      awaited.push_back(&dt);
+      awaitedEntries += 1 + dt.sharedWith.size();
+    }
+  }
+  // Tasks added while the pool runs must not move the ones it's using
+  installTasks.reserve(collection.mods.size());
+
+  // The early LOOT sort waits for every install that may bring a plugin
+  if (pluginPreloader) {
+    for (const auto &task : installTasks) pluginPreloader->expect(task.index, task.expectedPaths);
+    for (const DownloadTask *dt : awaited) {
+      pluginPreloader->expect(dt->modIndex, collection.mods[dt->modIndex].expectedPaths);
+      for (size_t other : dt->sharedWith) {
+        pluginPreloader->expect(other, collection.mods[other].expectedPaths);
+      }
+    }
+  }
+
+  if (!installTasks.empty() || !awaited.empty()) {
+    std::cout << std::endl << "=== Phase 2: Installing " << installTasks.size() + awaitedEntries
+              << " mods with " << numThreads << " threads ===" << std::endl;
+    std::cout << "  Copy backend: " << CopyEngine::backendName() << std::endl;
+
+    std::set<int> phases;
+    for (const auto &task : installTasks) phases.insert(task.phase);
+    if (phases.size() > 1) {
+      std::cout << "  Collection has " << phases.size() << " install phases" << std::endl;
+    }
+
+    for (const auto &task : installTasks) g_staging.addConsumer(task);
+    size_t sharedArchives = g_staging.sharedCount();
+    if (sharedArchives > 0) {
+      std::cout << "  " << sharedArchives
+                << " archive(s) are used by several entries and will be extracted once" << std::endl;
+    }
+
+    RunReport::beginPhase("install");
+    PhaseScheduler scheduler(installTasks);
+    std::thread watchThread;
+    if (!awaited.empty()) {
+      scheduler.holdOpen();
+      watchThread = std::thread([&] {
+        DownloadWatcher watcher(downloadsDir);
+        std::ostringstream intro;
+        intro << "  Watching " << downloadsDir << " for " << awaited.size() << " archive(s) ("
+              << (watcher.usingInotify() ? "inotify" : "polling") << "):\n";
+        for (const DownloadTask *dt : awaited) {
+          intro << "    " << dt->modName;
+          if (!dt->isDirectDownload) {
+            intro << " - " << getNexusFileUrl(gameDomain, dt->modId, dt->fileId);
+          }
+          intro << "\n";
+        }
+        safePrint(intro.str());
+
+        // Anything that finished between the Phase 1 scan and the watch
+        // starting is picked up by listing the folder once
+        std::vector<std::string> arrived;
+        {
+          DirWalker::Options options;
+          options.recursive = false;
+          DirWalker::Listing listing = DirWalker::walk(downloadsDir, options);
+          for (const auto &entry : listing) arrived.emplace_back(entry.name);
+        }
+
+        // Archives being installed, until all their tasks have finished
+        struct Arrival {
+          std::string name;
+          size_t unfinished = 0;
+          bool replacement = false;    // Its entries failed once already
+          std::vector<size_t> failed;  // Entries whose install failed
+        };
+        std::map<const DownloadTask *, Arrival> installing;
+        std::map<size_t, std::pair<const DownloadTask *, size_t>> taskEntries;  // Task -> entry
+
+        std::set<std::string> used;  // inotify may report a file twice
+        auto lastArrival = std::chrono::steady_clock::now();
+        while (true) {
+          for (const auto &[taskIndex, ok] : scheduler.takeOutcomes()) {
+            auto owner = taskEntries.find(taskIndex);
+            if (owner == taskEntries.end()) continue;
+            const auto [dt, entry] = owner->second;
+            taskEntries.erase(owner);
+            Arrival &arrival = installing[dt];
+            if (!ok) {
+              arrival.failed.push_back(entry);
+            } else if (arrival.replacement) {
+              g_failed--;  // Its earlier failure is made good
+            }
+            if (--arrival.unfinished > 0) continue;
+
+            if (!arrival.failed.empty()) {
+              safePrint("  Watching for " + dt->modName + " again: " + arrival.name +
+                        " didn't install\n");
+              failedEntries[dt] = std::move(arrival.failed);
+              used.erase(arrival.name);
+              awaited.push_back(dt);
+              lastArrival = std::chrono::steady_clock::now();
+            }
+            installing.erase(dt);
+          }
+
+          for (const std::string &name : arrived) {
+            if (isArchiveSidecar(name) || used.count(name)) continue;
+            std::string path = downloadsDir + "/" + name;
+            std::error_code ec;
+            auto size = fs::file_size(path, ec);
+            if (ec) continue;
+            std::vector<DownloadedArchive> candidate = {
+                {path, name, CaseFold::fold(name), static_cast<long long>(size)}};
+
+            for (auto it = awaited.begin(); it != awaited.end(); ++it) {
+              const DownloadTask &dt = **it;
+              bool matches = dt.isDirectDownload
+                                 ? CaseFold::equals(name, dt.filename)
+                                 : !findDownloadedArchive(collection.mods[dt.modIndex],
+                                                          candidate, false).empty();
+              if (!matches) continue;
+
+              // A replacement only reinstalls the entries that failed
+              Arrival &arrival = installing[&dt];
+              arrival.name = name;
+              std::vector<size_t> entries;
+              auto failed = failedEntries.find(&dt);
+              if (failed != failedEntries.end()) {
+                arrival.replacement = true;
+                entries = std::move(failed->second);
+                failedEntries.erase(failed);
+              } else {
+                entries = {dt.modIndex};
+                entries.insert(entries.end(), dt.sharedWith.begin(), dt.sharedWith.end());
+              }
+              std::vector<InstallTask> tasks;
+              for (size_t idx : entries) {
+                modArchivePaths[idx] = path;
+                tasks.push_back(makeInstallTask(idx, path));
+              }
+              // Every consumer is registered before any of them starts
+              for (const auto &task : tasks) g_staging.addConsumer(task);
+              safePrint("  Arrived: " + name + " (" + dt.modName + ")\n");
+              for (size_t i = 0; i < tasks.size(); ++i) {
+                taskEntries[scheduler.add(std::move(tasks[i]))] = {&dt, entries[i]};
+                arrival.unfinished++;
+              }
+
+              used.insert(name);
+              awaited.erase(it);
+              lastArrival = std::chrono::steady_clock::now();
+              break;
+            }
+          }
+          if (awaited.empty() && installing.empty()) break;
+          if (!awaited.empty() && watchTimeout.count() > 0 &&
+              std::chrono::steady_clock::now() - lastArrival >= watchTimeout) {
+            safePrint("  Stopped watching: no new archive for " +
+                      std::to_string(watchTimeout.count()) + " minute(s)\n");
+            break;
+          }
+          arrived = watcher.wait(std::chrono::seconds(1));
+        }
+        scheduler.close();
+      });
+    }
+
+    InstallPool pool(installTasks, scheduler, stallTimeout);
+    pool.run(numThreads);
+    if (watchThread.joinable()) watchThread.join();
+    g_staging.releaseAll();
+    RunReport::endPhase("install");
+
+    if (ModTrace::enabled()) {
+      std::cout << "  Traces of --trace-mod mods are in " << ModTrace::outputDirectory().string()
+                << std::endl;
+    }
+    // Entries whose archive arrived but didn't install were reported failed
+    awaited.remove_if([&](const DownloadTask *dt) { return failedEntries.count(dt) > 0; });
+    if (!awaited.empty()) {
+      std::cout << "  " << awaited.size() << " archive(s) never arrived:" << std::endl;
+      for (const DownloadTask *dt : awaited) {
+        std::cout << "    " << dt->modName << std::endl;
+      }
+    }
+  }
+  g_pluginPreloader = nullptr;
+
+  int installed = g_installed.load();
+  int failed = g_failed.load();
+
+  // Write MO2 metadata so a fresh instance doesn't hash/query every download
+  RunReport::beginPhase("metadata");
+  {
+    std::vector<Mo2MetaJob> metaJobs;
+    for (size_t i = 0; i < collection.mods.size(); ++i) {
+      const auto &mod = collection.mods[i];
+      if (mod.modId <= 0 || mod.fileId <= 0 || mod.folderName.empty()) continue;
+
+      Mo2MetaJob job;
+      job.modDir = modsDir + "/" + mod.folderName;
+      auto archiveIt = modArchivePaths.find(i);
+      if (archiveIt != modArchivePaths.end()) job.archivePath = archiveIt->second;
+      job.modName = mod.name;
+      job.version = mod.version;
+      job.modId = mod.modId;
+      job.fileId = mod.fileId;
+      auto fileIt = nexusFiles.find({mod.modId, mod.fileId});
+      if (fileIt != nexusFiles.end()) {
+        job.fileName = fileIt->second.first;
+        if (!fileIt->second.second.empty()) job.version = fileIt->second.second;
+      }
+      job.installed = fs::exists(job.modDir);
+      metaJobs.push_back(job);
+    }
+
+    int metaWritten = Mo2MetaWriter::writeAll(metaJobs, gameDomain, numThreads);
+    std::cout << "Wrote MO2 metadata for " << metaWritten << " mods" << std::endl;
+  }
+  RunReport::endPhase("metadata");
+
+  // Optional: pack loose assets into BSAs
+  std::vector<std::string> dummyPlugins;
+  if (packBsa) {
+    if (!BsaPacker::supportsGame(gameDomain)) {
+      std::cerr << "  [WARN] BSA packing is only supported for Skyrim Special Edition, skipping"
+                << std::endl;
+    } else if (bsaOptions.compress && !BsaWriter::lz4Available()) {
+      std::cerr << "  [WARN] This build has no LZ4 support, skipping BSA packing" << std::endl;
+    } else {
+      std::cout << std::endl << "=== Packing loose files into BSAs ===" << std::endl;
+      RunReport::beginPhase("bsa");
+      BsaPackResult packResult = BsaPacker::packAll(collection.mods, modsDir, manifestDir,
+                                                    bsaOptions, numThreads);
+      dummyPlugins = packResult.dummyPlugins;
+      std::cout << "  Packed " << packResult.filesPacked << " files ("
+                << (packResult.bytesPacked / (1024 * 1024)) << " MB) from "
+                << packResult.modsPacked << " mods into " << packResult.archivesWritten
+                << " archives" << std::endl;
+      RunReport::endPhase("bsa");
+    }
+  } else {
+    dummyPlugins = BsaPacker::existingDummyPlugins(collection.mods, manifestDir);
+  }
+
+  // Optional: link identical files across mods (after packing, so packed
+  // loose files are no longer candidates)
+  if (dedup) {
+    std::cout << std::endl << "=== Deduplicating identical files across mods ===" << std::endl;
+    RunReport::beginPhase("dedup");
+    DedupResult dedupResult =
+        ModDeduplicator::run(collection.mods, modsDir, manifestDir, dedupMode, numThreads);
+    std::cout << "  Linked " << dedupResult.filesLinked << " duplicate files ("
+              << (dedupResult.bytesReclaimed / (1024 * 1024)) << " MB reclaimed, "
+              << dedupResult.filesHashed << " files hashed)" << std::endl;
+    RunReport::endPhase("dedup");
+  }
+
+  // Generate plugins.txt with LOOT sorting
+  std::cout << std::endl << "Generating plugins.txt..." << std::endl;
+  RunReport::beginPhase("load order");
+
+  std::vector<std::string> pluginOrder;
+  if (pluginPreloader) {
     std::cout << "  Using game path: " << gamePath << std::endl;
-    pluginOrder = PluginListGenerator::sortPluginsWithLoot(gamePath, modsDir, collection.plugins);
+    pluginOrder = pluginPreloader->finish();
   } else {
     std::cerr << "  [WARN] Could not find game path, using collection order" << std::endl;
     for (const auto &plugin : collection.plugins) {
@@ -3262,6 +6855,11 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Dummy plugins only exist to load packed BSAs; they have no records so
+  // their position doesn't matter
+  std::sort(dummyPlugins.begin(), dummyPlugins.end());
+  pluginOrder.insert(pluginOrder.end(), dummyPlugins.begin(), dummyPlugins.end());
+
   PluginListGenerator::writePluginList(profilesDir + "/plugins.txt", pluginOrder);
 
   // Generate modlist.txt using combined sorting
@@ -3270,6 +6868,14 @@ int main(int argc, char *argv[]) {
       ModListGenerator::generateModOrderCombined(collection.mods, collection.modRules, pluginOrder, modsDir);
 
   ModListGenerator::writeModList(profilesDir + "/modlist.txt", modOrder);
+  RunReport::endPhase("load order");
+
+  // Finish background staging deletion before removing the temp root
+  g_reclaimer.drain();
+  if (g_reclaimer.bytesReclaimed() > 0) {
+    std::cout << "Reclaimed " << (g_reclaimer.bytesReclaimed() / (1024 * 1024))
+              << " MB of staging space in the background" << std::endl;
+  }
 
   // Cleanup temp directory
   try {
@@ -3280,6 +6886,11 @@ int main(int argc, char *argv[]) {
     // Ignore cleanup errors
   }
 
+  // Where the time went, and what changed since the last run
+  fs::path reportDir = fs::path(mo2Path) / ".nexusbridge" / "reports";
+  std::cout << std::endl << RunReport::save(reportDir);
+  std::cout << "  Full report: " << (reportDir / "last_run.json").string() << std::endl;
+
   // Summary
   std::cout << std::endl << "=== Summary ===" << std::endl;
   std::cout << "Downloaded: " << downloaded << std::endl;
@@ -3289,5 +6900,13 @@ int main(int argc, char *argv[]) {
   std::cout << std::endl
             << "Done! Please restart Mod Organizer 2." << std::endl;
 
-  return (failed > 0) ? 1 : 0;
+  int status = (failed > 0) ? 1 : 0;
+  if (InstallPool::stranded()) {
+    // A stalled install thread is still blocked and may wake up during
+    // static destruction; leave without running it
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::_Exit(status);
+  }
+  return status;
 }
@@ -0,0 +1,405 @@
+#include "peer_cache.hpp"
+#include "case_fold.hpp"
+#include "content_hash.hpp"
+#include "dir_walker.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <csignal>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+namespace PeerCache {
+
+namespace {
+
+constexpr std::chrono::seconds kRefreshInterval(30);
+
+bool isArchiveName(std::string_view name) {
+    return CaseFold::endsWith(name, ".7z") || CaseFold::endsWith(name, ".zip") ||
+           CaseFold::endsWith(name, ".rar");
+}
+
+bool isMd5(const std::string& text) {
+    return text.size() == 32 &&
+           std::all_of(text.begin(), text.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+int64_t mtimeOf(const fs::path& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+#ifdef _WIN32
+using Socket = SOCKET;
+void closeSocket(Socket s) { closesocket(s); }
+void shutdownSocket(Socket s) { shutdown(s, SD_BOTH); }
+#else
+using Socket = int;
+void closeSocket(Socket s) { close(s); }
+void shutdownSocket(Socket s) { shutdown(s, SHUT_RDWR); }
+#endif
+
+bool sendAll(Socket s, const char* data, size_t len) {
+    while (len > 0) {
+#ifdef _WIN32
+        int sent = send(s, data, static_cast<int>(std::min<size_t>(len, 1 << 30)), 0);
+#elif defined(MSG_NOSIGNAL)
+        ssize_t sent = send(s, data, len, MSG_NOSIGNAL);
+#else
+        ssize_t sent = send(s, data, len, 0);
+#endif
+        if (sent <= 0) return false;
+        data += sent;
+        len -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void sendStatus(Socket s, const char* status) {
+    std::string response = std::string("HTTP/1.1 ") + status +
+                           "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    sendAll(s, response.data(), response.size());
+}
+
+// Body of a file after the headers have gone out
+bool sendFile(Socket s, const fs::path& path, uint64_t size) {
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    off_t offset = 0;
+    while (static_cast<uint64_t>(offset) < size) {
+        ssize_t sent = sendfile(s, fd, &offset, std::min<uint64_t>(size - offset, 1 << 30));
+        if (sent <= 0) break;
+    }
+    close(fd);
+    return static_cast<uint64_t>(offset) == size;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<char> buffer(1024 * 1024);
+    uint64_t left = size;
+    while (left > 0 && in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(left, buffer.size())));
+        std::streamsize got = in.gcount();
+        if (got <= 0 || !sendAll(s, buffer.data(), static_cast<size_t>(got))) return false;
+        left -= static_cast<uint64_t>(got);
+    }
+    return left == 0;
+#endif
+}
+
+} // namespace
+
+ArchiveIndex::ArchiveIndex(const fs::path& dir, const fs::path& cacheFile)
+    : dir_(dir), cacheFile_(cacheFile) {
+    load();
+}
+
+void ArchiveIndex::load() {
+    std::ifstream in(cacheFile_);
+    std::string line;
+    while (std::getline(in, line)) {
+        // md5 \t size \t mtime \t name
+        std::istringstream fields(line);
+        Known known;
+        std::string name;
+        if (!(fields >> known.md5 >> known.size >> known.mtime)) continue;
+        fields.get();
+        std::getline(fields, name);
+        if (!isMd5(known.md5) || name.empty()) continue;
+        known.md5 = CaseFold::fold(known.md5);
+        byName_[name] = known;
+    }
+}
+
+void ArchiveIndex::save() const {
+    std::error_code ec;
+    fs::create_directories(cacheFile_.parent_path(), ec);
+    fs::path temp = cacheFile_;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out) return;
+        for (const auto& [name, known] : byName_) {
+            out << known.md5 << '\t' << known.size << '\t' << known.mtime << '\t' << name << '\n';
+        }
+    }
+    fs::rename(temp, cacheFile_, ec);
+}
+
+size_t ArchiveIndex::refresh(unsigned threads) {
+    DirWalker::Options options;
+    options.recursive = false;
+    options.sizes = true;
+    DirWalker::Listing listing = DirWalker::walk(dir_, options);
+
+    struct Pending {
+        std::string name;
+        uint64_t size;
+        int64_t mtime;
+    };
+    std::vector<Pending> pending;
+    std::map<std::string, Known> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : listing) {
+            if (!isArchiveName(entry.name)) continue;
+            std::string name(entry.name);
+            int64_t mtime = mtimeOf(listing.path(entry));
+            auto it = byName_.find(name);
+            if (it != byName_.end() && it->second.size == entry.size && it->second.mtime == mtime) {
+                current[name] = it->second;
+            } else {
+                pending.push_back({name, entry.size, mtime});
+            }
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::mutex resultMutex;
+    auto worker = [&]() {
+        while (true) {
+            size_t i = next.fetch_add(1);
+            if (i >= pending.size()) break;
+            std::string md5;
+            if (!ContentHash::md5File(dir_ / pending[i].name, md5)) continue;
+            std::lock_guard<std::mutex> lock(resultMutex);
+            current[pending[i].name] = Known{md5, pending[i].size, pending[i].mtime};
+        }
+    };
+    std::vector<std::thread> pool;
+    unsigned count = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(pending.size())));
+    for (unsigned t = 1; t < count; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    byName_ = std::move(current);
+    byMd5_.clear();
+    for (const auto& [name, known] : byName_) byMd5_[known.md5] = name;
+    save();
+    return pending.size();
+}
+
+fs::path ArchiveIndex::find(const std::string& md5) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = byMd5_.find(CaseFold::fold(md5));
+    return it == byMd5_.end() ? fs::path() : dir_ / it->second;
+}
+
+size_t ArchiveIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return byMd5_.size();
+}
+
+Server::Server(ArchiveIndex& index, unsigned hashThreads)
+    : index_(index), hashThreads_(hashThreads), lastRefresh_(std::chrono::steady_clock::now()) {}
+
+Server::~Server() {
+    stop();
+}
+
+bool Server::start(uint16_t port, std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error) *error = std::string(what) + ": " + std::strerror(errno);
+        if (listener_ != -1) closeSocket(static_cast<Socket>(listener_));
+        listener_ = -1;
+        return false;
+    };
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return fail("WSAStartup");
+#else
+    // A peer hanging up mid-transfer must not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    Socket s = socket(AF_INET, SOCK_STREAM, 0);
+#ifdef _WIN32
+    if (s == INVALID_SOCKET) return fail("socket");
+#else
+    if (s < 0) return fail("socket");
+#endif
+    listener_ = static_cast<intptr_t>(s);
+
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return fail("bind");
+    if (listen(s, 64) != 0) return fail("listen");
+
+    socklen_t len = sizeof(addr);
+    getsockname(s, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    stopping_ = false;
+    acceptThread_ = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void Server::stop() {
+    if (listener_ == -1) return;
+    stopping_ = true;
+    if (acceptThread_.joinable()) acceptThread_.join();
+    closeSocket(static_cast<Socket>(listener_));
+    listener_ = -1;
+
+    // Connection threads use the index and this object. Let them finish
+    // their responses for a while, then cut off the rest (a slow peer
+    // could take much longer) and wait for every one of them.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        reapConnections();
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            if (connections_.empty()) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    std::list<Connection> remaining;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        for (auto& connection : connections_) {
+            if (!connection.done) shutdownSocket(static_cast<Socket>(connection.socket));
+        }
+        remaining.splice(remaining.end(), connections_);
+    }
+    for (auto& connection : remaining) connection.thread.join();
+    if (refreshThread_.joinable()) refreshThread_.join();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void Server::acceptLoop() {
+    Socket listener = static_cast<Socket>(listener_);
+    while (!stopping_) {
+        reapConnections();
+
+        // Wake up regularly to notice stop()
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        timeval timeout{0, 250 * 1000};
+        if (select(static_cast<int>(listener) + 1, &readable, nullptr, nullptr, &timeout) <= 0) continue;
+
+        Socket client = accept(listener, nullptr, nullptr);
+#ifdef _WIN32
+        if (client == INVALID_SOCKET) continue;
+#else
+        if (client < 0) continue;
+#endif
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        Connection* connection = &connections_.emplace_back();
+        connection->socket = static_cast<intptr_t>(client);
+        connection->thread = std::thread([this, connection, client] {
+            handle(static_cast<intptr_t>(client));
+            {
+                // stop() shuts down the sockets of unfinished connections,
+                // so this one must not be closed (and reused) before then
+                std::lock_guard<std::mutex> lock(connectionsMutex_);
+                connection->done = true;
+            }
+            closeSocket(client);
+        });
+    }
+}
+
+// Join the threads of connections that have been answered
+void Server::reapConnections() {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if (!it->done) {
+            ++it;
+            continue;
+        }
+        it->thread.join();
+        it = connections_.erase(it);
+    }
+}
+
+void Server::handle(intptr_t clientHandle) {
+    Socket client = static_cast<Socket>(clientHandle);
+#ifdef _WIN32
+    DWORD timeoutMs = 10000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+#else
+    timeval timeout{10, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+    // Only the request line matters; headers are read and ignored
+    std::string request;
+    char buffer[2048];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        int got = static_cast<int>(recv(client, buffer, sizeof(buffer), 0));
+        if (got <= 0) return;
+        request.append(buffer, static_cast<size_t>(got));
+    }
+
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    if (method != "GET" && method != "HEAD") return sendStatus(client, "405 Method Not Allowed");
+
+    const std::string prefix = "/md5/";
+    std::string md5 = target.compare(0, prefix.size(), prefix) == 0 ? target.substr(prefix.size()) : "";
+    if (!isMd5(md5)) return sendStatus(client, "400 Bad Request");
+
+    fs::path path = index_.find(md5);
+    std::error_code ec;
+    uint64_t size = path.empty() ? 0 : fs::file_size(path, ec);
+    if (path.empty() || ec) {
+        maybeRefresh();
+        return sendStatus(client, "404 Not Found");
+    }
+
+    std::string headers = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " +
+                          std::to_string(size) + "\r\nConnection: close\r\n\r\n";
+    if (!sendAll(client, headers.data(), headers.size())) return;
+    if (method == "HEAD") return;
+    if (sendFile(client, path, size)) served_++;
+}
+
+void Server::maybeRefresh() {
+    std::lock_guard<std::mutex> lock(refreshMutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (refreshing_ || now - lastRefresh_ < kRefreshInterval || stopping_) return;
+    lastRefresh_ = now;
+    if (refreshThread_.joinable()) refreshThread_.join();  // Already finished
+    refreshing_ = true;
+    refreshThread_ = std::thread([this] {
+        index_.refresh(hashThreads_);
+        refreshing_ = false;
+    });
+}
+
+} // namespace PeerCache
@@ -0,0 +1,104 @@
+#pragma once
+
+// Sharing downloaded archives between machines on a LAN. One instance
+// serves its downloads folder over plain HTTP, addressed by MD5
+// (GET /md5/<hex>); others try their peers before the Nexus CDN and check
+// what they get against the MD5 the collection lists.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace PeerCache {
+
+// MD5 -> archive for one folder. Hashes are kept in a cache file keyed by
+// name, size and modification time, so only new or changed archives are
+// read again.
+class ArchiveIndex {
+public:
+    ArchiveIndex(const fs::path& dir, const fs::path& cacheFile);
+
+    // Hash whatever is new or changed (on `threads` threads) and save the
+    // cache. Returns the number of archives hashed.
+    size_t refresh(unsigned threads);
+
+    // Archive with this MD5 (any case), or empty
+    fs::path find(const std::string& md5) const;
+
+    size_t size() const;
+
+private:
+    struct Known {
+        std::string md5;
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    void load();
+    void save() const;
+
+    fs::path dir_;
+    fs::path cacheFile_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Known> byName_;
+    std::map<std::string, std::string> byMd5_;  // md5 -> name
+};
+
+// Minimal HTTP/1.1 file server over an ArchiveIndex. One thread accepts,
+// each connection gets its own thread and is closed after one response.
+// A request for an unknown MD5 triggers a re-index (at most every 30s),
+// so archives downloaded after start-up become available too.
+class Server {
+public:
+    explicit Server(ArchiveIndex& index, unsigned hashThreads = 1);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Listen on all interfaces (port 0 = any free port)
+    bool start(uint16_t port, std::string* error = nullptr);
+    // Waits for the connections being answered, cutting off any still
+    // going after 10s
+    void stop();
+    uint16_t port() const { return port_; }
+
+    uint64_t filesServed() const { return served_.load(); }
+
+private:
+    struct Connection {
+        intptr_t socket = -1;
+        bool done = false;  // Responded; its thread is about to exit
+        std::thread thread;
+    };
+
+    void acceptLoop();
+    void handle(intptr_t client);
+    void reapConnections();
+    void maybeRefresh();
+
+    ArchiveIndex& index_;
+    unsigned hashThreads_;
+    intptr_t listener_ = -1;
+    uint16_t port_ = 0;
+    std::thread acceptThread_;
+    std::atomic<bool> stopping_{false};
+    std::mutex connectionsMutex_;
+    std::list<Connection> connections_;
+    std::atomic<uint64_t> served_{0};
+    std::mutex refreshMutex_;
+    std::chrono::steady_clock::time_point lastRefresh_;
+    std::atomic<bool> refreshing_{false};
+    std::thread refreshThread_;
+};
+
+} // namespace PeerCache
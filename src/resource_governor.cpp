@@ -0,0 +1,268 @@
+#include "resource_governor.hpp"
+#include "subprocess.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace ResourceGovernor {
+
+namespace {
+
+constexpr uint64_t kMB = 1024 * 1024;
+constexpr uint64_t kGB = 1024 * kMB;
+
+// Per-resource sums, or counts of leases holding each resource
+struct Totals {
+    uint64_t memory = 0;
+    uint64_t staging = 0;
+    uint64_t files = 0;
+    uint64_t tasks = 0;
+
+    void add(const Cost& cost, int sign, bool countOnly) {
+        auto apply = [&](uint64_t& total, uint64_t amount) {
+            if (countOnly) amount = amount > 0 ? 1 : 0;
+            total = sign > 0 ? total + amount : total - std::min(total, amount);
+        };
+        apply(memory, cost.memoryBytes);
+        apply(staging, cost.stagingBytes);
+        apply(files, cost.openFiles);
+        apply(tasks, cost.heavyTasks);
+    }
+};
+
+std::mutex g_mutex;
+std::condition_variable g_changed;
+std::atomic<bool> g_enabled{false};
+Budgets g_budgets;
+Totals g_reserved;           // Everything leased, parked or not
+Totals g_activeHolders;      // Unparked leases holding each resource
+uint64_t g_baselineMemory = 0;  // Resident when the governor started
+uint64_t g_nextId = 1;
+
+// One resource: fits, or nothing in progress holds any of it (so waiting
+// can't help)
+bool fitsOne(uint64_t budget, uint64_t used, uint64_t cost, uint64_t activeHolders) {
+    return budget == 0 || cost == 0 || used + cost <= budget || activeHolders == 0;
+}
+
+// Called with g_mutex held
+bool fits(const Cost& cost, uint64_t observed) {
+    uint64_t memoryUsed = std::max(g_baselineMemory + g_reserved.memory, observed);
+    return fitsOne(g_budgets.memoryBytes, memoryUsed, cost.memoryBytes, g_activeHolders.memory) &&
+           fitsOne(g_budgets.stagingBytes, g_reserved.staging, cost.stagingBytes,
+                   g_activeHolders.staging) &&
+           fitsOne(g_budgets.openFiles, g_reserved.files, cost.openFiles, g_activeHolders.files) &&
+           fitsOne(g_budgets.heavyTasks, g_reserved.tasks, cost.heavyTasks, g_activeHolders.tasks);
+}
+
+uint64_t totalMemory() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+#else
+    uint64_t total = 0;
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) total = static_cast<uint64_t>(pages) * pageSize;
+#ifdef __linux__
+    // A container or VM slice may have less than the machine (cgroup v2)
+    std::ifstream cgroups("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroups, line)) {
+        if (line.rfind("0::", 0) != 0) continue;
+        std::ifstream limitFile("/sys/fs/cgroup" + line.substr(3) + "/memory.max");
+        unsigned long long limit = 0;
+        if (limitFile >> limit && limit > 0) total = total ? std::min<uint64_t>(total, limit) : limit;
+    }
+#endif
+    return total;
+#endif
+}
+
+size_t descriptorLimit() {
+#ifdef _WIN32
+    return 2048;  // Handles aren't limited per process the way fds are
+#else
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) return 4096;
+    return static_cast<size_t>(limit.rlim_cur);
+#endif
+}
+
+uint64_t freeSpace(fs::path dir) {
+    std::error_code ec;
+    while (!dir.empty() && !fs::exists(dir, ec)) {
+        if (dir == dir.parent_path()) break;
+        dir = dir.parent_path();
+    }
+    fs::space_info space = fs::space(dir.empty() ? fs::current_path(ec) : dir, ec);
+    return ec ? 0 : space.available;
+}
+
+#ifdef __linux__
+uint64_t residentBytes(const std::string& pid) {
+    std::ifstream statm("/proc/" + pid + "/statm");
+    unsigned long long size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+#endif
+
+std::string formatBytes(uint64_t bytes) {
+    char text[32];
+    if (bytes >= kGB) {
+        std::snprintf(text, sizeof(text), "%.1f GB", static_cast<double>(bytes) / kGB);
+    } else {
+        std::snprintf(text, sizeof(text), "%llu MB", static_cast<unsigned long long>(bytes / kMB));
+    }
+    return text;
+}
+
+} // namespace
+
+Budgets lowResourceProfile(const fs::path& tempDir) {
+    Budgets budgets;
+    uint64_t memory = totalMemory();
+    budgets.memoryBytes = memory > 0 ? memory / 2 : 2 * kGB;
+    // Never more than is actually free, however small the disk
+    uint64_t free = freeSpace(tempDir);
+    budgets.stagingBytes = std::max<uint64_t>(free / 2, kGB);
+    if (free > 0) budgets.stagingBytes = std::min(budgets.stagingBytes, free);
+    budgets.openFiles = std::clamp<size_t>(descriptorLimit() / 2, 64, 1024);
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t byMemory = std::max<uint64_t>(1, budgets.memoryBytes / kGB);
+    budgets.heavyTasks = static_cast<unsigned>(std::min<uint64_t>({std::max(1u, cores / 2), byMemory, 4}));
+    budgets.downloads = 2;
+    return budgets;
+}
+
+void configure(const Budgets& budgets) {
+    uint64_t baseline = observedMemory();
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_budgets = budgets;
+    g_baselineMemory = baseline;
+    g_enabled = budgets.any();
+    g_changed.notify_all();
+}
+
+const Budgets& budgets() {
+    return g_budgets;
+}
+
+bool enabled() {
+    return g_enabled;
+}
+
+std::string describe(const Budgets& budgets) {
+    std::string text;
+    auto item = [&](const std::string& part) {
+        if (!text.empty()) text += ", ";
+        text += part;
+    };
+    if (budgets.memoryBytes) item("memory " + formatBytes(budgets.memoryBytes));
+    if (budgets.stagingBytes) item("temp space " + formatBytes(budgets.stagingBytes));
+    if (budgets.openFiles) item(std::to_string(budgets.openFiles) + " open files");
+    if (budgets.heavyTasks) {
+        item(std::to_string(budgets.heavyTasks) + " install" + (budgets.heavyTasks == 1 ? "" : "s") +
+             " at once");
+    }
+    if (budgets.downloads) {
+        item(std::to_string(budgets.downloads) + " download" + (budgets.downloads == 1 ? "" : "s") +
+             " at once");
+    }
+    return text.empty() ? "none" : text;
+}
+
+Lease::Lease(Lease&& other) noexcept
+    : id_(other.id_), cost_(other.cost_), parked_(other.parked_) {
+    other.id_ = 0;
+}
+
+Lease& Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        id_ = other.id_;
+        cost_ = other.cost_;
+        parked_ = other.parked_;
+        other.id_ = 0;
+    }
+    return *this;
+}
+
+void Lease::release() {
+    if (id_ == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_reserved.add(cost_, -1, false);
+        if (!parked_) g_activeHolders.add(cost_, -1, true);
+    }
+    id_ = 0;
+    g_changed.notify_all();
+}
+
+void Lease::park(bool parked) {
+    if (id_ == 0 || parked == parked_) return;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_activeHolders.add(cost_, parked ? -1 : 1, true);
+    }
+    parked_ = parked;
+    if (parked) g_changed.notify_all();
+}
+
+Lease acquire(const Cost& cost, const std::function<void()>& waiting) {
+    if (!g_enabled) return Lease();
+
+    const bool checkMemory = cost.memoryBytes > 0 && g_budgets.memoryBytes > 0;
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while (true) {
+        uint64_t observed = 0;
+        if (checkMemory) {
+            lock.unlock();
+            observed = observedMemory();
+            lock.lock();
+        }
+        if (fits(cost, observed)) break;
+
+        // Memory can be freed without a lease being returned, so look again
+        // every so often even without a notification
+        g_changed.wait_for(lock, std::chrono::milliseconds(250));
+        if (waiting) {
+            lock.unlock();
+            waiting();
+            lock.lock();
+        }
+    }
+    g_reserved.add(cost, 1, false);
+    g_activeHolders.add(cost, 1, true);
+    return Lease(g_nextId++, cost);
+}
+
+uint64_t observedMemory() {
+#ifdef __linux__
+    uint64_t total = residentBytes("self");
+    for (long child : Subprocess::running()) total += residentBytes(std::to_string(child));
+    return total;
+#else
+    return 0;
+#endif
+}
+
+} // namespace ResourceGovernor
@@ -0,0 +1,98 @@
+#pragma once
+
+// Explicit resource budgets for small machines (--low-resource): memory,
+// temp space for extracted archives, open file descriptors and how many
+// heavy tasks (extract + install) run at once. Work asks for a Lease
+// covering what it expects to use and waits until that fits; nothing
+// here limits a task once it has been admitted.
+//
+// Memory admission uses the estimates in the leases and, on Linux, what
+// the process and its running 7z children actually have resident,
+// whichever is higher. A request bigger than a whole budget is admitted
+// when nothing else is using that resource, so it runs alone rather than
+// never.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace ResourceGovernor {
+
+// 0 = no limit
+struct Budgets {
+    uint64_t memoryBytes = 0;
+    uint64_t stagingBytes = 0;   // Extracted archives in the temp folder
+    size_t openFiles = 0;
+    unsigned heavyTasks = 0;     // Installs (extraction, FOMOD, copying) at once
+    unsigned downloads = 0;      // Concurrent archive downloads
+
+    bool any() const {
+        return memoryBytes || stagingBytes || openFiles || heavyTasks || downloads;
+    }
+};
+
+// What one piece of work expects to need at its peak
+struct Cost {
+    uint64_t memoryBytes = 0;
+    uint64_t stagingBytes = 0;
+    size_t openFiles = 0;
+    unsigned heavyTasks = 0;
+};
+
+// Budgets for a machine like this one under the low-resource profile:
+// half its memory (or its cgroup's limit), half the free space where
+// tempDir is (at least 1 GB, at most all of it), half the descriptor limit (at most 1024), one heavy task
+// per two cores and per GB of the memory budget (at most 4)
+Budgets lowResourceProfile(const fs::path& tempDir);
+
+// Start enforcing budgets (a zero Budgets turns the governor off)
+void configure(const Budgets& budgets);
+const Budgets& budgets();
+bool enabled();
+
+// "memory 4.0 GB, temp space 20.0 GB, ..." (limited resources only)
+std::string describe(const Budgets& budgets);
+
+// Reserved resources, returned when the lease is destroyed or released
+class Lease {
+public:
+    Lease() = default;
+    ~Lease() { release(); }
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&& other) noexcept;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    void release();
+
+    // A parked lease keeps its resources but isn't counted as work in
+    // progress: its holder only frees them once other tasks run (a shared
+    // extraction waiting for its remaining consumers). Requests that
+    // are blocked only by parked leases are admitted over budget.
+    void park(bool parked);
+
+    bool held() const { return id_ != 0; }
+
+private:
+    friend Lease acquire(const Cost&, const std::function<void()>&);
+    Lease(uint64_t id, const Cost& cost) : id_(id), cost_(cost) {}
+
+    uint64_t id_ = 0;
+    Cost cost_;
+    bool parked_ = false;
+};
+
+// Wait until cost fits the budgets and reserve it. While blocked, waiting
+// is called a few times a second; it may throw to give up. Returns an
+// empty lease straight away when the governor is off.
+Lease acquire(const Cost& cost, const std::function<void()>& waiting = {});
+
+// Resident memory of this process and the children Subprocess is running
+// (0 where that can't be measured)
+uint64_t observedMemory();
+
+} // namespace ResourceGovernor
@@ -0,0 +1,212 @@
+#include "retry_policy.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <curl/curl.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace RetryPolicy {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kTripAfter = 5;            // Consecutive failures that open a breaker
+constexpr Millis kCooldown(5000);        // First open period, doubled per trip
+constexpr Millis kMaxCooldown(120000);
+constexpr Millis kProbeTimeout(180000);  // A probe that never reports is given up on
+
+std::mt19937_64& rng() {
+    thread_local std::mt19937_64 engine(
+        std::random_device{}() ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return engine;
+}
+
+enum class State { Closed, Open, HalfOpen };
+
+struct Breaker {
+    State state = State::Closed;
+    int failures = 0;   // Consecutive retryable failures while closed
+    int trips = 0;      // Consecutive openings, for the cooldown
+    Clock::time_point openUntil;
+    Clock::time_point probeStarted;
+};
+
+std::mutex g_mutex;
+std::condition_variable g_changed;
+std::map<std::string, Breaker> g_breakers;
+thread_local Millis t_retryAfter(0);
+
+void open(Breaker& breaker, Millis atLeast) {
+    breaker.trips++;
+    Millis cooldown = std::min(kMaxCooldown, kCooldown * (1 << std::min(breaker.trips - 1, 5)));
+    breaker.state = State::Open;
+    breaker.failures = 0;
+    breaker.openUntil = Clock::now() + std::max(cooldown, atLeast);
+}
+
+} // namespace
+
+const char* describe(ErrorClass cls) {
+    switch (cls) {
+    case ErrorClass::None: return "ok";
+    case ErrorClass::Transient: return "transient";
+    case ErrorClass::Quota: return "rate limited";
+    case ErrorClass::Permanent: return "permanent";
+    case ErrorClass::Local: return "local";
+    }
+    return "unknown";
+}
+
+ErrorClass classify(int curlCode, long httpCode) {
+    switch (static_cast<CURLcode>(curlCode)) {
+    case CURLE_OK:
+        break;
+    case CURLE_COULDNT_RESOLVE_PROXY:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return ErrorClass::Transient;
+    case CURLE_FAILED_INIT:
+    case CURLE_UNSUPPORTED_PROTOCOL:
+    case CURLE_URL_MALFORMAT:
+    case CURLE_WRITE_ERROR:
+    case CURLE_READ_ERROR:
+    case CURLE_OUT_OF_MEMORY:
+    case CURLE_ABORTED_BY_CALLBACK:
+    case CURLE_BAD_FUNCTION_ARGUMENT:
+        return ErrorClass::Local;
+    default:
+        return ErrorClass::Permanent;
+    }
+
+    if (httpCode == 429) return ErrorClass::Quota;
+    if (httpCode == 408 || httpCode == 425) return ErrorClass::Transient;
+    if (httpCode >= 500) return httpCode == 501 || httpCode == 505 ? ErrorClass::Permanent
+                                                                   : ErrorClass::Transient;
+    if (httpCode >= 400) return ErrorClass::Permanent;
+    return ErrorClass::None;
+}
+
+Millis Backoff::next(Millis floor) {
+    Millis::rep low = base_.count();
+    Millis::rep high = std::max(low, std::min(cap_.count(), previous_.count() * 3));
+    std::uniform_int_distribution<Millis::rep> pick(low, high);
+    previous_ = Millis(pick(rng()));
+    return std::max(previous_, floor);
+}
+
+std::string hostOf(std::string_view url) {
+    size_t start = url.find("://");
+    start = start == std::string_view::npos ? 0 : start + 3;
+    size_t end = url.find_first_of(":/?#", start);
+    std::string_view host = url.substr(start, end == std::string_view::npos ? end : end - start);
+    size_t at = host.rfind('@');
+    if (at != std::string_view::npos) host.remove_prefix(at + 1);
+    return std::string(host);
+}
+
+bool admit(const std::string& host, Millis maxWait) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    Clock::time_point deadline = Clock::now() + maxWait;
+    t_retryAfter = Millis(0);
+    while (true) {
+        Breaker& breaker = g_breakers[host];
+        Clock::time_point now = Clock::now();
+        if (breaker.state == State::Closed) return true;
+
+        Clock::time_point wakeAt;
+        if (breaker.state == State::Open) {
+            if (now >= breaker.openUntil) {
+                breaker.state = State::HalfOpen;
+                breaker.probeStarted = now;
+                return true;
+            }
+            wakeAt = breaker.openUntil;
+        } else {
+            // Half-open: wait for the probe's result
+            if (now - breaker.probeStarted >= kProbeTimeout) {
+                breaker.probeStarted = now;
+                return true;
+            }
+            wakeAt = breaker.probeStarted + kProbeTimeout;
+        }
+
+        if (now >= deadline) {
+            t_retryAfter = std::chrono::duration_cast<Millis>(wakeAt - now);
+            return false;
+        }
+        g_changed.wait_until(lock, std::min(wakeAt, deadline));
+    }
+}
+
+void record(const std::string& host, ErrorClass cls, Millis retryAfter) {
+    t_retryAfter = retryAfter;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Breaker& breaker = g_breakers[host];
+    if (cls == ErrorClass::Local) {
+        // No verdict: hand the probe to the next caller
+        if (breaker.state == State::HalfOpen) {
+            breaker.state = State::Open;
+            breaker.openUntil = Clock::now();
+            g_changed.notify_all();
+        }
+        return;
+    }
+    if (!retryable(cls)) {
+        // The host answered (permanent errors are about the request)
+        if (breaker.state != State::Open) {
+            breaker = Breaker();
+            g_changed.notify_all();
+        }
+        return;
+    }
+
+    if (breaker.state == State::HalfOpen) {
+        open(breaker, retryAfter);
+    } else if (breaker.state == State::Closed) {
+        if (cls == ErrorClass::Quota && retryAfter.count() > 0) {
+            // Everyone shares the quota, so everyone waits
+            breaker.state = State::Open;
+            breaker.failures = 0;
+            breaker.openUntil = Clock::now() + retryAfter;
+        } else if (++breaker.failures >= kTripAfter) {
+            open(breaker, retryAfter);
+        }
+    }
+    g_changed.notify_all();
+}
+
+Admission::Admission(std::string host, Millis maxWait)
+    : host_(std::move(host)), admitted_(admit(host_, maxWait)), pending_(admitted_) {}
+
+Admission::~Admission() {
+    if (pending_) RetryPolicy::record(host_, ErrorClass::Local);
+}
+
+void Admission::record(ErrorClass cls, Millis retryAfter, const std::string& effectiveHost) {
+    pending_ = false;
+    if (effectiveHost.empty() || effectiveHost == host_) {
+        RetryPolicy::record(host_, cls, retryAfter);
+        return;
+    }
+    RetryPolicy::record(host_, ErrorClass::None);
+    RetryPolicy::record(effectiveHost, cls, retryAfter);
+}
+
+Millis lastRetryAfter() {
+    return t_retryAfter;
+}
+
+} // namespace RetryPolicy
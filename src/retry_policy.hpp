@@ -0,0 +1,107 @@
+#pragma once
+
+// Retry decisions for network requests: what kind of failure a response
+// is, how long to wait before trying again, and per-host circuit breakers
+// that hold every caller back while a host keeps failing.
+//
+// Waits use decorrelated jitter (each one random between the base delay
+// and three times the previous wait), so workers that failed together
+// don't come back together.
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+namespace RetryPolicy {
+
+using Millis = std::chrono::milliseconds;
+
+enum class ErrorClass {
+    None,       // Succeeded
+    Transient,  // Timeouts, dropped connections, 5xx: retry after a backoff
+    Quota,      // 429: retry, but not before the host allows it
+    Permanent,  // Other 4xx, unsupported requests: retrying won't help
+    Local,      // Disk, memory, bad URLs: retrying won't help, and the
+                // host had no part in it
+};
+
+inline bool retryable(ErrorClass cls) {
+    return cls == ErrorClass::Transient || cls == ErrorClass::Quota;
+}
+
+// "transient", "quota", ... for log lines
+const char* describe(ErrorClass cls);
+
+// curlCode is a CURLcode; httpCode is 0 when no response arrived
+ErrorClass classify(int curlCode, long httpCode);
+
+class Backoff {
+public:
+    explicit Backoff(Millis base = Millis(500), Millis cap = Millis(30000))
+        : base_(base), cap_(cap), previous_(base) {}
+
+    // Next wait, never shorter than floor (e.g. the host's Retry-After)
+    Millis next(Millis floor = Millis(0));
+
+    void reset() { previous_ = base_; }
+
+private:
+    Millis base_;
+    Millis cap_;
+    Millis previous_;
+};
+
+// Host part of a URL ("https://host:443/path" -> "host"), the breaker key
+std::string hostOf(std::string_view url);
+
+// Per-host circuit breakers. After several retryable failures in a row a
+// host's breaker opens and requests to it wait out a cooldown (5s,
+// doubling on repeated trips up to 2 minutes) instead of reaching it.
+// Then a single probe is let through; its result closes the breaker or
+// opens it again. A quota response with Retry-After opens the breaker for
+// exactly that long, since the quota is shared by every worker. Long
+// transfers should report success as soon as the response starts (the
+// host is evidently up) rather than after the whole body.
+//
+// Blocks until a request to host may go out. Returns false if the breaker
+// won't let one through within maxWait.
+bool admit(const std::string& host, Millis maxWait);
+
+// Report how a request admitted by admit() went. A local failure says
+// nothing about the host: a half-open breaker stays half-open and lets
+// the next probe through.
+void record(const std::string& host, ErrorClass cls, Millis retryAfter = Millis(0));
+
+// admit() and record() as a scope guard, so that every way out of a
+// request reports on it. One dropped without record() counts as a local
+// failure; otherwise a probe that bailed out early would hold a half-open
+// breaker until the probe timeout.
+class Admission {
+public:
+    Admission(std::string host, Millis maxWait);
+    ~Admission();
+
+    Admission(const Admission&) = delete;
+    Admission& operator=(const Admission&) = delete;
+
+    // Whether the request may go out
+    explicit operator bool() const { return admitted_; }
+
+    // effectiveHost is where redirects led (empty: nowhere). The result
+    // is that host's; the admitted one answered with the redirect.
+    void record(ErrorClass cls, Millis retryAfter = Millis(0),
+                const std::string& effectiveHost = "");
+
+private:
+    std::string host_;
+    bool admitted_;
+    bool pending_;
+};
+
+// How long the host asked this thread to wait: the Retry-After passed to
+// its last record(), or if admit() last turned it away, the time until
+// the breaker lets requests through again. For callers that schedule
+// their own retries (as a floor for Backoff::next).
+Millis lastRetryAfter();
+
+} // namespace RetryPolicy
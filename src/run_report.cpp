@@ -0,0 +1,453 @@
+#include "run_report.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace RunReport {
+
+namespace {
+
+const char* const kStageNames[] = {"extractSeconds", "fomodSeconds", "placeSeconds"};
+
+struct ModRecord {
+    std::string name;
+    int phase = 0;
+
+    int downloadAttempts = 0;
+    std::string source;
+    double downloadStart = 0, downloadEnd = 0;
+    double downloadSeconds = 0;  // Time spent downloading, not waiting to retry
+    uint64_t bytes = 0;
+    std::string downloadFailure;
+
+    int installAttempts = 0;
+    double installStart = 0, installEnd = 0;
+    double installSeconds = 0;
+    uint64_t installBytes = 0;   // Placed in the mod folder, over all attempts
+    bool installed = false;
+    std::string installFailure;
+    double stages[3] = {0, 0, 0};
+};
+
+struct PhaseRecord {
+    std::string name;
+    double start = 0;
+    double end = -1;
+};
+
+std::mutex g_mutex;
+Clock::time_point g_start = Clock::now();
+std::time_t g_startedAt = 0;
+std::string g_collection;
+unsigned g_threads = 1;
+std::vector<PhaseRecord> g_phases;
+std::map<size_t, ModRecord> g_mods;
+
+double since(Clock::time_point t) {
+    return std::chrono::duration<double>(t - g_start).count();
+}
+
+double seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+double round3(double v) {
+    return std::round(v * 1000.0) / 1000.0;
+}
+
+std::string formatSeconds(double s) {
+    char buffer[32];
+    if (s < 60) {
+        std::snprintf(buffer, sizeof(buffer), "%.1fs", s);
+    } else if (s < 3600) {
+        std::snprintf(buffer, sizeof(buffer), "%dm %02ds", static_cast<int>(s) / 60, static_cast<int>(s) % 60);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%dh %02dm", static_cast<int>(s) / 3600, static_cast<int>(s) / 60 % 60);
+    }
+    return buffer;
+}
+
+double mbPerSecond(uint64_t bytes, double seconds) {
+    return bytes / (1024.0 * 1024.0) / seconds;
+}
+
+std::string formatRate(double mbPerSecond) {
+    char buffer[32];
+    if (mbPerSecond < 0.1) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f KB/s", mbPerSecond * 1024.0);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.1f MB/s", mbPerSecond);
+    }
+    return buffer;
+}
+
+std::string formatDelta(double before, double after) {
+    double delta = after - before;
+    std::string text = (delta >= 0 ? "+" : "-") + formatSeconds(std::fabs(delta));
+    if (before > 0.05) {
+        char percent[32];
+        std::snprintf(percent, sizeof(percent), ", %+.0f%%", delta * 100.0 / before);
+        text += percent;
+    }
+    return text;
+}
+
+// The mod that finished a span last, and how it spent the span: a long
+// own duration means one slow mod set the pace, a long wait means it
+// queued behind everything else
+json critical(const std::vector<const ModRecord*>& mods, bool downloads, double spanStart) {
+    const ModRecord* last = nullptr;
+    for (const ModRecord* mod : mods) {
+        double end = downloads ? mod->downloadEnd : mod->installEnd;
+        if (!last || end > (downloads ? last->downloadEnd : last->installEnd)) last = mod;
+    }
+    if (!last) return nullptr;
+    double start = downloads ? last->downloadStart : last->installStart;
+    return json{{"mod", last->name},
+                {"seconds", round3(downloads ? last->downloadSeconds : last->installSeconds)},
+                {"waitedSeconds", round3(std::max(0.0, start - spanStart))}};
+}
+
+json spanOf(const std::string& name, const std::vector<const ModRecord*>& mods, bool downloads,
+            double start, double end) {
+    double busy = 0;
+    uint64_t bytes = 0;
+    for (const ModRecord* mod : mods) {
+        busy += downloads ? mod->downloadSeconds : mod->installSeconds;
+        bytes += downloads ? mod->bytes : mod->installBytes;
+    }
+    double length = std::max(0.0, end - start);
+    json span{{"name", name},
+              {"start", round3(start)},
+              {"seconds", round3(length)},
+              {"busySeconds", round3(busy)},
+              {"bytes", bytes}};
+    if (length >= 1.0) span["utilization"] = round3(busy / (length * std::max(1u, g_threads)));
+    if (length > 0 && bytes > 0) span["mbPerSecond"] = round3(mbPerSecond(bytes, length));
+    if (!mods.empty()) span["critical"] = critical(mods, downloads, start);
+    return span;
+}
+
+double modTotal(const json& mod) {
+    double total = 0;
+    if (mod.contains("download")) total += mod["download"].value("seconds", 0.0);
+    if (mod.contains("install")) total += mod["install"].value("seconds", 0.0);
+    return total;
+}
+
+} // namespace
+
+void start(const std::string& collection, unsigned threads) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_start = Clock::now();
+    g_startedAt = std::time(nullptr);
+    g_collection = collection;
+    g_threads = threads;
+    g_phases.clear();
+    g_mods.clear();
+}
+
+void beginPhase(const std::string& name) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_phases.push_back({name, since(Clock::now()), -1});
+}
+
+void endPhase(const std::string& name) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto it = g_phases.rbegin(); it != g_phases.rend(); ++it) {
+        if (it->name == name && it->end < 0) {
+            it->end = since(Clock::now());
+            return;
+        }
+    }
+}
+
+void describeMod(size_t mod, const std::string& name, int phase) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ModRecord& record = g_mods[mod];
+    record.name = name;
+    record.phase = phase;
+}
+
+void downloadAttempt(size_t mod, const std::string& source, Clock::time_point started,
+                     Clock::time_point finished, uint64_t bytes, const std::string& failure) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ModRecord& record = g_mods[mod];
+    if (record.downloadAttempts++ == 0) record.downloadStart = since(started);
+    record.downloadEnd = since(finished);
+    record.downloadSeconds += seconds(finished - started);
+    record.source = source;
+    record.bytes = bytes;
+    record.downloadFailure = failure;
+}
+
+void installAttempt(size_t mod, Clock::time_point started, Clock::time_point finished, bool ok,
+                    uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ModRecord& record = g_mods[mod];
+    if (record.installAttempts++ == 0) record.installStart = since(started);
+    record.installEnd = since(finished);
+    record.installSeconds += seconds(finished - started);
+    record.installBytes += bytes;
+    // A stalled attempt can report after its retry did
+    record.installed = record.installed || ok;
+    if (ok) record.installFailure.clear();
+}
+
+void installFailed(size_t mod, const std::string& why) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_mods[mod].installFailure = why;
+}
+
+void addStage(size_t mod, Stage stage, Clock::duration spent) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_mods[mod].stages[static_cast<int>(stage)] += seconds(spent);
+}
+
+json toJson() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    double now = since(Clock::now());
+
+    char startedAt[32] = "";
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &g_startedAt);
+#else
+    localtime_r(&g_startedAt, &local);
+#endif
+    std::strftime(startedAt, sizeof(startedAt), "%Y-%m-%d %H:%M:%S", &local);
+
+    json report{{"version", 1},
+                {"collection", g_collection},
+                {"startedAt", startedAt},
+                {"threads", g_threads},
+                {"wallSeconds", round3(now)}};
+
+    std::vector<const ModRecord*> downloads, installs;
+    std::map<int, std::vector<const ModRecord*>> byCollectionPhase;
+    json mods = json::array();
+    for (const auto& [index, record] : g_mods) {
+        json mod{{"index", index}, {"name", record.name}, {"phase", record.phase}};
+        if (record.downloadAttempts > 0) {
+            downloads.push_back(&record);
+            json download{{"source", record.source},
+                          {"attempts", record.downloadAttempts},
+                          {"start", round3(record.downloadStart)},
+                          {"end", round3(record.downloadEnd)},
+                          {"seconds", round3(record.downloadSeconds)},
+                          {"bytes", record.bytes}};
+            if (record.downloadSeconds > 0 && record.bytes > 0) {
+                download["mbPerSecond"] = round3(mbPerSecond(record.bytes, record.downloadSeconds));
+            }
+            if (!record.downloadFailure.empty()) download["failure"] = record.downloadFailure;
+            mod["download"] = download;
+        }
+        if (record.installAttempts > 0) {
+            installs.push_back(&record);
+            byCollectionPhase[record.phase].push_back(&record);
+            json install{{"result", record.installed ? "installed" : "failed"},
+                         {"attempts", record.installAttempts},
+                         {"start", round3(record.installStart)},
+                         {"end", round3(record.installEnd)},
+                         {"seconds", round3(record.installSeconds)},
+                         {"bytes", record.installBytes}};
+            if (record.installSeconds > 0 && record.installBytes > 0) {
+                install["mbPerSecond"] = round3(mbPerSecond(record.installBytes, record.installSeconds));
+            }
+            for (int s = 0; s < 3; ++s) install[kStageNames[s]] = round3(record.stages[s]);
+            if (!record.installFailure.empty()) install["failure"] = record.installFailure;
+            mod["install"] = install;
+        }
+        mods.push_back(std::move(mod));
+    }
+
+    json phases = json::array();
+    for (const PhaseRecord& phase : g_phases) {
+        double end = phase.end < 0 ? now : phase.end;
+        if (phase.name == "download") {
+            phases.push_back(spanOf(phase.name, downloads, true, phase.start, end));
+        } else if (phase.name == "install") {
+            phases.push_back(spanOf(phase.name, installs, false, phase.start, end));
+        } else {
+            phases.push_back(json{{"name", phase.name},
+                                  {"start", round3(phase.start)},
+                                  {"seconds", round3(end - phase.start)}});
+        }
+    }
+
+    // Collection phases run one after another, so each one's last mod is a
+    // link in the install's critical path
+    json collectionPhases = json::array();
+    for (const auto& [number, members] : byCollectionPhase) {
+        double start = members.front()->installStart, end = 0;
+        for (const ModRecord* mod : members) {
+            start = std::min(start, mod->installStart);
+            end = std::max(end, mod->installEnd);
+        }
+        json span = spanOf("phase " + std::to_string(number), members, false, start, end);
+        span["phase"] = number;
+        span["mods"] = members.size();
+        collectionPhases.push_back(std::move(span));
+    }
+
+    report["phases"] = std::move(phases);
+    report["collectionPhases"] = std::move(collectionPhases);
+    report["mods"] = std::move(mods);
+    return report;
+}
+
+std::string digest(const json& report, const json& previous, size_t topN) {
+    std::ostringstream out;
+    out << "=== Run Report ===" << "\n";
+    out << "  Total time " << formatSeconds(report.value("wallSeconds", 0.0)) << " on "
+        << report.value("threads", 1) << " threads" << "\n";
+
+    auto describeSpan = [&](const json& span) {
+        out << "    " << span.value("name", "") << ": " << formatSeconds(span.value("seconds", 0.0));
+        if (span.contains("utilization")) {
+            out << ", threads " << static_cast<int>(span["utilization"].get<double>() * 100) << "% busy";
+        }
+        if (span.contains("mbPerSecond")) out << ", " << formatRate(span["mbPerSecond"].get<double>());
+        if (span.contains("critical") && span["critical"].is_object()) {
+            const json& c = span["critical"];
+            out << "; last to finish " << c.value("mod", "") << " (" << formatSeconds(c.value("seconds", 0.0))
+                << " of work after " << formatSeconds(c.value("waitedSeconds", 0.0)) << " queued)";
+        }
+        out << "\n";
+    };
+    out << "  Phases:" << "\n";
+    for (const json& span : report["phases"]) describeSpan(span);
+    if (report["collectionPhases"].size() > 1) {
+        out << "  Collection install phases:" << "\n";
+        for (const json& span : report["collectionPhases"]) describeSpan(span);
+    }
+
+    std::vector<const json*> mods;
+    for (const json& mod : report["mods"]) mods.push_back(&mod);
+    std::sort(mods.begin(), mods.end(),
+              [](const json* a, const json* b) { return modTotal(*a) > modTotal(*b); });
+    if (!mods.empty() && modTotal(*mods.front()) > 0) {
+        out << "  Slowest mods:" << "\n";
+        for (size_t i = 0; i < std::min(topN, mods.size()) && modTotal(*mods[i]) > 0; ++i) {
+            const json& mod = *mods[i];
+            out << "    " << formatSeconds(modTotal(mod)) << "  " << mod.value("name", "") << " (";
+            const char* separator = "";
+            if (mod.contains("download")) {
+                const json& d = mod["download"];
+                out << "download " << formatSeconds(d.value("seconds", 0.0));
+                if (d.contains("mbPerSecond")) out << " at " << formatRate(d["mbPerSecond"].get<double>());
+                if (d.value("attempts", 1) > 1) out << ", " << d.value("attempts", 1) << " attempts";
+                separator = "; ";
+            }
+            if (mod.contains("install")) {
+                const json& in = mod["install"];
+                out << separator << "install " << formatSeconds(in.value("seconds", 0.0));
+                if (in.contains("mbPerSecond")) out << " at " << formatRate(in["mbPerSecond"].get<double>());
+                for (const char* stage : kStageNames) {
+                    double spent = in.value(stage, 0.0);
+                    if (spent < 0.05) continue;
+                    std::string name(stage, std::strlen(stage) - std::strlen("Seconds"));
+                    out << ", " << name << " " << formatSeconds(spent);
+                }
+                if (in.value("attempts", 1) > 1) out << ", " << in.value("attempts", 1) << " attempts";
+            }
+            out << ")" << "\n";
+        }
+    }
+
+    std::vector<std::string> problems;
+    for (const json& mod : report["mods"]) {
+        for (const char* part : {"download", "install"}) {
+            if (mod.contains(part) && mod[part].contains("failure")) {
+                problems.push_back(mod.value("name", "") + " (" + part + ": " +
+                                   mod[part]["failure"].get<std::string>() + ")");
+            }
+        }
+    }
+    if (!problems.empty()) {
+        out << "  Problems:" << "\n";
+        for (const std::string& problem : problems) out << "    " << problem << "\n";
+    }
+
+    if (!previous.is_object()) return out.str();
+
+    out << "  Compared with the run of " << previous.value("startedAt", "?") << ":" << "\n";
+    double wallBefore = previous.value("wallSeconds", 0.0), wallNow = report.value("wallSeconds", 0.0);
+    out << "    total " << formatSeconds(wallBefore) << " -> " << formatSeconds(wallNow) << " ("
+        << formatDelta(wallBefore, wallNow) << ")" << "\n";
+    std::map<std::string, json> phasesBefore;
+    for (const json& span : previous.value("phases", json::array())) {
+        phasesBefore[span.value("name", "")] = span;
+    }
+    for (const json& span : report["phases"]) {
+        auto it = phasesBefore.find(span.value("name", ""));
+        if (it == phasesBefore.end()) continue;
+        const json& before = it->second;
+        double then = before.value("seconds", 0.0), now = span.value("seconds", 0.0);
+        out << "    " << it->first << " " << formatSeconds(then) << " -> " << formatSeconds(now) << " ("
+            << formatDelta(then, now) << ")";
+        // Throughput tells a slower phase that moved more data from one
+        // that actually got slower
+        if (before.contains("mbPerSecond") && span.contains("mbPerSecond")) {
+            out << ", " << formatRate(before["mbPerSecond"].get<double>()) << " -> "
+                << formatRate(span["mbPerSecond"].get<double>());
+        }
+        out << "\n";
+    }
+
+    // Mods that got noticeably slower (only ones that did work both times:
+    // a mod skipped as already installed isn't faster)
+    std::map<std::string, double> modsBefore;
+    for (const json& mod : previous.value("mods", json::array())) {
+        if (modTotal(mod) > 0) modsBefore[mod.value("name", "")] = modTotal(mod);
+    }
+    std::vector<std::pair<double, std::string>> slower;
+    for (const json& mod : report["mods"]) {
+        auto it = modsBefore.find(mod.value("name", ""));
+        double now = modTotal(mod);
+        if (it == modsBefore.end() || now <= 0) continue;
+        if (now - it->second >= 1.0 && now >= it->second * 1.2) {
+            slower.push_back({now - it->second, it->first + " " + formatSeconds(it->second) + " -> " +
+                                                    formatSeconds(now)});
+        }
+    }
+    std::sort(slower.begin(), slower.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    if (!slower.empty()) {
+        out << "    Slower mods:" << "\n";
+        for (size_t i = 0; i < std::min(topN, slower.size()); ++i) {
+            out << "      " << slower[i].second << "\n";
+        }
+    }
+    return out.str();
+}
+
+std::string save(const fs::path& dir, size_t topN) {
+    json report = toJson();
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    fs::path last = dir / "last_run.json";
+    json previous;
+    {
+        std::ifstream in(last);
+        if (in) previous = json::parse(in, nullptr, false);
+        if (previous.is_discarded()) previous = nullptr;
+    }
+    if (!previous.is_null()) fs::rename(last, dir / "previous_run.json", ec);
+
+    std::string text = digest(report, previous, topN);
+    std::ofstream(last) << report.dump(2, ' ', false, json::error_handler_t::replace) << "\n";
+    std::ofstream(dir / "last_run.txt") << text;
+    return text;
+}
+
+} // namespace RunReport
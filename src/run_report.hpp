@@ -0,0 +1,78 @@
+#pragma once
+
+// Timings for one install run: where each mod's time went (download,
+// extraction, FOMOD, file placement), how long each run phase took and
+// what held it up, and how that compares with the previous run.
+//
+// Everything is recorded from the worker threads into one process-wide
+// report. save() writes it as JSON next to the previous run's report and
+// returns a readable digest.
+
+#include "../include/nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace RunReport {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Stage { Extract, Fomod, Place };
+
+// Starts the run clock
+void start(const std::string& collection, unsigned threads);
+
+// Run phases ("scan", "download", "install", ...), in order
+void beginPhase(const std::string& name);
+void endPhase(const std::string& name);
+
+void describeMod(size_t mod, const std::string& name, int phase);
+
+// One download attempt. source is where it came from ("nexus", "direct",
+// "peer"); failure is empty if it succeeded.
+void downloadAttempt(size_t mod, const std::string& source, Clock::time_point started,
+                     Clock::time_point finished, uint64_t bytes, const std::string& failure = "");
+
+// One install attempt (installMod call); bytes is what it put into the
+// mod folder
+void installAttempt(size_t mod, Clock::time_point started, Clock::time_point finished, bool ok,
+                    uint64_t bytes = 0);
+void installFailed(size_t mod, const std::string& why);
+
+void addStage(size_t mod, Stage stage, Clock::duration spent);
+
+// Times a stage of installMod until stop() or the end of the scope
+class StageTimer {
+public:
+    StageTimer(size_t mod, Stage stage) : mod_(mod), stage_(stage), started_(Clock::now()) {}
+    ~StageTimer() { stop(); }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    void stop() {
+        if (stopped_) return;
+        stopped_ = true;
+        addStage(mod_, stage_, Clock::now() - started_);
+    }
+
+private:
+    size_t mod_;
+    Stage stage_;
+    Clock::time_point started_;
+    bool stopped_ = false;
+};
+
+nlohmann::json toJson();
+
+// Readable summary of report: phases with their critical path, the topN
+// slowest mods, and changes since previous (null if there's none)
+std::string digest(const nlohmann::json& report, const nlohmann::json& previous, size_t topN);
+
+// Writes dir/last_run.json (the one it replaces becomes previous_run.json)
+// and dir/last_run.txt. Returns the digest.
+std::string save(const fs::path& dir, size_t topN = 5);
+
+} // namespace RunReport
@@ -0,0 +1,452 @@
+#include "subprocess.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace Subprocess {
+
+namespace {
+
+// One output stream: keeps the first `limit` bytes and hands complete
+// lines to onLine
+class Sink {
+public:
+    Sink(std::string& target, size_t limit, const std::function<void(const std::string&)>* onLine)
+        : target_(target), limit_(limit), onLine_(onLine) {}
+
+    void append(const char* data, size_t len) {
+        if (target_.size() < limit_) {
+            target_.append(data, std::min(len, limit_ - target_.size()));
+        }
+        if (!onLine_) return;
+        for (size_t i = 0; i < len; ++i) {
+            if (data[i] == '\n') {
+                if (!pending_.empty() && pending_.back() == '\r') pending_.pop_back();
+                (*onLine_)(pending_);
+                pending_.clear();
+            } else {
+                pending_.push_back(data[i]);
+            }
+        }
+    }
+
+    void finish() {
+        if (onLine_ && !pending_.empty()) {
+            (*onLine_)(pending_);
+            pending_.clear();
+        }
+    }
+
+private:
+    std::string& target_;
+    size_t limit_;
+    const std::function<void(const std::string&)>* onLine_;
+    std::string pending_;
+};
+
+std::mutex g_runningMutex;
+std::set<long> g_running;
+
+// Lists a child in running() for as long as it's waited for
+class RunningEntry {
+public:
+    explicit RunningEntry(long pid) : pid_(pid) {
+        std::lock_guard<std::mutex> lock(g_runningMutex);
+        g_running.insert(pid_);
+    }
+    ~RunningEntry() {
+        std::lock_guard<std::mutex> lock(g_runningMutex);
+        g_running.erase(pid_);
+    }
+    RunningEntry(const RunningEntry&) = delete;
+    RunningEntry& operator=(const RunningEntry&) = delete;
+
+private:
+    long pid_;
+};
+
+} // namespace
+
+std::vector<long> running() {
+    std::lock_guard<std::mutex> lock(g_runningMutex);
+    return std::vector<long>(g_running.begin(), g_running.end());
+}
+
+std::string Result::describe() const {
+    if (!started) return "could not start: " + spawnError;
+    if (timedOut) return "timed out";
+    if (cancelled) return "cancelled";
+    if (signal != 0) return "killed by signal " + std::to_string(signal);
+    return "exit code " + std::to_string(exitCode);
+}
+
+std::string displayCommand(const std::vector<std::string>& argv) {
+    std::string line;
+    for (const auto& arg : argv) {
+        if (!line.empty()) line += ' ';
+        if (arg.empty() || arg.find_first_of(" \t\"") != std::string::npos) {
+            line += '"' + arg + '"';
+        } else {
+            line += arg;
+        }
+    }
+    return line;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+bool makePipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+void closeFd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace
+
+Result run(const std::vector<std::string>& argv, const Options& options) {
+    Result result;
+    if (argv.empty()) {
+        result.spawnError = "empty command";
+        return result;
+    }
+
+    const bool wantOut = options.captureStdout || options.onLine;
+    const bool wantErr = options.captureStderr && !options.mergeStderr;
+
+    // Pipes are close-on-exec so children spawned by other threads at the
+    // same time don't inherit them (and hold our EOF hostage)
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    if ((wantOut && !makePipe(outPipe)) || (wantErr && !makePipe(errPipe))) {
+        result.spawnError = std::strerror(errno);
+        closeFd(outPipe[0]);
+        closeFd(outPipe[1]);
+        return result;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+    if (wantOut) posix_spawn_file_actions_adddup2(&actions, outPipe[1], 1);
+    else posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    if (options.mergeStderr) posix_spawn_file_actions_adddup2(&actions, 1, 2);
+    else if (wantErr) posix_spawn_file_actions_adddup2(&actions, errPipe[1], 2);
+    else posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+    // Own process group, so a timeout can take down anything it started;
+    // default SIGPIPE (libcurl may have us ignoring it)
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |
+                                        POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(&attr, 0);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+    args.push_back(nullptr);
+
+    pid_t pid = -1;
+    int spawnResult = posix_spawnp(&pid, args[0], &actions, &attr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    closeFd(outPipe[1]);
+    closeFd(errPipe[1]);
+
+    if (spawnResult != 0) {
+        result.spawnError = std::strerror(spawnResult);
+        closeFd(outPipe[0]);
+        closeFd(errPipe[0]);
+        return result;
+    }
+    result.started = true;
+    RunningEntry listed(pid);
+
+    const bool hasDeadline = options.timeout.count() > 0;
+    const auto deadline = std::chrono::steady_clock::now() + options.timeout;
+    // Kills the process group if the deadline passed or the caller gave up
+    auto shouldStop = [&]() {
+        if (hasDeadline && std::chrono::steady_clock::now() >= deadline) result.timedOut = true;
+        else if (options.cancelled && options.cancelled()) result.cancelled = true;
+        else return false;
+        kill(-pid, SIGKILL);
+        return true;
+    };
+    const bool polling = hasDeadline || options.cancelled;
+
+    Sink outSink(result.out, options.captureLimit, options.onLine ? &options.onLine : nullptr);
+    Sink errSink(result.err, options.captureLimit, nullptr);
+    int& outFd = outPipe[0];
+    int& errFd = errPipe[0];
+    char buffer[16 * 1024];
+
+    bool stopped = false;
+    while ((outFd >= 0 || errFd >= 0) && !stopped) {
+        pollfd fds[2];
+        nfds_t count = 0;
+        if (outFd >= 0) fds[count++] = {outFd, POLLIN, 0};
+        if (errFd >= 0) fds[count++] = {errFd, POLLIN, 0};
+
+        if (shouldStop()) {
+            stopped = true;
+            break;
+        }
+        int waitMs = -1;
+        if (hasDeadline) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            waitMs = static_cast<int>(std::min<long long>(left.count() + 1, 60 * 1000));
+        }
+        if (options.cancelled && (waitMs < 0 || waitMs > 200)) waitMs = 200;
+
+        int ready = poll(fds, count, waitMs);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+
+        for (nfds_t i = 0; i < count; ++i) {
+            if (fds[i].revents == 0) continue;
+            bool isOut = fds[i].fd == outFd;
+            ssize_t got = read(fds[i].fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                (isOut ? outSink : errSink).append(buffer, static_cast<size_t>(got));
+            } else if (got == 0 || (errno != EINTR && errno != EAGAIN)) {
+                closeFd(isOut ? outFd : errFd);
+            }
+        }
+    }
+    closeFd(outFd);
+    closeFd(errFd);
+    outSink.finish();
+
+    // The process can outlive its pipes; the deadline still applies
+    int status = 0;
+    while (true) {
+        pid_t waited = waitpid(pid, &status, polling && !stopped ? WNOHANG : 0);
+        if (waited == pid) break;
+        if (waited < 0) {
+            if (errno == EINTR) continue;
+            status = -1;
+            break;
+        }
+        if (shouldStop()) {
+            stopped = true;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    if (status != -1) {
+        if (WIFEXITED(status)) result.exitCode = WEXITSTATUS(status);
+        else if (WIFSIGNALED(status)) result.signal = WTERMSIG(status);
+    }
+    return result;
+}
+
+#else
+
+namespace {
+
+// Quote one argument the way CommandLineToArgvW / the MSVC runtime split it
+std::string quoteArgument(const std::string& arg) {
+    if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) return arg;
+    std::string quoted = "\"";
+    size_t backslashes = 0;
+    for (char c : arg) {
+        if (c == '\\') {
+            ++backslashes;
+        } else if (c == '"') {
+            quoted.append(backslashes * 2 + 1, '\\');
+            quoted.push_back('"');
+            backslashes = 0;
+        } else {
+            quoted.append(backslashes, '\\');
+            quoted.push_back(c);
+            backslashes = 0;
+        }
+    }
+    quoted.append(backslashes * 2, '\\');
+    quoted.push_back('"');
+    return quoted;
+}
+
+void closeHandle(HANDLE& handle) {
+    if (handle) {
+        CloseHandle(handle);
+        handle = nullptr;
+    }
+}
+
+void drain(HANDLE pipe, Sink& sink) {
+    char buffer[16 * 1024];
+    DWORD got = 0;
+    while (ReadFile(pipe, buffer, sizeof(buffer), &got, nullptr) && got > 0) {
+        sink.append(buffer, got);
+    }
+}
+
+} // namespace
+
+Result run(const std::vector<std::string>& argv, const Options& options) {
+    Result result;
+    if (argv.empty()) {
+        result.spawnError = "empty command";
+        return result;
+    }
+
+    const bool wantOut = options.captureStdout || options.onLine;
+    const bool wantErr = options.captureStderr && !options.mergeStderr;
+
+    SECURITY_ATTRIBUTES inheritable{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE nul = CreateFileA("NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             &inheritable, OPEN_EXISTING, 0, nullptr);
+    HANDLE outRead = nullptr, outWrite = nullptr, errRead = nullptr, errWrite = nullptr;
+    if (wantOut && CreatePipe(&outRead, &outWrite, &inheritable, 0)) {
+        SetHandleInformation(outRead, HANDLE_FLAG_INHERIT, 0);
+    }
+    if (wantErr && CreatePipe(&errRead, &errWrite, &inheritable, 0)) {
+        SetHandleInformation(errRead, HANDLE_FLAG_INHERIT, 0);
+    }
+
+    STARTUPINFOEXA startup{};
+    startup.StartupInfo.cb = sizeof(startup);
+    startup.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+    startup.StartupInfo.hStdInput = nul;
+    startup.StartupInfo.hStdOutput = outWrite ? outWrite : nul;
+    startup.StartupInfo.hStdError = options.mergeStderr ? startup.StartupInfo.hStdOutput
+                                                        : (errWrite ? errWrite : nul);
+
+    // Hand the child only its own handles, not pipes other threads are
+    // creating for their children at the same moment
+    std::vector<HANDLE> inherit = {nul};
+    if (outWrite) inherit.push_back(outWrite);
+    if (errWrite) inherit.push_back(errWrite);
+    SIZE_T attrSize = 0;
+    InitializeProcThreadAttributeList(nullptr, 1, 0, &attrSize);
+    std::vector<char> attrBuffer(attrSize);
+    auto attrList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attrBuffer.data());
+    InitializeProcThreadAttributeList(attrList, 1, 0, &attrSize);
+    UpdateProcThreadAttribute(attrList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inherit.data(),
+                              inherit.size() * sizeof(HANDLE), nullptr, nullptr);
+    startup.lpAttributeList = attrList;
+
+    // A job object is the Windows process group: closing it kills the tree
+    HANDLE job = CreateJobObjectA(nullptr, nullptr);
+    if (job) {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+        limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+        SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+    }
+
+    std::string commandLine;
+    for (const auto& arg : argv) {
+        if (!commandLine.empty()) commandLine += ' ';
+        commandLine += quoteArgument(arg);
+    }
+
+    PROCESS_INFORMATION process{};
+    BOOL created = CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE,
+                                  EXTENDED_STARTUPINFO_PRESENT | CREATE_NO_WINDOW | CREATE_SUSPENDED,
+                                  nullptr, nullptr, &startup.StartupInfo, &process);
+    DWORD createError = GetLastError();
+    DeleteProcThreadAttributeList(attrList);
+    closeHandle(nul);
+    closeHandle(outWrite);
+    closeHandle(errWrite);
+
+    if (!created) {
+        result.spawnError = "CreateProcess failed (error " + std::to_string(createError) + ")";
+        closeHandle(outRead);
+        closeHandle(errRead);
+        closeHandle(job);
+        return result;
+    }
+    result.started = true;
+    RunningEntry listed(static_cast<long>(process.dwProcessId));
+    if (job) AssignProcessToJobObject(job, process.hProcess);
+    ResumeThread(process.hThread);
+    CloseHandle(process.hThread);
+
+    // Timeout or cancel: kill the job, which also breaks the pipes we're reading
+    std::atomic<bool> timedOut{false};
+    std::atomic<bool> cancelled{false};
+    std::thread watchdog;
+    if (options.timeout.count() > 0 || options.cancelled) {
+        watchdog = std::thread([&]() {
+            const bool hasDeadline = options.timeout.count() > 0;
+            const auto deadline = std::chrono::steady_clock::now() + options.timeout;
+            while (WaitForSingleObject(process.hProcess, 200) == WAIT_TIMEOUT) {
+                if (hasDeadline && std::chrono::steady_clock::now() >= deadline) timedOut = true;
+                else if (options.cancelled && options.cancelled()) cancelled = true;
+                else continue;
+                if (job) TerminateJobObject(job, 1);
+                else TerminateProcess(process.hProcess, 1);
+                break;
+            }
+        });
+    }
+
+    Sink outSink(result.out, options.captureLimit, options.onLine ? &options.onLine : nullptr);
+    Sink errSink(result.err, options.captureLimit, nullptr);
+    std::thread errReader;
+    if (errRead) errReader = std::thread([&]() { drain(errRead, errSink); });
+    if (outRead) drain(outRead, outSink);
+    outSink.finish();
+
+    WaitForSingleObject(process.hProcess, INFINITE);
+    if (errReader.joinable()) errReader.join();
+    if (watchdog.joinable()) watchdog.join();
+
+    DWORD exitCode = 0;
+    GetExitCodeProcess(process.hProcess, &exitCode);
+    result.exitCode = static_cast<int>(exitCode);
+    result.timedOut = timedOut;
+    result.cancelled = cancelled;
+
+    CloseHandle(process.hProcess);
+    closeHandle(outRead);
+    closeHandle(errRead);
+    closeHandle(job);
+    return result;
+}
+
+#endif
+
+} // namespace Subprocess
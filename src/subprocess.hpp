@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Subprocess {
+
+struct Options {
+    // Streams that aren't captured go to /dev/null (NUL on Windows)
+    bool captureStdout = false;
+    bool captureStderr = true;
+    // Send stderr into the stdout stream (like 2>&1)
+    bool mergeStderr = false;
+    // Bytes kept per stream; output beyond this is read and dropped
+    size_t captureLimit = 64 * 1024;
+    // Called with each stdout line (without the newline) as it arrives.
+    // Setting this captures stdout.
+    std::function<void(const std::string&)> onLine;
+    // Kill the process and everything it started after this long (0 = never)
+    std::chrono::milliseconds timeout{0};
+    // Polled a few times a second; returning true kills the process the
+    // same way a timeout does
+    std::function<bool()> cancelled;
+};
+
+struct Result {
+    bool started = false;   // false: the program couldn't be run at all
+    int exitCode = -1;      // Valid when the process exited normally
+    int signal = 0;         // POSIX: signal that ended the process
+    bool timedOut = false;
+    bool cancelled = false;
+    std::string out;
+    std::string err;
+    std::string spawnError; // Why it couldn't be started
+
+    bool ok() const { return started && !timedOut && !cancelled && signal == 0 && exitCode == 0; }
+
+    // One-line reason for a failure ("exit code 2", "killed by signal 9", ...)
+    std::string describe() const;
+};
+
+// Run argv[0] (searched on PATH when it has no directory part) with the
+// given arguments. No shell is involved, so arguments need no quoting.
+// stdin is always /dev/null. Blocks until the process exits or times out.
+Result run(const std::vector<std::string>& argv, const Options& options = {});
+
+// Process ids of the children run() is currently waiting for, so their
+// scheduling can be changed while they run (see BackgroundQos)
+std::vector<long> running();
+
+// argv joined for log output (arguments with spaces are quoted)
+std::string displayCommand(const std::vector<std::string>& argv);
+
+} // namespace Subprocess
@@ -2,6 +2,7 @@
 #include "xml.h"
 #include "fomod.cpp"
 #include "installer.cpp"
+#include "subprocess.cpp"
 #include <iostream>
 
 int main() {
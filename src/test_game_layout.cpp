@@ -0,0 +1,98 @@
+#include "game_layout.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Checks the compile-time Skyrim tables against the std::unordered_set
+// lookups they replaced, on names built from the table entries themselves
+// (so hits, near misses and mixed case all come up often) plus random noise.
+// Build: g++ -std=c++17 -O2 test_game_layout.cpp -o test_game_layout
+
+static bool oldIsDataFolder(const std::string &name) {
+    static const std::unordered_set<std::string_view> dataFolders = {
+        "meshes",       "textures",
+        "scripts",      "sound",
+        "interface",    "strings",
+        "seq",          "grass",
+        "video",        "music",
+        "shaders",      "shadersfx",    "lodsettings",
+        "skse",         "netscriptframework",
+        "edit scripts", "dialogueviews",
+        "facegen",      "caliente tools",
+        "actors",       "fonts",
+        "materials",    "platform",
+        "source",       "terrain",
+        "trees",        "vis",
+        "distantlod",   "lod",
+        "dyndolod",     "nemesis_engine"};
+
+    return dataFolders.count(CaseFold::Folded(name).view()) > 0;
+}
+
+static bool oldIsJunkFile(const std::string &name) {
+    CaseFold::Folded folded(name);
+    std::string_view lower = folded.view();
+
+    static const std::unordered_set<std::string_view> junkExts = {
+        ".txt", ".md",  ".pdf", ".doc",  ".docx", ".rtf", ".url",
+        ".ini", ".png", ".jpg", ".jpeg", ".bmp",  ".gif"};
+    static const std::string_view junkNames[] = {
+        "readme",  "license", "changelog",   "credits",
+        "authors", "install", "instructions"};
+
+    size_t dotPos = lower.find_last_of('.');
+    if (dotPos != std::string_view::npos && junkExts.count(lower.substr(dotPos))) return true;
+    for (const auto &junk : junkNames) {
+        if (lower.find(junk) != std::string_view::npos) return true;
+    }
+    return false;
+}
+
+int main() {
+    using namespace GameLayout;
+    const Layout &skyrim = forDomain("skyrimspecialedition");
+
+    std::vector<std::string> pieces;
+    for (std::string_view s : tables::kSkyrimFolders) pieces.emplace_back(s);
+    for (std::string_view s : tables::kJunkExtensions) pieces.emplace_back(s);
+    for (std::string_view s : tables::kJunkNames) pieces.emplace_back(s);
+    for (const char *s : {"", ".", " ", "_", "-", "Data", "esp", "x", "\xC3\xA9", "READ", "ME"}) {
+        pieces.emplace_back(s);
+    }
+
+    std::mt19937 rng(84);
+    auto pick = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+    const int kNames = 500000;
+    int mismatches = 0;
+    for (int i = 0; i < kNames; ++i) {
+        std::string name;
+        for (size_t parts = 1 + pick(3); parts > 0; --parts) {
+            std::string piece = pieces[pick(pieces.size())];
+            // Drop, change or upper-case a character now and then
+            if (!piece.empty() && pick(4) == 0) piece.erase(pick(piece.size()), 1);
+            if (!piece.empty() && pick(4) == 0) piece[pick(piece.size())] = static_cast<char>(pick(256));
+            for (char &c : piece) {
+                if (pick(3) == 0 && c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+            }
+            name += piece;
+        }
+
+        bool folderOld = oldIsDataFolder(name), folderNew = skyrim.isDataFolder(name);
+        bool junkOld = oldIsJunkFile(name), junkNew = skyrim.isJunkFile(name);
+        if (folderOld != folderNew || junkOld != junkNew) {
+            if (++mismatches <= 10) {
+                std::cerr << "Mismatch for \"" << name << "\": data folder " << folderOld << " -> "
+                          << folderNew << ", junk " << junkOld << " -> " << junkNew << std::endl;
+            }
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cerr << mismatches << " of " << kNames << " names differ" << std::endl;
+        return 1;
+    }
+    std::cout << "Game layout tables match the old lookups on " << kNames << " names" << std::endl;
+    return 0;
+}
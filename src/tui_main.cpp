@@ -9,6 +9,8 @@
 #include <ftxui/dom/elements.hpp>
 #include <ftxui/screen/screen.hpp>
 
+#include "subprocess.hpp"
+
 #include <atomic>
 #include <chrono>
 #include <filesystem>
@@ -26,8 +28,6 @@
     #include <windows.h>
     #include <io.h>
     #define PATH_MAX MAX_PATH
-    #define popen _popen
-    #define pclose _pclose
     #ifndef S_ISDIR
         #define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
     #endif
@@ -735,201 +735,191 @@ int main() {
               state.addLog("Using: " + nexusBridge);
 
               // Call NexusBridge CLI with --yes to auto-continue on failures
-              // (popen doesn't allow stdin interaction, so we auto-continue)
-#ifdef _WIN32
-              // Windows: use cmd /c to properly handle paths and redirect stderr
-              std::string cmd = "cmd /c \"\"" + nexusBridge + "\" \"" + url + "\" \"" + mo2 + "\" --yes 2>&1\"";
-#else
-              std::string cmd = "\"" + nexusBridge + "\" \"" + url + "\" \"" + mo2 + "\" --yes 2>&1";
-#endif
-              FILE* pipe = popen(cmd.c_str(), "r");
-              if (pipe) {
-                char buffer[512];
-                while (fgets(buffer, sizeof(buffer), pipe)) {
-                  std::string line(buffer);
-                  if (!line.empty() && line.back() == '\n') {
-                    line.pop_back();
-                  }
-
-                  // Parse phase changes and progress from CLI output
-                  // "Mods: 488"
-                  if (line.find("Mods:") != std::string::npos) {
-                    try {
-                      size_t pos = line.find("Mods:") + 5;
-                      state.totalMods = std::stoi(line.substr(pos));
-                    } catch (...) {}
-                  }
-
-                  // "=== Phase 1: Scanning archives ==="
-                  if (line.find("Phase 1: Scanning") != std::string::npos) {
-                    state.phase = InstallPhase::Scanning;
-                  }
-
-                  // "Need to download X archives"
-                  if (line.find("Need to download") != std::string::npos) {
-                    try {
-                      size_t pos = line.find("Need to download") + 17;
-                      size_t end = line.find(" archives");
-                      if (end != std::string::npos) {
-                        state.toDownload = std::stoi(line.substr(pos, end - pos));
-                      }
-                    } catch (...) {}
-                  }
-
-                  // "=== Phase 1b: Downloading X archives ==="
-                  if (line.find("Phase 1b: Downloading") != std::string::npos) {
-                    state.phase = InstallPhase::Downloading;
-                    // Also extract the count from "Downloading X archives with Y threads"
-                    try {
-                      size_t pos = line.find("Downloading") + 12;
-                      size_t end = line.find(" archives");
-                      if (end != std::string::npos) {
-                        state.toDownload = std::stoi(line.substr(pos, end - pos));
-                      }
-                    } catch (...) {}
-                  }
-
-                  // "[X/Y] Downloading: ModName" - individual download starts
-                  // Count these as they appear to show progress during downloading
-                  if (line.find("] Downloading:") != std::string::npos &&
-                      line.find("[") != std::string::npos &&
-                      line.find(" MB (") == std::string::npos) {
-                    // This is a "[X/Y] Downloading: ModName" line, not a progress line
-                    // Track how many downloads have started
-                    state.downloading++;
-                  }
-
-                  // "Downloaded: X, Failed: Y" - summary after all downloads complete
-                  if (line.find("Downloaded:") != std::string::npos &&
-                      line.find("Failed:") != std::string::npos) {
-                    try {
-                      size_t pos = line.find("Downloaded:") + 12;
-                      size_t end = line.find(",", pos);
-                      if (end != std::string::npos) {
-                        int dlCount = std::stoi(line.substr(pos, end - pos));
-                        state.downloaded = dlCount;
-                        state.downloading = dlCount;  // Sync downloading count too
-                      }
-                      // Also get failed count here
-                      size_t failPos = line.find("Failed:") + 8;
-                      std::string failStr = line.substr(failPos);
-                      failStr.erase(0, failStr.find_first_not_of(" \t"));
-                      int downloadFailedCount = std::stoi(failStr);
-                      if (downloadFailedCount > 0) {
-                        state.downloadFailed = downloadFailedCount;
-                      }
-                    } catch (...) {}
-                  }
-
-                  // "Downloaded: X" in final summary (without Failed: on same line)
-                  if (line.find("Downloaded:") != std::string::npos &&
-                      line.find("Failed:") == std::string::npos &&
-                      line.find(",") == std::string::npos) {
-                    try {
-                      size_t pos = line.find("Downloaded:") + 11;
-                      std::string numStr = line.substr(pos);
-                      numStr.erase(0, numStr.find_first_not_of(" \t"));
-                      size_t endPos = numStr.find_first_not_of("0123456789");
-                      if (endPos != std::string::npos) {
-                        numStr = numStr.substr(0, endPos);
-                      }
-                      int finalDownloaded = std::stoi(numStr);
-                      state.downloaded = finalDownloaded;
-                      state.downloading = finalDownloaded;
-                    } catch (...) {}
-                  }
-
-                  // "=== Phase 2: Installing X mods ==="
-                  if (line.find("Phase 2: Installing") != std::string::npos) {
-                    state.phase = InstallPhase::Installing;
-                    try {
-                      size_t pos = line.find("Installing") + 11;
-                      size_t end = line.find(" mods");
-                      if (end != std::string::npos) {
-                        state.toInstall = std::stoi(line.substr(pos, end - pos));
-                      }
-                    } catch (...) {}
-                  }
-
-                  // "[X/Y] ModName - Done!"
-                  if (line.find("] ") != std::string::npos &&
-                      line.find(" - Done!") != std::string::npos) {
-                    state.installed++;
-                  }
-
-                  // "Installed:  X" in final summary (note: two spaces)
-                  if (line.find("Installed:") != std::string::npos &&
-                      line.find("/") == std::string::npos &&  // Not a progress line
-                      line.find("Done!") == std::string::npos) {  // Not a completion line
-                    try {
-                      size_t pos = line.find("Installed:") + 10;
-                      std::string numStr = line.substr(pos);
-                      numStr.erase(0, numStr.find_first_not_of(" \t"));
-                      // Remove any trailing text
-                      size_t endPos = numStr.find_first_not_of("0123456789");
-                      if (endPos != std::string::npos) {
-                        numStr = numStr.substr(0, endPos);
-                      }
-                      int finalInstalled = std::stoi(numStr);
-                      state.installed = finalInstalled;  // Use final count from summary
-                    } catch (...) {}
-                  }
-
-                  // "Generating plugins.txt"
-                  if (line.find("Generating plugins.txt") != std::string::npos ||
-                      line.find("Generating modlist.txt") != std::string::npos) {
-                    state.phase = InstallPhase::Generating;
-                  }
-
-                  // "Skipped: X (already installed)"
-                  if (line.find("Skipped:") != std::string::npos &&
-                      line.find("already installed") != std::string::npos) {
-                    try {
-                      size_t pos = line.find("Skipped:") + 8;
-                      size_t end = line.find(" (");
-                      if (end != std::string::npos) {
-                        std::string numStr = line.substr(pos, end - pos);
-                        // Trim whitespace
-                        numStr.erase(0, numStr.find_first_not_of(" \t"));
-                        state.skipped = std::stoi(numStr);
-                      }
-                    } catch (...) {}
-                  }
-
-                  // "Failed: X" in summary
-                  if (line.find("Failed:") != std::string::npos &&
-                      line.find("Downloaded:") == std::string::npos) {
-                    try {
-                      size_t pos = line.find("Failed:") + 7;
-                      std::string numStr = line.substr(pos);
+              // (its stdin is /dev/null, so we auto-continue)
+              Subprocess::Options runOptions;
+              runOptions.mergeStderr = true;  // Same stream as stdout, in order
+              runOptions.captureLimit = 0;    // Lines go to onLine only
+              runOptions.onLine = [&](const std::string &line) {
+                // Parse phase changes and progress from CLI output
+                // "Mods: 488"
+                if (line.find("Mods:") != std::string::npos) {
+                  try {
+                    size_t pos = line.find("Mods:") + 5;
+                    state.totalMods = std::stoi(line.substr(pos));
+                  } catch (...) {}
+                }
+
+                // "=== Phase 1: Scanning archives ==="
+                if (line.find("Phase 1: Scanning") != std::string::npos) {
+                  state.phase = InstallPhase::Scanning;
+                }
+
+                // "Need to download X archives"
+                if (line.find("Need to download") != std::string::npos) {
+                  try {
+                    size_t pos = line.find("Need to download") + 17;
+                    size_t end = line.find(" archives");
+                    if (end != std::string::npos) {
+                      state.toDownload = std::stoi(line.substr(pos, end - pos));
+                    }
+                  } catch (...) {}
+                }
+
+                // "=== Phase 1b: Downloading X archives ==="
+                if (line.find("Phase 1b: Downloading") != std::string::npos) {
+                  state.phase = InstallPhase::Downloading;
+                  // Also extract the count from "Downloading X archives with Y threads"
+                  try {
+                    size_t pos = line.find("Downloading") + 12;
+                    size_t end = line.find(" archives");
+                    if (end != std::string::npos) {
+                      state.toDownload = std::stoi(line.substr(pos, end - pos));
+                    }
+                  } catch (...) {}
+                }
+
+                // "[X/Y] Downloading: ModName" - individual download starts
+                // Count these as they appear to show progress during downloading
+                if (line.find("] Downloading:") != std::string::npos &&
+                    line.find("[") != std::string::npos &&
+                    line.find(" MB (") == std::string::npos) {
+                  // This is a "[X/Y] Downloading: ModName" line, not a progress line
+                  // Track how many downloads have started
+                  state.downloading++;
+                }
+
+                // "Downloaded: X, Failed: Y" - summary after all downloads complete
+                if (line.find("Downloaded:") != std::string::npos &&
+                    line.find("Failed:") != std::string::npos) {
+                  try {
+                    size_t pos = line.find("Downloaded:") + 12;
+                    size_t end = line.find(",", pos);
+                    if (end != std::string::npos) {
+                      int dlCount = std::stoi(line.substr(pos, end - pos));
+                      state.downloaded = dlCount;
+                      state.downloading = dlCount;  // Sync downloading count too
+                    }
+                    // Also get failed count here
+                    size_t failPos = line.find("Failed:") + 8;
+                    std::string failStr = line.substr(failPos);
+                    failStr.erase(0, failStr.find_first_not_of(" \t"));
+                    int downloadFailedCount = std::stoi(failStr);
+                    if (downloadFailedCount > 0) {
+                      state.downloadFailed = downloadFailedCount;
+                    }
+                  } catch (...) {}
+                }
+
+                // "Downloaded: X" in final summary (without Failed: on same line)
+                if (line.find("Downloaded:") != std::string::npos &&
+                    line.find("Failed:") == std::string::npos &&
+                    line.find(",") == std::string::npos) {
+                  try {
+                    size_t pos = line.find("Downloaded:") + 11;
+                    std::string numStr = line.substr(pos);
+                    numStr.erase(0, numStr.find_first_not_of(" \t"));
+                    size_t endPos = numStr.find_first_not_of("0123456789");
+                    if (endPos != std::string::npos) {
+                      numStr = numStr.substr(0, endPos);
+                    }
+                    int finalDownloaded = std::stoi(numStr);
+                    state.downloaded = finalDownloaded;
+                    state.downloading = finalDownloaded;
+                  } catch (...) {}
+                }
+
+                // "=== Phase 2: Installing X mods ==="
+                if (line.find("Phase 2: Installing") != std::string::npos) {
+                  state.phase = InstallPhase::Installing;
+                  try {
+                    size_t pos = line.find("Installing") + 11;
+                    size_t end = line.find(" mods");
+                    if (end != std::string::npos) {
+                      state.toInstall = std::stoi(line.substr(pos, end - pos));
+                    }
+                  } catch (...) {}
+                }
+
+                // "[X/Y] ModName - Done!"
+                if (line.find("] ") != std::string::npos &&
+                    line.find(" - Done!") != std::string::npos) {
+                  state.installed++;
+                }
+
+                // "Installed:  X" in final summary (note: two spaces)
+                if (line.find("Installed:") != std::string::npos &&
+                    line.find("/") == std::string::npos &&  // Not a progress line
+                    line.find("Done!") == std::string::npos) {  // Not a completion line
+                  try {
+                    size_t pos = line.find("Installed:") + 10;
+                    std::string numStr = line.substr(pos);
+                    numStr.erase(0, numStr.find_first_not_of(" \t"));
+                    // Remove any trailing text
+                    size_t endPos = numStr.find_first_not_of("0123456789");
+                    if (endPos != std::string::npos) {
+                      numStr = numStr.substr(0, endPos);
+                    }
+                    int finalInstalled = std::stoi(numStr);
+                    state.installed = finalInstalled;  // Use final count from summary
+                  } catch (...) {}
+                }
+
+                // "Generating plugins.txt"
+                if (line.find("Generating plugins.txt") != std::string::npos ||
+                    line.find("Generating modlist.txt") != std::string::npos) {
+                  state.phase = InstallPhase::Generating;
+                }
+
+                // "Skipped: X (already installed)"
+                if (line.find("Skipped:") != std::string::npos &&
+                    line.find("already installed") != std::string::npos) {
+                  try {
+                    size_t pos = line.find("Skipped:") + 8;
+                    size_t end = line.find(" (");
+                    if (end != std::string::npos) {
+                      std::string numStr = line.substr(pos, end - pos);
+                      // Trim whitespace
                       numStr.erase(0, numStr.find_first_not_of(" \t"));
-                      int failed = std::stoi(numStr);
-                      if (failed > 0) state.failed = failed;
-                    } catch (...) {}
-                  }
-
-                  // "Done!" at end - but not the "[X/Y] ModName - Done!" lines
-                  if (line.find("Done!") != std::string::npos &&
-                      line.find(" - Done!") == std::string::npos) {
-                    state.phase = InstallPhase::Complete;
-                  }
-
-                  // Also detect "Please restart Mod Organizer 2" as completion
-                  if (line.find("restart Mod Organizer") != std::string::npos) {
-                    state.phase = InstallPhase::Complete;
-                  }
-
-                  // Detect error lines
-                  if (line.find("Error:") != std::string::npos ||
-                      line.find("ERROR:") != std::string::npos) {
-                    state.hasError = true;
-                  }
-
-                  state.addLog(line);
-                  screen.PostEvent(Event::Custom);
+                      state.skipped = std::stoi(numStr);
+                    }
+                  } catch (...) {}
                 }
-                pclose(pipe);
-              } else {
+
+                // "Failed: X" in summary
+                if (line.find("Failed:") != std::string::npos &&
+                    line.find("Downloaded:") == std::string::npos) {
+                  try {
+                    size_t pos = line.find("Failed:") + 7;
+                    std::string numStr = line.substr(pos);
+                    numStr.erase(0, numStr.find_first_not_of(" \t"));
+                    int failed = std::stoi(numStr);
+                    if (failed > 0) state.failed = failed;
+                  } catch (...) {}
+                }
+
+                // "Done!" at end - but not the "[X/Y] ModName - Done!" lines
+                if (line.find("Done!") != std::string::npos &&
+                    line.find(" - Done!") == std::string::npos) {
+                  state.phase = InstallPhase::Complete;
+                }
+
+                // Also detect "Please restart Mod Organizer 2" as completion
+                if (line.find("restart Mod Organizer") != std::string::npos) {
+                  state.phase = InstallPhase::Complete;
+                }
+
+                // Detect error lines
+                if (line.find("Error:") != std::string::npos ||
+                    line.find("ERROR:") != std::string::npos) {
+                  state.hasError = true;
+                }
+
+                state.addLog(line);
+                screen.PostEvent(Event::Custom);
+              };
+              Subprocess::Result run =
+                  Subprocess::run({nexusBridge, url, mo2, "--yes"}, runOptions);
+              if (!run.started) {
                 state.addLog("ERROR: Failed to start NexusBridge");
                 state.hasError = true;
               }